@@ -0,0 +1,104 @@
+/*
+ * Differential fuzz target of the JSON backends
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "fuzzRule.h"
+#include "southEventReader.h"
+
+using namespace systemspr;
+
+namespace {
+
+std::string describe(const EvalResult& result) {
+    return std::string(EvalDecisionName::toString(result.decision)) + " connx_status " +
+           std::to_string(static_cast<int>(result.connxStatus)) + " gi_status " +
+           std::to_string(static_cast<int>(result.giStatus)) + " asset " + std::to_string(result.assetIndex);
+}
+
+bool operator==(const EvalResult& a, const EvalResult& b) {
+    return a.decision == b.decision && a.connxStatus == b.connxStatus && a.giStatus == b.giStatus &&
+           a.assetIndex == b.assetIndex;
+}
+
+void fail(const char *what, const std::string& expected, const std::string& actual) {
+    fprintf(stderr, "%s\n--- expected\n%s\n--- actual\n%s\n", what, expected.c_str(), actual.c_str());
+    abort();
+}
+
+/*
+ * Rule instances of both backends, fed the same readings
+ */
+struct Rules {
+    RuleSystemSp *dom{nullptr};
+    RuleSystemSp *onDemand{nullptr};
+
+    void create() {
+        // Without the evaluation cache, which the instances would share
+        dom = createRule({{"json_backend", "rapidjson"}, {"eval_cache", "false"}});
+        onDemand = createRule({{"json_backend", "ondemand"}, {"eval_cache", "false"}});
+    }
+};
+};
+
+/*
+ * The input is a reading. The DOM of rapidjson is the reference:
+ *  - the structural index gives the same result with each of its kernels, on any input,
+ *  - the ondemand reader finds the same decision, statuses and asset as readDom on any input,
+ *    a parse error included,
+ *  - the rule instances of both backends fire, or not, with the same reason.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static Rules rules;
+    static StructuralIndex index;
+    if (rules.dom == nullptr) {
+        rules.create();
+    }
+    const std::vector<std::string>& trackedAssets = rules.dom->getConfigPlugin().getTrackedAssets();
+    std::string reading(reinterpret_cast<const char *>(data), size);
+
+    EvalResult onDemand;
+    bool first = true;
+    for (StructuralIndex::Kernel kernel : {StructuralIndex::Kernel::Scalar, StructuralIndex::Kernel::Sse2,
+                                           StructuralIndex::Kernel::Avx2}) {
+        if (!index.setKernel(kernel)) {
+            continue;
+        }
+        EvalResult result = SouthEventReader::readOnDemand(index, reading.data(), reading.size(), trackedAssets);
+        if (first) {
+            onDemand = result;
+            first = false;
+        }
+        else if (!(result == onDemand)) {
+            fail(StructuralIndex::getKernelName(kernel), describe(onDemand), describe(result));
+        }
+    }
+
+    EvalResult dom = SouthEventReader::readDom(reading.c_str(), trackedAssets);
+    if (!(onDemand == dom)) {
+        fail("ondemand reader", describe(dom), describe(onDemand));
+    }
+
+    bool domFired = rules.dom->evalRule(reading);
+    bool onDemandFired = rules.onDemand->evalRule(reading);
+    if (domFired != onDemandFired) {
+        fail("ondemand rule", domFired ? "fired" : "not fired", onDemandFired ? "fired" : "not fired");
+    }
+    if (domFired) {
+        std::string domReason = rules.dom->getReason();
+        std::string onDemandReason = rules.onDemand->getReason();
+        if (domReason != onDemandReason) {
+            fail("ondemand reason", domReason, onDemandReason);
+        }
+    }
+    return 0;
+}
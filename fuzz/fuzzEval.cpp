@@ -0,0 +1,36 @@
+/*
+ * Fuzz target of the evaluation of a reading by the rule
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "fuzzRule.h"
+
+using namespace systemspr;
+
+/*
+ * The input is a reading, evaluated by the instances of both JSON backends through the entry
+ * points of the plugin. The rapidjson instance goes through the evaluation cache, the ondemand
+ * one parses every reading under tighter payload limits. The instances keep their state from
+ * one input to the next, as in the notification service.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static RuleSystemSp *domRule = createRule({{"json_backend", "rapidjson"}});
+    static RuleSystemSp *onDemandRule = createRule({
+        {"json_backend", "ondemand"}, {"eval_cache", "false"}, {"max_depth", "16"}, {"max_members", "256"}
+    });
+
+    std::string reading(reinterpret_cast<const char *>(data), size);
+    for (RuleSystemSp *rule : {domRule, onDemandRule}) {
+        if (rule->evalRule(reading)) {
+            rule->getReason();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Fuzz target of the import of the exchanged_data
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compiledConfigFile.h"
+#include "configPlugin.h"
+
+using namespace systemspr;
+
+namespace {
+
+/*
+ * Exchanged data imported before the input by the incremental import
+ */
+const char *const Baseline = R"({"exchanged_data": {"datapoints": [
+    {"label": "TS-1", "pivot_id": "M_2367_3_15_4", "pivot_type": "SpsTyp", "pivot_subtypes": ["prt.inf"],
+     "protocols": [{"name": "IEC104", "typeid": "M_SP_NA_1", "address": "3271612"}]},
+    {"label": "TS-2", "pivot_id": "M_2367_3_15_5", "pivot_type": "DpsTyp", "pivot_subtypes": ["acces"],
+     "protocols": [{"name": "IEC104", "typeid": "M_DP_NA_1", "address": "3271613"}]}
+]}})";
+
+void fail(const char *check, const std::string& expected, const std::string& actual) {
+    fprintf(stderr, "%s differs from the import of the exchanged_data\n--- import\n%s--- %s\n%s", check,
+            expected.c_str(), check, actual.c_str());
+    abort();
+}
+
+void check(bool condition, const char *invariant) {
+    if (!condition) {
+        fprintf(stderr, "Invariant broken: %s\n", invariant);
+        abort();
+    }
+}
+
+/*
+ * Description of the compiled tables independent of the identifiers given to the datapoints,
+ * the protocols and the subtypes, after checking that the tables are consistent
+ */
+std::string describe(const ConfigPlugin::Compiled& compiled) {
+    std::vector<std::string> lines;
+    uint32_t prtInfCount = 0;
+    for (uint32_t id = 0; id < compiled.datapoints.size(); id++) {
+        const ConfigPlugin::Datapoint& datapoint = compiled.datapoints[id];
+        if (!datapoint.active) {
+            continue;
+        }
+        auto found = compiled.datapointIds.find(datapoint.pivotId);
+        check(found != compiled.datapointIds.end() && found->second == id, "datapointIds maps each active datapoint");
+        std::string line = "datapoint " + datapoint.pivotId + " | " + datapoint.label + " | " +
+                           std::to_string(datapoint.contentHash) + (datapoint.prtInf ? " | prt.inf" : "");
+        std::vector<std::string> subtypes;
+        for (uint32_t subtype = 0; subtype < compiled.subtypes.size(); subtype++) {
+            if (datapoint.subtypeMask & (1ULL << subtype)) {
+                subtypes.push_back(compiled.subtypes[subtype]);
+                const std::vector<uint32_t>& members = compiled.subtypeIndex[subtype];
+                check(std::binary_search(members.begin(), members.end(), id), "subtypeIndex holds each datapoint");
+            }
+        }
+        std::sort(subtypes.begin(), subtypes.end());
+        for (const std::string& subtype : subtypes) {
+            line += " | " + subtype;
+        }
+        lines.push_back(line + "\n");
+        prtInfCount += datapoint.prtInf ? 1 : 0;
+    }
+    check(compiled.datapointIds.size() == lines.size(), "datapointIds only maps active datapoints");
+    check(compiled.prtInfCount == prtInfCount, "prtInfCount counts the active prt.inf datapoints");
+    for (size_t i = 0; i < compiled.prtInfIndex.size(); i++) {
+        const ConfigPlugin::ProtocolPoint& point = compiled.prtInfIndex[i];
+        check(point.protocol < compiled.protocols.size() && point.datapoint < compiled.datapoints.size() &&
+              compiled.datapoints[point.datapoint].active && compiled.datapoints[point.datapoint].prtInf,
+              "prtInfIndex points to active prt.inf datapoints");
+        if (i > 0) {
+            const ConfigPlugin::ProtocolPoint& previous = compiled.prtInfIndex[i - 1];
+            check(previous.protocol < point.protocol ||
+                  (previous.protocol == point.protocol && previous.address <= point.address),
+                  "prtInfIndex is sorted by protocol and address");
+        }
+        lines.push_back("point " + compiled.protocols[point.protocol] + " | " + std::to_string(point.address) +
+                        " | " + compiled.datapoints[point.datapoint].pivotId + "\n");
+    }
+    std::sort(lines.begin(), lines.end());
+    std::string description;
+    for (const std::string& line : lines) {
+        description += line;
+    }
+    return description;
+}
+};
+
+/*
+ * The input is an exchanged_data. Its import into an empty configuration is the reference,
+ * which the fast paths of the import must reproduce:
+ *  - the incremental import, applying the input as changes to another exchanged_data,
+ *  - the binary cache of the compiled tables, written then loaded back.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static const std::string cachePath = std::string(P_tmpdir) + "/systemspr_fuzz_import_" +
+                                         std::to_string(getpid()) + ".bin";
+    const char *exchangedData = reinterpret_cast<const char *>(data);
+
+    // The reference is released before the incremental import, which would otherwise share it
+    std::string reference;
+    std::shared_ptr<const ConfigPlugin::Compiled> compiled;
+    {
+        ConfigPlugin configPlugin;
+        configPlugin.importExchangedData(exchangedData, size);
+        reference = describe(*configPlugin.getCompiled());
+        if (!configPlugin.getDatapoints().empty()) {
+            compiled = std::make_shared<ConfigPlugin::Compiled>(*configPlugin.getCompiled());
+        }
+    }
+
+    ConfigPlugin incremental;
+    incremental.importExchangedData(Baseline);
+    incremental.importExchangedData(exchangedData, size);
+    std::string actual = describe(*incremental.getCompiled());
+    if (actual != reference) {
+        fail("incremental import", reference, actual);
+    }
+
+    if (compiled) {
+        ConfigPlugin::Compiled loaded;
+        if (!CompiledConfigFile::write(cachePath, compiled->key, *compiled) ||
+            !CompiledConfigFile::read(cachePath, compiled->key, loaded)) {
+            fprintf(stderr, "Compiled tables not written or read back from %s\n", cachePath.c_str());
+            abort();
+        }
+        unlink(cachePath.c_str());
+        actual = describe(loaded);
+        if (actual != reference) {
+            fail("compiled file", reference, actual);
+        }
+    }
+    return 0;
+}
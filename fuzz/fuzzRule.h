@@ -0,0 +1,51 @@
+#ifndef FUZZ_FUZZ_RULE_H_
+#define FUZZ_FUZZ_RULE_H_
+
+/*
+ * Rule instances of the fuzz targets
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <map>
+#include <string>
+
+#include <config_category.h>
+#include <plugin_api.h>
+
+#include "ruleSystemSp.h"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+};
+
+/*
+ * Connections tracked besides the asset CONNECTION-1 of the default configuration, so that
+ * the readings of the seed corpus reach the south_event of several tracked assets
+ */
+static const char *const FuzzConnections = QUOTE({
+    "connections": [
+        {"asset": "LINK-1", "protocol": "IEC104"},
+        {"asset": "LINK \"A\"", "protocol": "IEC104"}
+    ]
+});
+
+/*
+ * Rule instance with the default configuration, then the given items
+ *
+ * @param items : configuration items and their values
+ */
+static systemspr::RuleSystemSp *createRule(const std::map<std::string, std::string>& items) {
+    ConfigCategory config("systemspr", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    config.setValue("connections", FuzzConnections);
+    for (const auto& item : items) {
+        config.setValue(item.first, item.second);
+    }
+    return static_cast<systemspr::RuleSystemSp *>(plugin_init(&config));
+}
+
+#endif  // FUZZ_FUZZ_RULE_H_
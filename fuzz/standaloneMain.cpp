@@ -0,0 +1,76 @@
+/*
+ * Driver of the fuzz targets when they are not linked with libFuzzer
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+
+bool runFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Cannot read %s\n", path.c_str());
+        return false;
+    }
+    std::vector<char> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+    return true;
+}
+};
+
+/*
+ * Run the target once on each file given, and on each file of the directories given, such as
+ * the seed corpus or the crashes found by libFuzzer
+ */
+int main(int argc, char *argv[]) {
+    uint64_t count = 0;
+    for (int i = 1; i < argc; i++) {
+        struct stat status;
+        if (stat(argv[i], &status) != 0) {
+            fprintf(stderr, "Cannot read %s\n", argv[i]);
+            return 1;
+        }
+        std::vector<std::string> paths;
+        if (S_ISDIR(status.st_mode)) {
+            DIR *dir = opendir(argv[i]);
+            if (dir == nullptr) {
+                fprintf(stderr, "Cannot read %s\n", argv[i]);
+                return 1;
+            }
+            while (struct dirent *entry = readdir(dir)) {
+                std::string path = std::string(argv[i]) + "/" + entry->d_name;
+                if (entry->d_name[0] != '.' && stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode)) {
+                    paths.push_back(path);
+                }
+            }
+            closedir(dir);
+            std::sort(paths.begin(), paths.end());
+        }
+        else {
+            paths.push_back(argv[i]);
+        }
+        for (const std::string& path : paths) {
+            if (!runFile(path)) {
+                return 1;
+            }
+            count++;
+        }
+    }
+    printf("%llu inputs run\n", static_cast<unsigned long long>(count));
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef INCLUDE_CAPTURE_FILE_H_
+#define INCLUDE_CAPTURE_FILE_H_
+
+/*
+ * Capture of the evaluated readings in a compressed file
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <zlib.h>
+
+namespace systemspr {
+
+/**
+ * Appends the readings to a gzip file of JSON lines, {"ts": <realtime ns>, "reading": "<reading>"}.
+ *
+ * Evaluations only copy the line into a pending buffer; a thread compresses and writes it, so
+ * that the evaluations never wait for the disk. When the thread falls behind by more than
+ * MaxPendingSize bytes, the readings are dropped and counted. Each opening of the file adds a
+ * gzip member, which the readers of concatenated gzip streams, such as gzip -d, read as one file.
+ */
+class CaptureWriter {
+public:
+    static constexpr size_t   MaxPendingSize = 16 * 1024 * 1024;
+    static constexpr uint32_t FlushPeriodMs  = 1000;
+
+    ~CaptureWriter() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_thread.joinable(); }
+    const std::string& getPath() const { return m_path; }
+
+    void append(uint64_t timestampNs, const std::string& reading);
+    uint64_t getDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static void formatLine(std::string& out, uint64_t timestampNs, const std::string& reading);
+
+private:
+    void m_run();
+
+    std::string             m_path;
+    gzFile                  m_file{nullptr};
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    std::string             m_pending;      // Lines not written yet, guarded by m_mutex
+    bool                    m_stop{false};
+    std::thread             m_thread;
+    std::atomic<uint64_t>   m_dropped{0};
+};
+
+/**
+ * Reads the records of a capture file, compressed or not.
+ */
+class CaptureReader {
+public:
+    struct Record {
+        uint64_t    timestampNs{0};
+        std::string reading;
+    };
+
+    ~CaptureReader() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    bool next(Record& record);
+    uint64_t getLineNumber() const { return m_lineNumber; }
+
+private:
+    gzFile      m_file{nullptr};
+    std::string m_line;
+    uint64_t    m_lineNumber{0};
+};
+};
+
+#endif  // INCLUDE_CAPTURE_FILE_H_
@@ -0,0 +1,83 @@
+#ifndef INCLUDE_COMPILED_CONFIG_FILE_H_
+#define INCLUDE_COMPILED_CONFIG_FILE_H_
+
+/*
+ * Binary cache of the compiled exchanged_data
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+#include <string>
+
+#include "configPlugin.h"
+
+namespace systemspr {
+
+/**
+ * File holding the datapoint table, the protocols, the prt.inf index and the subtypes imported from an exchanged_data,
+ * keyed by the hash of the exchanged_data.
+ *
+ * All the references inside the file are offsets from its start, so the file is loaded with a single
+ * mmap and no JSON parsing. A checksum of the content detects truncated or corrupted files.
+ * The tables are not used in place: they are copied into the vectors of ConfigPlugin::Compiled, which
+ * the reconfigurations modify, and the pivot_id index is rebuilt, so only the parsing is saved. The point sets
+ * of the connections are not part of the file: they are resolved from the connections configuration into ranges
+ * of the prt.inf index.
+ */
+class CompiledConfigFile {
+public:
+    static constexpr uint32_t Magic        = 0x43505353;  // "SSPC"
+    static constexpr uint16_t Version      = 2;
+    static constexpr size_t   MaxFiles     = 8;           // Files kept in the cache directory
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint64_t key;                 // Hash of the exchanged_data
+        uint64_t checksum;            // Hash of everything after the header
+        uint64_t fileSize;
+        uint32_t datapointCount;
+        uint32_t protocolCount;
+        uint32_t pointCount;
+        uint32_t stringPoolSize;
+        uint32_t datapointOffset;
+        uint32_t protocolOffset;
+        uint32_t pointOffset;
+        uint32_t stringPoolOffset;
+        uint32_t subtypeCount;
+        uint32_t subtypeOffset;
+    };
+
+    struct StringRef {
+        uint32_t offset;              // From the start of the string pool
+        uint32_t length;
+    };
+
+    struct DatapointRecord {
+        uint64_t  contentHash;
+        uint64_t  subtypeMask;
+        StringRef pivotId;
+        StringRef label;
+        uint8_t   prtInf;
+        uint8_t   active;
+        uint8_t   reserved[6];
+    };
+
+    struct PointRecord {
+        uint32_t protocol;
+        uint32_t datapoint;
+        uint64_t address;
+    };
+
+    static std::string getPath(const std::string& dir, uint64_t key);
+    static bool write(const std::string& path, uint64_t key, const ConfigPlugin::Compiled& compiled);
+    static bool read(const std::string& path, uint64_t key, ConfigPlugin::Compiled& compiled);
+    static void prune(const std::string& dir);
+};
+};
+
+#endif  // INCLUDE_COMPILED_CONFIG_FILE_H_
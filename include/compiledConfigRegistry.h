@@ -0,0 +1,43 @@
+#ifndef INCLUDE_COMPILED_CONFIG_REGISTRY_H_
+#define INCLUDE_COMPILED_CONFIG_REGISTRY_H_
+
+/*
+ * Compiled exchanged_data shared by the rule instances of the process
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "configPlugin.h"
+
+namespace systemspr {
+
+/**
+ * Registry of the compiled exchanged_data, keyed by the hash of the exchanged_data.
+ *
+ * The registry only holds weak references: a compiled exchanged_data is freed when the last
+ * rule instance using it is reconfigured or destroyed.
+ */
+class CompiledConfigRegistry {
+public:
+    using CompiledPtr = std::shared_ptr<const ConfigPlugin::Compiled>;
+
+    CompiledPtr find(uint64_t key);
+    CompiledPtr publish(const CompiledPtr& compiled);
+    size_t size();
+
+    static CompiledConfigRegistry& getInstance();
+
+private:
+    std::mutex                                                             m_mutex;
+    std::unordered_map<uint64_t, std::weak_ptr<const ConfigPlugin::Compiled>> m_compiled;
+};
+};
+
+#endif  // INCLUDE_COMPILED_CONFIG_REGISTRY_H_
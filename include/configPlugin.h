@@ -11,26 +11,169 @@
  * Author: Yannick Marchetaux
  * 
  */
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
+#include <unordered_map>
 
 #include <rapidjson/document.h>
 
 namespace systemspr {
 
 class ConfigPlugin {
-public:  
-    void importExchangedData(const std::string & exchangeConfig);
+public:
+    /**
+     * TS datapoint of exchanged_data
+     */
+    struct Datapoint {
+        std::string pivotId;
+        std::string label;
+        uint64_t    contentHash{0};     // Structural hash of the JSON definition
+        uint64_t    subtypeMask{0};     // Bit i set if the datapoint has the subtype i of Compiled::subtypes
+        bool        prtInf{false};
+        bool        active{true};       // Slot of a removed datapoint, reused by the next addition
+    };
+
+    /**
+     * Changes of the datapoints applied by the last importExchangedData
+     */
+    struct Delta {
+        uint32_t added{0};
+        uint32_t removed{0};
+        uint32_t changed{0};
+        uint32_t unchanged{0};
+    };
+
+    /**
+     * Protocol address of a prt.inf datapoint. Addresses which are not numbers are stored
+     * as NonNumericAddress and only reached by connections covering the whole protocol.
+     */
+    struct ProtocolPoint {
+        uint32_t protocol;
+        uint32_t datapoint;
+        uint64_t address;
+    };
+
+    /**
+     * Range [begin, end) of the prt.inf protocol index
+     */
+    struct IndexRange {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    /**
+     * Connection asset with the prt.inf datapoints reachable through it
+     */
+    struct Connection {
+        std::string             asset;
+        std::string             protocol;
+        std::vector<IndexRange> ranges;
+    };
+
+    /**
+     * Tables compiled from an exchanged_data. Once published in the CompiledConfigRegistry
+     * they are never modified, and shared by all the instances importing the same exchanged_data.
+     * A reconfiguration copies them whole before applying its changes, so its cost follows the size
+     * of the tables: only the import of the unchanged datapoints and the sort of the index are saved.
+     */
+    struct Compiled {
+        uint64_t                                  key{0};          // Hash of the exchanged_data
+        std::vector<Datapoint>                    datapoints;
+        std::unordered_map<std::string, uint32_t> datapointIds;    // pivot_id to index of the active datapoints
+        std::vector<uint32_t>                     freeDatapoints;
+        uint32_t                                  prtInfCount{0};
+        std::vector<std::string>                  protocols;
+        std::vector<ProtocolPoint>                prtInfIndex;
+        std::vector<std::string>                  subtypes;        // Interned pivot_subtypes
+        std::unordered_map<std::string, uint32_t> subtypeIds;
+        std::vector<std::vector<uint32_t>>        subtypeIndex;    // Sorted active datapoints of each subtype
+    };
+
+    static constexpr uint64_t NonNumericAddress = UINT64_MAX;
+    static constexpr uint32_t NoDatapoint       = UINT32_MAX;
+    static constexpr uint32_t NoSubtype         = UINT32_MAX;
+    static constexpr uint32_t MaxSubtypes       = 64;
+
+    ConfigPlugin();
+
+    bool importExchangedData(const std::string & exchangeConfig);
+    bool importExchangedData(const char *exchangeConfig, size_t length);
+    bool importExchangedDataFile(const std::string& path);
     void importAsset(const std::string & assetConfig);
+    void importConnections(const std::string & connectionsConfig);
+    void importTopology(const std::string & topologyConfig);
+    void setCompiledCacheDir(const std::string& dir) { m_compiledCacheDir = dir; }
+    bool isLoadedFromCache() const { return m_loadedFromCache; }
     bool hasConnectionLossTracking() const { return m_connectionLossTracking; }
     const std::string& getTrackedAsset() const { return m_trackedAsset; }
-    
+    const std::vector<std::string>& getTrackedAssets() const { return m_trackedAssets; }
+    uint64_t getFingerprint() const { return m_fingerprint; }
+
+    const std::shared_ptr<const Compiled>& getCompiled() const { return m_compiled; }
+    const std::vector<Datapoint>& getDatapoints() const { return m_compiled->datapoints; }
+    uint32_t findDatapoint(const std::string& pivotId) const;
+    size_t getDatapointCount() const { return m_compiled->datapointIds.size(); }
+    const Delta& getLastDelta() const { return m_lastDelta; }
+    const std::vector<std::string>& getProtocols() const { return m_compiled->protocols; }
+    const std::vector<ProtocolPoint>& getPrtInfIndex() const { return m_compiled->prtInfIndex; }
+    const std::vector<std::string>& getSubtypes() const { return m_compiled->subtypes; }
+    uint32_t findSubtype(const std::string& subtype) const;
+    const std::vector<uint32_t>& getSubtypeDatapoints(uint32_t subtypeId) const;
+    const std::vector<uint32_t>& getSubtypeDatapoints(const std::string& subtype) const {
+        return getSubtypeDatapoints(findSubtype(subtype));
+    }
+    bool hasSubtype(uint32_t datapointId, uint32_t subtypeId) const {
+        return datapointId < m_compiled->datapoints.size() && subtypeId < MaxSubtypes &&
+               (m_compiled->datapoints[datapointId].subtypeMask >> subtypeId & 1) != 0;
+    }
+    static void buildSubtypeIndex(Compiled& compiled);
+    const std::vector<Connection>& getConnections() const { return m_connections; }
+    const Connection* findConnection(const std::string& asset) const;
+    std::vector<uint32_t> getConnectionDatapoints(const Connection& connection) const;
+    IndexRange getDescendantRange(uint32_t assetIndex) const {
+        return assetIndex < m_descendantRanges.size() ? m_descendantRanges[assetIndex] : IndexRange{0, 0};
+    }
+    const std::vector<uint32_t>& getDescendants() const { return m_descendants; }
+
 private:
-    bool m_importDatapoint(const rapidjson::Value& datapoint);
+    bool m_importExchangedData(const char *exchangeConfig, size_t length, bool keepOnError);
+    bool m_rejectExchangedData(bool keepOnError);
+    bool m_importDatapoint(const rapidjson::Value& datapoint, Compiled& compiled, Datapoint& entry,
+                           std::vector<ProtocolPoint>& points);
+    void m_clearDatapoints();
+    void m_attachCompiled(const std::shared_ptr<const Compiled>& compiled, bool computeDelta);
+    void m_applyDatapoint(Compiled& compiled, Datapoint&& entry, std::vector<ProtocolPoint>& points,
+                          std::vector<char>& seen, std::vector<uint32_t>& stale, std::vector<ProtocolPoint>& inserted);
+    static void m_updateIndex(Compiled& compiled, const std::vector<uint32_t>& stale, std::vector<ProtocolPoint>& inserted);
+    static uint32_t m_internProtocol(Compiled& compiled, const std::string& name);
+    static uint32_t m_internSubtype(Compiled& compiled, const std::string& name);
+    void m_compileConnections();
+    void m_updateTrackedAssets();
+    void m_compileTopology();
+    void m_updateFingerprint();
+
+    struct ConnectionDefinition {
+        std::string                                asset;
+        std::string                                protocol;
+        std::vector<std::pair<uint64_t, uint64_t>> addressRanges;   // Empty for the whole protocol
+    };
 
     bool        m_connectionLossTracking{false};
     std::string m_trackedAsset;
+    uint64_t    m_fingerprint{0};
+
+    std::shared_ptr<const Compiled>   m_compiled;
+    Delta                             m_lastDelta;
+    std::string                       m_compiledCacheDir;
+    bool                              m_loadedFromCache{false};
+    std::vector<ConnectionDefinition> m_connectionDefinitions;
+    std::vector<Connection>           m_connections;
+    std::vector<std::string>          m_trackedAssets;
+    std::vector<std::pair<std::string, std::string>> m_topologyEdges;    // Parent and child assets
+    std::vector<IndexRange>           m_descendantRanges;   // Parallel to m_trackedAssets, ranges of m_descendants
+    std::vector<uint32_t>             m_descendants;        // Indexes in m_trackedAssets
 };
 };
 
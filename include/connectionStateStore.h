@@ -0,0 +1,102 @@
+#ifndef INCLUDE_CONNECTION_STATE_STORE_H_
+#define INCLUDE_CONNECTION_STATE_STORE_H_
+
+/*
+ * Persistent connection state of the tracked assets
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "southEvent.h"
+
+namespace systemspr {
+
+/**
+ * Fixed layout table of connection states, memory-mapped from a file of the Fledge data directory.
+ *
+ * The file is a header followed by Capacity entries addressed by a hash of the asset name,
+ * so reloading it after a restart is a single mmap whatever the number of assets.
+ * The rule instances of the process update an entry in turn, under a lock of the entry kept
+ * out of the file, so a crash never leaves an entry locked. The mapping is flushed every
+ * SyncInterval updates.
+ *
+ * An entry also records whether its loss is notified, so that a rule restarted over the file does
+ * not notify again a loss reported before the restart, and still notifies one that was held by the
+ * aggregation at shutdown.
+ */
+class ConnectionStateStore {
+public:
+    static constexpr uint32_t Magic          = 0x53505353;  // "SSPS"
+    static constexpr uint16_t Version        = 2;
+    static constexpr uint32_t Capacity       = 1024;
+    static constexpr size_t   MaxAssetLength = 79;
+    static constexpr uint32_t SyncInterval   = 256;
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t entrySize;
+        uint32_t capacity;
+        uint32_t count;
+        uint8_t  reserved[48];
+    };
+
+    struct Entry {
+        uint64_t              assetHash;      // 0 when the slot is free
+        char                  asset[MaxAssetLength + 1];
+        std::atomic<uint64_t> updatedNs;      // Realtime of the last status change
+        std::atomic<uint32_t> lossCount;
+        std::atomic<uint8_t>  connxStatus;    // Last ConnxStatus received
+        std::atomic<uint8_t>  giStatus;       // Last GiStatus received
+        std::atomic<uint8_t>  linkState;      // LinkState
+        std::atomic<uint8_t>  lossNotified;   // Set once the loss is notified, reset by the next change of linkState
+        uint8_t               reserved[24];
+
+        LinkState getLinkState() const { return static_cast<LinkState>(linkState.load(std::memory_order_relaxed)); }
+        bool isLossNotified() const { return lossNotified.load(std::memory_order_relaxed) != 0; }
+    };
+
+    ConnectionStateStore() = default;
+    ConnectionStateStore(const ConnectionStateStore&) = delete;
+    ConnectionStateStore& operator=(const ConnectionStateStore&) = delete;
+    ~ConnectionStateStore();
+
+    bool open(const std::string& path);
+    void close();
+    void sync();
+    bool isOpen() const { return m_header != nullptr; }
+    uint32_t size() const { return m_header ? m_header->count : 0; }
+
+    Entry* acquire(const std::string& asset);
+    const Entry* find(const std::string& asset) const;
+    LinkState update(Entry* entry, ConnxStatus connx, GiStatus gi, uint64_t nowNs);
+    void setLossNotified(Entry* entry);
+
+    static ConnectionStateStore& getInstance();
+
+private:
+    static uint64_t m_hashAsset(const std::string& asset);
+    static bool m_matches(const Entry& entry, uint64_t hash, const std::string& asset);
+    void m_initialize();
+
+    mutable std::mutex    m_mutex;
+    std::mutex            m_entryMutexes[Capacity];   // Parallel to m_entries
+    void                 *m_mapping{nullptr};
+    size_t                m_mappingSize{0};
+    Header               *m_header{nullptr};
+    Entry                *m_entries{nullptr};
+    std::atomic<uint32_t> m_pendingUpdates{0};
+};
+
+static_assert(sizeof(ConnectionStateStore::Header) == 64, "Connection state header layout changed");
+static_assert(sizeof(ConnectionStateStore::Entry) == 128, "Connection state entry layout changed");
+};
+
+#endif  // INCLUDE_CONNECTION_STATE_STORE_H_
@@ -17,7 +17,20 @@ namespace ConstantsSystem {
     constexpr const char *JsonPivotType               = "pivot_type";
     constexpr const char *JsonPivotId                 = "pivot_id";
     constexpr const char *JsonPivotSubtypes           = "pivot_subtypes";
+    constexpr const char *JsonPrtInf                  = "prt.inf";
     constexpr const char *JsonTsSystCycle             = "ts_syst_cycle";
+    constexpr const char *JsonProtocols               = "protocols";
+    constexpr const char *JsonProtocolName            = "name";
+    constexpr const char *JsonProtocolAddress         = "address";
+    constexpr const char *JsonConnections             = "connections";
+    constexpr const char *JsonConnectionAsset         = "asset";
+    constexpr const char *JsonConnectionProtocol      = "protocol";
+    constexpr const char *JsonAddressRanges           = "address_ranges";
+    constexpr const char *JsonRangeFrom               = "from";
+    constexpr const char *JsonRangeTo                 = "to";
+    constexpr const char *JsonTopology                = "topology";
+    constexpr const char *JsonTopologyParent          = "parent";
+    constexpr const char *JsonTopologyChildren        = "children";
 
     static const std::string JsonCdcSps     = "SpsTyp";
     static const std::string JsonCdcDps     = "DpsTyp";
@@ -0,0 +1,74 @@
+#ifndef INCLUDE_DECISION_TRACE_H_
+#define INCLUDE_DECISION_TRACE_H_
+
+/*
+ * In-memory trace of the evaluation decisions
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "evalDecision.h"
+
+namespace systemspr {
+
+/**
+ * Per-thread rings of the last evaluation decisions.
+ *
+ * Each evaluating thread owns a ring it writes without lock, the ring of a thread that exits
+ * is handed over to the next new thread. Snapshots read every ring and drop the entries
+ * overwritten while they were copied.
+ */
+class DecisionTrace {
+public:
+    static constexpr uint32_t RingSize = 1024;  // Power of 2
+    static constexpr uint32_t MaxRings = 64;
+
+    struct Event {
+        uint64_t     timestampNs;
+        uint32_t     threadId;
+        uint32_t     payloadSize;
+        EvalDecision decision;
+    };
+
+    static void record(EvalDecision decision, uint32_t payloadSize, uint64_t timestampNs);
+    static std::vector<Event> snapshot();
+    static bool dumpToFile(const std::string& path);
+    static std::string getDefaultDumpPath();
+
+    /**
+     * Subscription of a rule instance to the dump of the trace when a signal is received. The first
+     * subscription installs the handler and starts the thread writing the dumps, the last one stops
+     * the thread and restores the action the signal had before.
+     */
+    class SignalDump {
+    public:
+        SignalDump() = default;
+        SignalDump(const SignalDump&) = delete;
+        SignalDump& operator=(const SignalDump&) = delete;
+        ~SignalDump() { set(0); }
+
+        bool set(int signalNumber);
+        int getSignal() const { return m_signalNumber; }
+
+    private:
+        int m_signalNumber{0};
+    };
+
+private:
+    static bool m_subscribeSignal(int signalNumber);
+    static void m_unsubscribeSignal();
+    static void m_signalHandler(int signalNumber);
+    static void m_runDump(int readFd);
+
+    static std::atomic<int> m_dumpPipe;   // Write end of the pipe waking up the dump thread, -1 when unused
+};
+};
+
+#endif  // INCLUDE_DECISION_TRACE_H_
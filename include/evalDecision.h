@@ -0,0 +1,71 @@
+#ifndef INCLUDE_EVAL_DECISION_H_
+#define INCLUDE_EVAL_DECISION_H_
+
+/*
+ * Outcome of the evaluation of a reading by the rule
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+
+#include "southEvent.h"
+
+namespace systemspr {
+
+/**
+ * Branch taken by the evaluation of a reading
+ */
+enum class EvalDecision : uint8_t {
+    Disabled = 0,           // Plugin disabled
+    NoTracking,             // No prt.inf datapoint or no asset to track
+    ParseError,             // Reading is not valid JSON
+    PayloadRejected,        // Reading above the size, depth or member limits
+    NotAnObject,            // Root of the reading is not an object
+    WrongAsset,             // Reading does not contain the tracked asset
+    ReadingNotAnObject,     // Tracked asset is not an object
+    NoSouthEvent,           // Tracked asset has no south_event
+    SouthEventNotAnObject,  // south_event is not an object
+    NoStatusMatch,          // south_event without connection loss nor GI completion
+    FiredConnectionLost,    // Notification for connx_status "not connected"
+    FiredGiFinished,        // Notification for gi_status "finished"
+    Count
+};
+
+/**
+ * Decision and statuses extracted from a reading
+ */
+struct EvalResult {
+    EvalDecision decision{EvalDecision::Disabled};
+    ConnxStatus  connxStatus{ConnxStatus::None};
+    GiStatus     giStatus{GiStatus::None};
+    uint32_t     assetIndex{0};     // Index of the evaluated asset in ConfigPlugin::getTrackedAssets
+
+    bool isSouthEvent() const { return decision >= EvalDecision::NoStatusMatch && decision < EvalDecision::Count; }
+    bool isFired() const { return decision == EvalDecision::FiredConnectionLost || decision == EvalDecision::FiredGiFinished; }
+};
+
+namespace EvalDecisionName {
+    inline const char *toString(EvalDecision decision) {
+        switch (decision) {
+            case EvalDecision::Disabled:              return "disabled";
+            case EvalDecision::NoTracking:            return "no_tracking";
+            case EvalDecision::ParseError:            return "parse_error";
+            case EvalDecision::PayloadRejected:       return "payload_rejected";
+            case EvalDecision::NotAnObject:           return "not_an_object";
+            case EvalDecision::WrongAsset:            return "wrong_asset";
+            case EvalDecision::ReadingNotAnObject:    return "reading_not_an_object";
+            case EvalDecision::NoSouthEvent:          return "no_south_event";
+            case EvalDecision::SouthEventNotAnObject: return "south_event_not_an_object";
+            case EvalDecision::NoStatusMatch:         return "no_status_match";
+            case EvalDecision::FiredConnectionLost:   return "fired_connection_lost";
+            case EvalDecision::FiredGiFinished:       return "fired_gi_finished";
+            default:                                  return "unknown";
+        }
+    }
+};
+};
+
+#endif  // INCLUDE_EVAL_DECISION_H_
@@ -0,0 +1,68 @@
+#ifndef INCLUDE_EVALUATION_CACHE_H_
+#define INCLUDE_EVALUATION_CACHE_H_
+
+/*
+ * Process-wide cache of the evaluation results
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "evalDecision.h"
+
+namespace systemspr {
+
+/**
+ * Results of the evaluations keyed by the hash and size of the reading and the fingerprint
+ * of the configuration which evaluated it.
+ *
+ * The rule instances of a notification service evaluating the same reading, or a south service
+ * resending the same status, only parse it once. The cache is split in Stripes independent
+ * direct-mapped tables, each one protected by its own mutex.
+ */
+class EvaluationCache {
+public:
+    static constexpr uint32_t Stripes        = 16;
+    static constexpr uint32_t SlotsPerStripe = 64;
+
+    bool lookup(uint64_t payloadHash, uint32_t payloadSize, uint64_t fingerprint, EvalResult& result);
+    void store(uint64_t payloadHash, uint32_t payloadSize, uint64_t fingerprint, const EvalResult& result);
+    void clear();
+
+    uint64_t getHits() const { return m_hits.load(std::memory_order_relaxed); }
+    uint64_t getMisses() const { return m_misses.load(std::memory_order_relaxed); }
+
+    static EvaluationCache& getInstance();
+
+private:
+    struct Slot {
+        uint64_t   payloadHash{0};
+        uint64_t   fingerprint{0};
+        uint32_t   payloadSize{0};
+        bool       valid{false};
+        EvalResult result;
+    };
+
+    struct alignas(64) Stripe {
+        std::mutex                           mutex;
+        std::array<Slot, SlotsPerStripe>     slots;
+    };
+
+    static uint64_t m_mix(uint64_t payloadHash, uint64_t fingerprint) {
+        uint64_t key = payloadHash ^ (fingerprint * 0x9E3779B97F4A7C15ULL);
+        return key ^ (key >> 29);
+    }
+
+    std::array<Stripe, Stripes> m_stripes;
+    std::atomic<uint64_t>       m_hits{0};
+    std::atomic<uint64_t>       m_misses{0};
+};
+};
+
+#endif  // INCLUDE_EVALUATION_CACHE_H_
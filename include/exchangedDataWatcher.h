@@ -0,0 +1,51 @@
+#ifndef INCLUDE_EXCHANGED_DATA_WATCHER_H_
+#define INCLUDE_EXCHANGED_DATA_WATCHER_H_
+
+/*
+ * Watch of the exchanged_data file
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace systemspr {
+
+/**
+ * Thread calling a function when a file is modified, using inotify.
+ *
+ * The directory of the file is watched, so that a file replaced by a rename is also detected.
+ * The function is called once the file has not been modified for the debounce delay, so that
+ * a file written in several steps is only reloaded once.
+ */
+class ExchangedDataWatcher {
+public:
+    static constexpr uint32_t DefaultDebounceMs = 500;
+
+    ~ExchangedDataWatcher() { stop(); }
+
+    bool start(const std::string& path, uint32_t debounceMs, std::function<void()> onChange);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+    const std::string& getPath() const { return m_path; }
+
+private:
+    void m_run();
+    bool m_readEvents();
+
+    std::string           m_path;
+    std::string           m_fileName;
+    uint32_t              m_debounceMs{DefaultDebounceMs};
+    std::function<void()> m_onChange;
+    int                   m_inotifyFd{-1};
+    int                   m_stopFd{-1};
+    std::thread           m_thread;
+};
+};
+
+#endif  // INCLUDE_EXCHANGED_DATA_WATCHER_H_
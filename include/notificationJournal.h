@@ -0,0 +1,116 @@
+#ifndef INCLUDE_NOTIFICATION_JOURNAL_H_
+#define INCLUDE_NOTIFICATION_JOURNAL_H_
+
+/*
+ * Binary journal of the evaluated south_event
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "southEvent.h"
+
+namespace systemspr {
+
+/**
+ * Ring of fixed-size records memory-mapped from a file.
+ *
+ * Writers reserve a slot with an atomic increment of the write index and publish it by storing
+ * the record sequence last, so appending a record never makes a system call. The fields of a
+ * record are relaxed atomics and a reader checks the sequence before and after its copy, so it
+ * never returns a record being overwritten.
+ * Asset names are stored once in a table of the file and records only carry their index.
+ *
+ * The journal is shared by the rule instances of the process, its capacity is the one of the
+ * instance which opened it.
+ */
+class NotificationJournal {
+public:
+    static constexpr uint32_t Magic           = 0x4A505353;  // "SSPJ"
+    static constexpr uint16_t Version         = 2;
+    static constexpr uint32_t MaxAssets       = 256;
+    static constexpr size_t   MaxAssetLength  = 63;
+    static constexpr uint32_t DefaultCapacity = 65536;
+    static constexpr uint32_t NoAsset         = 0xFFFFFFFF;
+
+    struct Header {
+        uint32_t              magic;
+        uint16_t              version;
+        uint16_t              recordSize;
+        uint32_t              capacity;
+        uint32_t              assetCount;
+        std::atomic<uint64_t> writeIndex;     // Number of records ever written
+        uint8_t               reserved[40];
+    };
+
+    struct AssetName {
+        char name[MaxAssetLength + 1];
+    };
+
+    struct Record {
+        std::atomic<uint64_t> timestampNs;    // Realtime of the evaluation
+        std::atomic<uint64_t> payloadHash;    // XXH64 of the evaluated JSON
+        std::atomic<uint32_t> assetId;        // Index in the asset table
+        std::atomic<uint32_t> payloadSize;
+        std::atomic<uint8_t>  verdict;        // Of the reading, before the aggregation
+        std::atomic<uint8_t>  connxStatus;    // ConnxStatus
+        std::atomic<uint8_t>  giStatus;       // GiStatus
+        uint8_t               reserved;
+        std::atomic<uint32_t> sequence;       // Low bits of write index + 1, stored last
+    };
+
+    /**
+     * Decoded copy of a record
+     */
+    struct Event {
+        uint64_t    index;
+        uint64_t    timestampNs;
+        uint64_t    payloadHash;
+        uint32_t    assetId;
+        uint32_t    payloadSize;
+        bool        verdict;
+        ConnxStatus connxStatus;
+        GiStatus    giStatus;
+    };
+
+    NotificationJournal() = default;
+    NotificationJournal(const NotificationJournal&) = delete;
+    NotificationJournal& operator=(const NotificationJournal&) = delete;
+    ~NotificationJournal();
+
+    bool open(const std::string& path, uint32_t capacity, bool readOnly = false);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    uint32_t registerAsset(const std::string& asset);
+    void append(uint32_t assetId, bool verdict, ConnxStatus connx, GiStatus gi,
+                uint64_t payloadHash, uint32_t payloadSize, uint64_t timestampNs);
+
+    const Header* getHeader() const { return m_header; }
+    const AssetName* getAssets() const { return m_assets; }
+    bool readEvent(uint64_t index, Event& event) const;
+
+    static NotificationJournal& getInstance();
+
+private:
+    void m_initialize(uint32_t capacity);
+
+    std::mutex   m_mutex;
+    void        *m_mapping{nullptr};
+    size_t       m_mappingSize{0};
+    Header      *m_header{nullptr};
+    AssetName   *m_assets{nullptr};
+    Record      *m_records{nullptr};
+};
+
+static_assert(sizeof(NotificationJournal::Header) == 64, "Journal header layout changed");
+static_assert(sizeof(NotificationJournal::Record) == 32, "Journal record layout changed");
+};
+
+#endif  // INCLUDE_NOTIFICATION_JOURNAL_H_
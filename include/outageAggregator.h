@@ -0,0 +1,44 @@
+#ifndef INCLUDE_OUTAGE_AGGREGATOR_H_
+#define INCLUDE_OUTAGE_AGGREGATOR_H_
+
+/*
+ * Aggregation of the connection losses received within a window
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace systemspr {
+
+/**
+ * Set of the tracked assets which lost their connection since the start of the current window.
+ *
+ * The set is sized for all the tracked assets when it is configured, so adding an asset
+ * during a burst of losses never allocates.
+ */
+class OutageAggregator {
+public:
+    void configure(uint32_t assetCount, uint64_t windowNs);
+    bool isEnabled() const { return m_windowNs > 0; }
+    bool isPending(uint32_t assetIndex) const { return assetIndex < m_pending.size() && m_pending[assetIndex]; }
+    size_t getPendingCount() const { return m_order.size(); }
+
+    bool add(uint32_t assetIndex, uint64_t nowNs);
+    bool remove(uint32_t assetIndex);
+    bool isDue(uint64_t nowNs) const { return !m_order.empty() && nowNs - m_windowStartNs >= m_windowNs; }
+    void take(std::vector<uint32_t>& assets);
+
+private:
+    uint64_t              m_windowNs{0};
+    uint64_t              m_windowStartNs{0};
+    std::vector<uint8_t>  m_pending;    // Indexed by asset, 1 when the asset is in m_order
+    std::vector<uint32_t> m_order;      // Pending assets in order of arrival
+};
+};
+
+#endif  // INCLUDE_OUTAGE_AGGREGATOR_H_
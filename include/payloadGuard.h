@@ -0,0 +1,58 @@
+#ifndef INCLUDE_PAYLOAD_GUARD_H_
+#define INCLUDE_PAYLOAD_GUARD_H_
+
+/*
+ * Limits of the size and of the structure of the readings
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+
+namespace systemspr {
+
+/**
+ * Rejection of the readings too large or too complex to be parsed in a bounded time.
+ *
+ * The structure is checked by a single pass over the reading, which stops as soon as a limit
+ * is crossed, before any parsing. It does not check the syntax, left to the parser.
+ */
+class PayloadGuard {
+public:
+    enum class Verdict : uint8_t {
+        Accepted,
+        TooLarge,           // More than maxSize bytes
+        TooDeep,            // Objects and arrays nested more than maxDepth times
+        TooManyMembers      // More than maxMembers object members and array elements in total
+    };
+
+    /**
+     * Limits of the readings, 0 for no limit
+     */
+    struct Limits {
+        uint64_t maxSize{0};
+        uint32_t maxDepth{0};
+        uint32_t maxMembers{0};
+    };
+
+    void configure(const Limits& limits);
+    const Limits& getLimits() const { return m_limits; }
+    uint64_t getKey() const { return m_key; }
+
+    Verdict checkSize(size_t length) const {
+        return m_limits.maxSize > 0 && length > m_limits.maxSize ? Verdict::TooLarge : Verdict::Accepted;
+    }
+    Verdict check(const char *data, size_t length) const;
+
+    static const char *toString(Verdict verdict);
+
+private:
+    Limits   m_limits;
+    uint64_t m_key{0};      // Hash of the limits, part of the key of the cached evaluations
+};
+};
+
+#endif  // INCLUDE_PAYLOAD_GUARD_H_
@@ -0,0 +1,91 @@
+#ifndef INCLUDE_REASON_TEMPLATE_H_
+#define INCLUDE_REASON_TEMPLATE_H_
+
+/*
+ * Template of the reason of the notifications
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace systemspr {
+
+/**
+ * Reason template with named placeholders, such as <asset> or <pivot_ids>, compiled into a list of
+ * literal and slot segments. Rendering appends the segments in order, the values of the slots are
+ * written by a function of the caller.
+ *
+ * The string slots are written escaped, without quotes, the array slots as JSON arrays.
+ */
+class ReasonTemplate {
+public:
+    enum class Slot : uint8_t {
+        Literal,
+        Asset,          // Status of the notification, connx_status or gi_status
+        Reason,         // not connected or finished
+        FiredAsset,     // Tracked asset of the notification
+        Connection,     // Connection asset of the notification, empty if none
+        Timestamp,      // Time of the notification, UTC
+        Assets,         // Array of the lost assets
+        ImpliedAssets,  // Array of the descendants of the lost assets in the topology
+        PivotIds,       // Array of the pivot_id of the prt.inf datapoints reachable through the lost assets
+        SiteDown,       // true or false
+        Details,        // Members of the default reason after asset and reason
+        Count
+    };
+
+    struct Segment {
+        Slot     slot;
+        uint32_t offset;    // Literal: range of the literal text
+        uint32_t length;
+    };
+
+    static const char *const Default;
+
+    ReasonTemplate() { compile(Default); }
+
+    bool compile(const std::string& text);
+    const std::string& getText() const { return m_text; }
+    const std::vector<Segment>& getSegments() const { return m_segments; }
+    bool uses(Slot slot) const { return (m_usedSlots >> static_cast<uint32_t>(slot) & 1) != 0; }
+
+    static const char *slotName(Slot slot);
+
+    /**
+     * Append the rendered template to a buffer
+     *
+     * @param out : buffer receiving the reason
+     * @param appendSlot : function (std::string& out, Slot slot) appending the value of a slot
+     */
+    template <typename AppendSlot>
+    void render(std::string& out, AppendSlot&& appendSlot) const {
+        m_render(m_literals, m_segments, out, appendSlot);
+    }
+
+private:
+    template <typename AppendSlot>
+    static void m_render(const std::string& literals, const std::vector<Segment>& segments, std::string& out,
+                         AppendSlot& appendSlot) {
+        for (const Segment& segment : segments) {
+            if (segment.slot == Slot::Literal) {
+                out.append(literals, segment.offset, segment.length);
+            }
+            else {
+                appendSlot(out, segment.slot);
+            }
+        }
+    }
+
+    std::string          m_text;
+    std::string          m_literals;
+    std::vector<Segment> m_segments;
+    uint32_t             m_usedSlots{0};
+};
+};
+
+#endif  // INCLUDE_REASON_TEMPLATE_H_
@@ -0,0 +1,64 @@
+#ifndef INCLUDE_RULE_CLOCK_H_
+#define INCLUDE_RULE_CLOCK_H_
+
+/*
+ * Clocks giving the time of the evaluations
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <atomic>
+#include <cstdint>
+
+namespace systemspr {
+
+/**
+ * Source of the time of the evaluations, read once at the start of each of them.
+ *
+ * The monotonic time drives the time-based behaviour of the rule, such as the aggregation window.
+ * The realtime timestamps the states, the journal, the captures and the notifications.
+ */
+class RuleClock {
+public:
+    struct Time {
+        uint64_t monotonicNs{0};
+        uint64_t realtimeNs{0};
+    };
+
+    virtual ~RuleClock() = default;
+    virtual Time now() const = 0;
+};
+
+/**
+ * Clock of the plugin: the coarse clocks of the kernel, read from the vDSO without a system call.
+ * Their resolution is the scheduler tick, a few milliseconds.
+ */
+class CoarseClock : public RuleClock {
+public:
+    static const CoarseClock& getInstance();
+
+    Time now() const override;
+};
+
+/**
+ * Clock of the tests, which only moves when advanced. Hours of simulated time then take no time.
+ */
+class VirtualClock : public RuleClock {
+public:
+    static constexpr uint64_t DefaultRealtimeNs = 1577836800000000000ULL;   // 2020-01-01T00:00:00Z
+
+    explicit VirtualClock(uint64_t realtimeNs = DefaultRealtimeNs) : m_realtimeOffsetNs(realtimeNs) {}
+
+    Time now() const override;
+    void advance(uint64_t ns) { m_monotonicNs.fetch_add(ns, std::memory_order_relaxed); }
+    void advanceMs(uint64_t ms) { advance(ms * 1000000ULL); }
+
+private:
+    std::atomic<uint64_t> m_monotonicNs{0};
+    uint64_t              m_realtimeOffsetNs;
+};
+};
+
+#endif  // INCLUDE_RULE_CLOCK_H_
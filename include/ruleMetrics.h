@@ -0,0 +1,125 @@
+#ifndef INCLUDE_RULE_METRICS_H_
+#define INCLUDE_RULE_METRICS_H_
+
+/*
+ * Counters and latency histograms of the rule
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "evalDecision.h"
+
+namespace systemspr {
+
+/**
+ * Lock-free log-linear histogram of durations in nanoseconds.
+ *
+ * Each power of two is split in SubBuckets linear buckets, which bounds the relative error
+ * of the reported percentiles to 1/SubBuckets.
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SubBucketBits = 4;
+    static constexpr uint32_t SubBuckets    = 1 << SubBucketBits;
+    static constexpr uint32_t MaxBits       = 40;   // Values above 2^40 ns (18 minutes) are clamped
+    static constexpr uint32_t BucketCount   = (MaxBits - SubBucketBits + 1) * SubBuckets;
+
+    void record(uint64_t valueNs);
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t percentile(double percent) const;
+
+    static uint32_t bucketIndex(uint64_t valueNs);
+    static uint64_t bucketUpperBound(uint32_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BucketCount> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+/**
+ * Instrumentation of a rule instance: outcome counters, latency histograms and periodic export.
+ * The export file is written every export interval by a thread of its own, whether the rule evaluates
+ * readings or not, and a last time when the export stops.
+ */
+class RuleMetrics {
+public:
+    enum class Format { Json, Prometheus };
+
+    ~RuleMetrics() { stopExport(); }
+
+    void countDecision(EvalDecision decision) {
+        m_evaluations.fetch_add(1, std::memory_order_relaxed);
+        if (decision < EvalDecision::Count) {
+            m_decisions[static_cast<size_t>(decision)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void countCacheHit() { m_cacheHits.fetch_add(1, std::memory_order_relaxed); }
+    void countReconfigureStall(uint64_t durationNs) {
+        m_reconfigureStallNs.fetch_add(durationNs, std::memory_order_relaxed);
+        m_reconfigureStall.record(durationNs);
+    }
+
+    uint64_t getEvaluations() const { return m_evaluations.load(std::memory_order_relaxed); }
+    uint64_t getDecisionCount(EvalDecision decision) const {
+        return m_decisions[static_cast<size_t>(decision)].load(std::memory_order_relaxed);
+    }
+    uint64_t getPrefiltered() const;
+    uint64_t getCacheHits() const { return m_cacheHits.load(std::memory_order_relaxed); }
+    uint64_t getReconfigureStallNs() const { return m_reconfigureStallNs.load(std::memory_order_relaxed); }
+
+    LatencyHistogram& evalLatency() { return m_evalLatency; }
+    LatencyHistogram& reasonLatency() { return m_reasonLatency; }
+    LatencyHistogram& reconfigureLatency() { return m_reconfigureLatency; }
+    const LatencyHistogram& evalLatency() const { return m_evalLatency; }
+    const LatencyHistogram& reasonLatency() const { return m_reasonLatency; }
+    const LatencyHistogram& reconfigureLatency() const { return m_reconfigureLatency; }
+    const LatencyHistogram& reconfigureStall() const { return m_reconfigureStall; }
+
+    std::string toJson(const std::string& instance) const;
+    std::string toPrometheus(const std::string& instance) const;
+
+    void setExport(const std::string& instance, const std::string& path, Format format, uint64_t intervalNs);
+    void stopExport();
+    bool exportToFile(const std::string& instance) const;
+
+    static uint64_t monotonicNs();
+
+private:
+    std::atomic<uint64_t> m_evaluations{0};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(EvalDecision::Count)> m_decisions{};
+    std::atomic<uint64_t> m_cacheHits{0};
+    std::atomic<uint64_t> m_reconfigureStallNs{0};
+
+    LatencyHistogram m_evalLatency;
+    LatencyHistogram m_reasonLatency;
+    LatencyHistogram m_reconfigureLatency;
+    LatencyHistogram m_reconfigureStall;
+
+    void m_runExport();
+
+    std::string             m_exportInstance;
+    std::string             m_exportPath;
+    Format                  m_exportFormat{Format::Json};
+    uint64_t                m_exportIntervalNs{0};
+    std::mutex              m_exportMutex;
+    std::condition_variable m_exportWake;
+    bool                    m_exportStop{false};   // Guarded by m_exportMutex
+    std::thread             m_exportThread;
+};
+};
+
+#endif  // INCLUDE_RULE_METRICS_H_
@@ -0,0 +1,41 @@
+#ifndef INCLUDE_RULE_PROBES_H_
+#define INCLUDE_RULE_PROBES_H_
+
+/*
+ * USDT static tracepoints of the evaluation and reconfigure paths
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+
+/**
+ * Probes of the systemspr provider, attached by bpftrace or perf on a running notification service.
+ *
+ * With sys/sdt.h, each probe is a nop instruction and a note in the ELF file, patched only
+ * while a tracer is attached. Without it, the probes compile to nothing and their arguments
+ * are not evaluated. The scripts of tools/trace list the probes and their arguments.
+ */
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define SYSTEMSPR_PROBE(name) DTRACE_PROBE(systemspr, name)
+#define SYSTEMSPR_PROBE1(name, a1) DTRACE_PROBE1(systemspr, name, a1)
+#define SYSTEMSPR_PROBE2(name, a1, a2) DTRACE_PROBE2(systemspr, name, a1, a2)
+#define SYSTEMSPR_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(systemspr, name, a1, a2, a3)
+#define SYSTEMSPR_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(systemspr, name, a1, a2, a3, a4)
+#define SYSTEMSPR_PROBE5(name, a1, a2, a3, a4, a5) DTRACE_PROBE5(systemspr, name, a1, a2, a3, a4, a5)
+#else
+// sizeof keeps the arguments used without evaluating them
+#define SYSTEMSPR_PROBE(name) do { } while (0)
+#define SYSTEMSPR_PROBE1(name, a1) do { (void)sizeof(a1); } while (0)
+#define SYSTEMSPR_PROBE2(name, a1, a2) do { (void)sizeof(a1); (void)sizeof(a2); } while (0)
+#define SYSTEMSPR_PROBE3(name, a1, a2, a3) do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); } while (0)
+#define SYSTEMSPR_PROBE4(name, a1, a2, a3, a4) \
+    do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); (void)sizeof(a4); } while (0)
+#define SYSTEMSPR_PROBE5(name, a1, a2, a3, a4, a5) \
+    do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); (void)sizeof(a4); (void)sizeof(a5); } while (0)
+#endif
+
+#endif  // INCLUDE_RULE_PROBES_H_
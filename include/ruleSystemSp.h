@@ -14,12 +14,28 @@
 
 #include <datapoint_utility.h>
 #include <config_category.h>
+#include <array>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <thread>
 #include <atomic>
 
+#include "captureFile.h"
 #include "configPlugin.h"
+#include "connectionStateStore.h"
+#include "decisionTrace.h"
+#include "evalDecision.h"
+#include "exchangedDataWatcher.h"
+#include "notificationJournal.h"
+#include "outageAggregator.h"
+#include "payloadGuard.h"
+#include "reasonTemplate.h"
+#include "ruleClock.h"
+#include "ruleMetrics.h"
+#include "sharedStateTable.h"
+#include "southEventReader.h"
+#include "structuralIndex.h"
 
 using FuncPtr = void (*)(void *, void *);
 
@@ -36,13 +52,100 @@ public:
     bool evalRule(const std::string& assetValues);
     std::string getReason() const;
     std::string getTriggers() const;
+    LinkState getLinkState() const;
+    LinkState getLinkState(const std::string& asset) const;
+    const RuleMetrics& getMetrics() const { return m_metrics; }
+    void setClock(const RuleClock *clock);
 
 private:
+    static constexpr size_t MaxHeldNotifications = 4;   // An evaluation holds at most one more than it sends
+
+    /**
+     * Persistent state, shared state and journal identifier of a tracked asset
+     */
+    struct TrackedAssetState {
+        ConnectionStateStore::Entry *stateEntry{nullptr};
+        SharedStateTable::Entry     *sharedEntry{nullptr};
+        uint32_t                     journalAssetId{NotificationJournal::NoAsset};
+        bool                         knownLoss{false};      // Lost with a parent of the topology or notified before the restart
+    };
+
+    /**
+     * Notification held by the aggregation until an evaluation can send it: a single event,
+     * or the losses of a window when assets is not empty
+     */
+    struct PendingNotification {
+        EvalResult            result;
+        std::vector<uint32_t> assets;
+        bool                  siteDown{false};
+    };
+
+    /**
+     * Values of the reason of the last notification, collected before rendering the template
+     */
+    struct ReasonContext {
+        const ConfigPlugin::Connection *connection{nullptr};
+        std::vector<uint32_t> assets;           // Assets of the notification
+        std::vector<uint32_t> impliedAssets;    // Descendants of the assets, sorted
+        std::vector<uint32_t> datapoints;       // prt.inf datapoints reachable through both, sorted
+        bool                  hasPivotIds{false};
+    };
+
+    EvalResult m_evaluate(const std::string& assetValues, uint64_t& payloadHash, bool& hashed) const;
+    EvalResult m_parseReading(const std::string& assetValues) const;
+    void m_attachStateEntries();
+    void m_attachJournal();
+    void m_configureMetrics(const ConfigCategory& config);
+    void m_configureCapture(const ConfigCategory& config);
+    void m_reloadExchangedDataFile();
+    void m_holdRestoredLosses(uint64_t nowNs);
+    bool m_propagateLoss(const EvalResult& result, uint64_t nowNs);
+    bool m_aggregate(const EvalResult& result, uint64_t nowNs, EvalResult& notified);
+    bool m_isWindowComplete() const;
+    void m_setLossesNotified(const EvalResult& notified);
+    PendingNotification& m_holdNotification();
+    void m_collectReasonContext(ReasonContext& context) const;
+    void m_appendConnectionDatapoints(uint32_t assetIndex, std::vector<uint32_t>& datapoints) const;
+    void m_appendReasonSlot(std::string& reason, ReasonTemplate::Slot slot, const ReasonContext& context) const;
+    void m_appendReasonDetails(std::string& reason, const ReasonContext& context) const;
+    void m_appendAssetArray(std::string& reason, const std::vector<uint32_t>& assets) const;
+    void m_appendPivotIds(std::string& reason, const std::vector<uint32_t>& datapoints) const;
+
     ConfigPlugin             m_configPlugin;
     mutable std::mutex       m_configMutex;
+    std::mutex               m_reconfigureMutex;  // Held by reconfigure, outside of m_configMutex
     std::atomic<bool>        m_enabled{false};
     std::string              m_asset;
     std::string              m_reason;
+    std::string              m_firedAsset;
+    uint64_t                 m_firedTimeNs{0};    // Realtime clock
+    const RuleClock         *m_clock{&CoarseClock::getInstance()};
+    ReasonTemplate           m_reasonTemplate;
+    mutable ReasonContext    m_reasonContext;
+    mutable std::string      m_reasonBuffer;      // Reused by each getReason
+    std::vector<uint32_t>    m_aggregatedAssets;  // Assets of the last aggregated notification
+    bool                     m_siteDown{false};
+    std::array<PendingNotification, MaxHeldNotifications> m_heldNotifications;  // Ring sent one per evaluation, in order
+    size_t                   m_heldFirst{0};
+    size_t                   m_heldCount{0};
+    OutageAggregator         m_aggregator;
+    uint64_t                 m_aggregationWindowNs{0};
+    uint32_t                 m_siteDownThreshold{0};  // Percentage of the tracked assets, 0 to disable
+    bool                     m_evalCacheEnabled{true};
+    JsonBackend              m_jsonBackend{JsonBackend::RapidJson};
+    mutable StructuralIndex  m_structuralIndex;  // Reused by each evaluation with the ondemand backend
+    PayloadGuard             m_payloadGuard;
+    bool                     m_journalEnabled{false};
+    uint32_t                 m_journalSize{NotificationJournal::DefaultCapacity};
+    CaptureWriter            m_capture;
+    std::vector<TrackedAssetState> m_trackedStates;     // Parallel to ConfigPlugin::getTrackedAssets
+    bool                     m_stateRestored{false};     // Set by the first attachment of the state entries
+    bool                     m_resumeHeldLosses{false};  // Losses held at shutdown, put back by the next evaluation
+    mutable RuleMetrics      m_metrics;
+    std::string              m_exchangedDataFile;
+    std::string              m_sharedStateName;
+    DecisionTrace::SignalDump m_traceSignal;
+    ExchangedDataWatcher     m_watcher;          // Last member, its thread is stopped first on destruction
 };
 };
 
@@ -0,0 +1,129 @@
+#ifndef INCLUDE_SHARED_STATE_TABLE_H_
+#define INCLUDE_SHARED_STATE_TABLE_H_
+
+/*
+ * Connection states published in shared memory for the local consumers
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "southEvent.h"
+
+namespace systemspr {
+
+/**
+ * Table of connection states in a POSIX shared memory object, written by the rule and read
+ * by other processes of the host without copying nor locking.
+ *
+ * Each entry is protected by a sequence lock: a writer makes the sequence odd while it updates
+ * the entry, and a reader retries when the sequence is odd or changed during its copy, so it never
+ * copies a mix of two updates. The writers of an entry are serialized by a mutex of the writing
+ * process, not by the mapped sequence: a writer killed during an update leaves an odd sequence,
+ * which the next writer opening the object makes even again, and which makes the readers give up
+ * after MaxReadRetries instead of spinning.
+ * The changes counter of the header is incremented after each update and used as a futex
+ * word, so that readers can sleep until the next change. The readers sleeping on it are counted,
+ * the writer only wakes them up when there are some. A reader which is not allowed to write the
+ * object cannot be counted and polls the counter instead.
+ */
+class SharedStateTable {
+public:
+    static constexpr uint32_t Magic          = 0x54505353;  // "SSPT"
+    static constexpr uint16_t Version        = 1;
+    static constexpr uint32_t Capacity       = 1024;
+    static constexpr size_t   MaxAssetLength = 79;
+    static constexpr int      PollIntervalMs = 10;        // Wait of the readers not allowed to write the object
+    static constexpr uint32_t MaxReadRetries = 1000;      // Copies tried by a reader before giving up
+
+    struct Header {
+        uint32_t              magic;
+        uint16_t              version;
+        uint16_t              entrySize;
+        uint32_t              capacity;
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> changes;        // Futex word, incremented after each update
+        std::atomic<uint32_t> waiters;        // Readers sleeping on changes
+        uint8_t               reserved[40];
+    };
+
+    struct Entry {
+        std::atomic<uint32_t> sequence;       // Odd while the entry is written
+        std::atomic<uint32_t> lossCount;
+        std::atomic<uint64_t> assetHash;      // 0 when the slot is free, set once the name is written
+        char                  asset[MaxAssetLength + 1];
+        std::atomic<uint64_t> updatedNs;      // Realtime of the last link state change
+        std::atomic<uint8_t>  connxStatus;
+        std::atomic<uint8_t>  giStatus;
+        std::atomic<uint8_t>  linkState;
+        uint8_t               reserved[21];
+    };
+
+    /**
+     * Consistent copy of an entry
+     */
+    struct State {
+        std::string asset;
+        LinkState   linkState{LinkState::Unknown};
+        ConnxStatus connxStatus{ConnxStatus::None};
+        GiStatus    giStatus{GiStatus::None};
+        uint32_t    lossCount{0};
+        uint64_t    updatedNs{0};
+    };
+
+    SharedStateTable() = default;
+    SharedStateTable(const SharedStateTable&) = delete;
+    SharedStateTable& operator=(const SharedStateTable&) = delete;
+    ~SharedStateTable();
+
+    bool open(const std::string& name, bool readOnly = false);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& getName() const { return m_name; }
+    const Header* getHeader() const { return m_header; }
+    const Entry* getEntries() const { return m_entries; }
+
+    // Writer
+    Entry* acquire(const std::string& asset);
+    bool update(Entry* entry, ConnxStatus connx, GiStatus gi, uint64_t nowNs);
+    bool publish(Entry* entry, LinkState linkState, ConnxStatus connx, GiStatus gi, uint32_t lossCount,
+                 uint64_t updatedNs);
+
+    // Readers
+    const Entry* find(const std::string& asset) const;
+    static bool read(const Entry& entry, State& state);
+    uint32_t getChanges() const { return m_header ? m_header->changes.load(std::memory_order_acquire) : 0; }
+    bool waitForChange(uint32_t changes, int timeoutMs) const;
+
+    static bool unlink(const std::string& name);
+    static SharedStateTable& getInstance();
+
+private:
+    static uint64_t m_hashAsset(const std::string& asset);
+    uint32_t m_lockEntry(Entry* entry);
+    void m_unlockEntry(Entry* entry, uint32_t sequence, bool changed);
+    void m_initialize();
+
+    std::mutex   m_mutex;
+    std::mutex   m_entryMutexes[Capacity];  // Parallel to m_entries
+    std::string  m_name;
+    void        *m_mapping{nullptr};
+    size_t       m_mappingSize{0};
+    Header      *m_header{nullptr};
+    Entry       *m_entries{nullptr};
+    void        *m_waitMapping{nullptr};     // Writable header of a reader
+    std::atomic<uint32_t> *m_waiters{nullptr};
+};
+
+static_assert(sizeof(SharedStateTable::Header) == 64, "Shared state header layout changed");
+static_assert(sizeof(SharedStateTable::Entry) == 128, "Shared state entry layout changed");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Shared state entries need address-free atomics");
+};
+
+#endif  // INCLUDE_SHARED_STATE_TABLE_H_
@@ -0,0 +1,102 @@
+#ifndef INCLUDE_SOUTH_EVENT_H_
+#define INCLUDE_SOUTH_EVENT_H_
+
+/*
+ * Status values carried by south_event readings
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+#include <cstring>
+
+namespace systemspr {
+
+/**
+ * Value of the connx_status attribute of a south_event
+ */
+enum class ConnxStatus : uint8_t {
+    None = 0,       // Attribute absent or not a string
+    Started,
+    NotConnected,
+    Other
+};
+
+/**
+ * Value of the gi_status attribute of a south_event
+ */
+enum class GiStatus : uint8_t {
+    None = 0,       // Attribute absent or not a string
+    Idle,
+    Started,
+    InProgress,
+    Failed,
+    Finished,
+    Other
+};
+
+/**
+ * Link state derived from the successive south_event of a connection
+ */
+enum class LinkState : uint8_t {
+    Unknown = 0,
+    Connected,      // A GI completed since the last connection loss
+    NotConnected    // Connection lost and not recovered yet
+};
+
+namespace SouthEvent {
+
+    inline bool equals(const char *value, size_t length, const char *literal) {
+        return length == std::strlen(literal) && std::memcmp(value, literal, length) == 0;
+    }
+
+    inline ConnxStatus parseConnxStatus(const char *value, size_t length) {
+        if (equals(value, length, "not connected")) return ConnxStatus::NotConnected;
+        if (equals(value, length, "started"))       return ConnxStatus::Started;
+        return ConnxStatus::Other;
+    }
+
+    inline GiStatus parseGiStatus(const char *value, size_t length) {
+        if (equals(value, length, "finished"))    return GiStatus::Finished;
+        if (equals(value, length, "started"))     return GiStatus::Started;
+        if (equals(value, length, "in progress")) return GiStatus::InProgress;
+        if (equals(value, length, "failed"))      return GiStatus::Failed;
+        if (equals(value, length, "idle"))        return GiStatus::Idle;
+        return GiStatus::Other;
+    }
+
+    /**
+     * Link state of a connection after a south_event
+     */
+    inline LinkState nextLinkState(LinkState previous, ConnxStatus connx, GiStatus gi) {
+        if (connx == ConnxStatus::NotConnected) return LinkState::NotConnected;
+        if (gi == GiStatus::Finished)           return LinkState::Connected;
+        return previous;
+    }
+
+    inline const char *toString(ConnxStatus status) {
+        switch (status) {
+            case ConnxStatus::None:         return "";
+            case ConnxStatus::Started:      return "started";
+            case ConnxStatus::NotConnected: return "not connected";
+            default:                        return "other";
+        }
+    }
+
+    inline const char *toString(GiStatus status) {
+        switch (status) {
+            case GiStatus::None:       return "";
+            case GiStatus::Idle:       return "idle";
+            case GiStatus::Started:    return "started";
+            case GiStatus::InProgress: return "in progress";
+            case GiStatus::Failed:     return "failed";
+            case GiStatus::Finished:   return "finished";
+            default:                   return "other";
+        }
+    }
+};
+};
+
+#endif  // INCLUDE_SOUTH_EVENT_H_
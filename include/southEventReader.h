@@ -0,0 +1,55 @@
+#ifndef INCLUDE_SOUTH_EVENT_READER_H_
+#define INCLUDE_SOUTH_EVENT_READER_H_
+
+/*
+ * Extraction of the south_event of a tracked asset from a reading
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "evalDecision.h"
+#include "structuralIndex.h"
+
+namespace systemspr {
+
+/**
+ * JSON parser used to read the readings
+ */
+enum class JsonBackend : uint8_t {
+    RapidJson,  // DOM of the whole reading
+    OnDemand    // Structural index, only <asset>.south_event is read
+};
+
+namespace SouthEventReader {
+
+    /**
+     * Parse the whole reading with rapidjson and find the branch of the rule it matches
+     *
+     * @param data : JSON reading, null terminated
+     * @param trackedAssets : assets tracked by the rule, the first one found in the reading is evaluated
+     */
+    EvalResult readDom(const char *data, const std::vector<std::string>& trackedAssets);
+
+    /**
+     * Same result as readDom, reading only the path <asset>.south_event of the reading with a structural index.
+     * Syntax errors in the other values are not detected.
+     *
+     * @param index : index reused between the readings
+     * @param data : JSON reading
+     * @param length : size of the reading
+     * @param trackedAssets : assets tracked by the rule, the first one found in the reading is evaluated
+     */
+    EvalResult readOnDemand(StructuralIndex& index, const char *data, size_t length,
+                            const std::vector<std::string>& trackedAssets);
+
+    bool parseBackend(const std::string& name, JsonBackend& backend);
+};
+};
+
+#endif  // INCLUDE_SOUTH_EVENT_READER_H_
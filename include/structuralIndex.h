@@ -0,0 +1,122 @@
+#ifndef INCLUDE_STRUCTURAL_INDEX_H_
+#define INCLUDE_STRUCTURAL_INDEX_H_
+
+/*
+ * Structural index of a JSON document, for on-demand navigation
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace systemspr {
+
+/**
+ * Positions of the structural characters of a JSON document: the brackets, colons and commas
+ * outside of the strings, and the quotes delimiting the strings.
+ *
+ * The document is classified by blocks of 64 bytes, with AVX2 or SSE2 when the processor has them.
+ * Each opening bracket knows its closing bracket, so a value which is not needed is skipped
+ * without reading it. Only the strings which are read are decoded.
+ *
+ * build checks that the strings are closed and the brackets balanced. validate checks the rest of
+ * the syntax in one pass over the positions, reading only the strings and the scalars between them,
+ * so a document it accepts is one a DOM parser would accept.
+ */
+class StructuralIndex {
+public:
+    enum class Kernel : uint8_t { Scalar, Sse2, Avx2 };
+
+    enum class Type : uint8_t { Invalid, Object, Array, String, Scalar };
+
+    /**
+     * Value of the document, located by its first structural character
+     */
+    struct Value {
+        Type     type{Type::Invalid};
+        uint32_t index{0};      // Opening bracket or quote, for a scalar the structural character following it
+        uint32_t next{0};       // Structural character following the value
+    };
+
+    StructuralIndex() : m_kernel(getBestKernel()) {}
+
+    static Kernel getBestKernel();
+    static bool isSupported(Kernel kernel);
+    static const char *getKernelName(Kernel kernel);
+    bool setKernel(Kernel kernel);
+    Kernel getKernel() const { return m_kernel; }
+
+    bool build(const char *data, size_t length);
+    bool validate();
+    size_t size() const { return m_positions.size(); }
+    uint32_t getPosition(uint32_t index) const { return m_positions[index]; }
+
+    Value getRoot() const;
+    bool getString(const Value& value, const char *&begin, size_t& length, bool& escaped) const;
+    static bool unescape(const char *begin, size_t length, std::string& out);
+
+    /**
+     * Call a function for each member of an object, in the order of the document
+     *
+     * @param object : object value
+     * @param fn : bool (const char *key, size_t keyLength, bool keyEscaped, const Value& value),
+     *             returning false to stop
+     * @return false if the object is malformed
+     */
+    template <typename MemberFn>
+    bool forEachMember(const Value& object, MemberFn&& fn) const {
+        if (object.type != Type::Object) {
+            return false;
+        }
+        uint32_t close = m_match[object.index];
+        uint32_t i = object.index + 1;
+        if (i == close) {
+            return true;
+        }
+        while (i + 2 < close) {
+            if (m_char(i) != '"' || m_char(i + 1) != '"' || m_char(i + 2) != ':') {
+                return false;
+            }
+            const char *key = m_data + m_positions[i] + 1;
+            size_t keyLength = m_positions[i + 1] - m_positions[i] - 1;
+            Value value = m_valueAfter(i + 2);
+            if (value.type == Type::Invalid || value.next > close) {
+                return false;
+            }
+            if (!fn(key, keyLength, m_hasEscape(key, keyLength), value)) {
+                return true;
+            }
+            if (value.next == close) {
+                return true;
+            }
+            if (m_char(value.next) != ',') {
+                return false;
+            }
+            i = value.next + 1;
+        }
+        return false;
+    }
+
+private:
+    char m_char(uint32_t index) const { return m_data[m_positions[index]]; }
+    Value m_valueAt(uint32_t index, uint32_t position) const;
+    Value m_valueAfter(uint32_t index) const;
+    static bool m_hasEscape(const char *value, size_t length);
+    static bool m_validString(const char *begin, size_t length);
+    static bool m_validScalar(const char *begin, const char *end);
+
+    Kernel                m_kernel;
+    const char           *m_data{nullptr};
+    size_t                m_length{0};
+    std::vector<uint32_t> m_positions;
+    std::vector<uint32_t> m_match;      // Parallel to m_positions, closing bracket of each opening bracket
+    std::vector<uint32_t> m_stack;
+};
+};
+
+#endif  // INCLUDE_STRUCTURAL_INDEX_H_
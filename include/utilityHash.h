@@ -0,0 +1,107 @@
+#ifndef INCLUDE_UTILITY_HASH_H_
+#define INCLUDE_UTILITY_HASH_H_
+/*
+ * Hash helpers
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace systemspr {
+
+namespace UtilityHash {
+    constexpr uint64_t Fnv64Offset = 14695981039346656037ULL;
+    constexpr uint64_t Fnv64Prime  = 1099511628211ULL;
+
+    /*
+     * FNV-1a 64 bits hash of a buffer, can be chained by passing the previous hash as seed
+     */
+    inline uint64_t fnv1a64(const char *data, size_t length, uint64_t seed = Fnv64Offset) {
+        uint64_t hash = seed;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= Fnv64Prime;
+        }
+        return hash;
+    }
+
+    inline uint64_t fnv1a64(const std::string& value, uint64_t seed = Fnv64Offset) {
+        return fnv1a64(value.data(), value.size(), seed);
+    }
+
+    constexpr uint64_t Xxh64Prime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t Xxh64Prime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t Xxh64Prime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t Xxh64Prime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t Xxh64Prime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotateLeft(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t xxh64Round(uint64_t accumulator, uint64_t input) {
+        return rotateLeft(accumulator + input * Xxh64Prime2, 31) * Xxh64Prime1;
+    }
+
+    inline uint64_t xxh64Merge(uint64_t hash, uint64_t accumulator) {
+        return (hash ^ xxh64Round(0, accumulator)) * Xxh64Prime1 + Xxh64Prime4;
+    }
+
+    /*
+     * XXH64 hash of a buffer, reading it 8 bytes at a time in 4 independent lanes: used for the readings,
+     * which may be large, where the byte by byte FNV-1a would cost as much as their parsing.
+     * The words are read in the byte order of the host, x86 and ARM are little endian as the reference.
+     */
+    inline uint64_t xxh64(const char *data, size_t length, uint64_t seed = 0) {
+        const char *end = data + length;
+        uint64_t hash;
+        auto read64 = [](const char *p) { uint64_t word; memcpy(&word, p, sizeof(word)); return word; };
+        auto read32 = [](const char *p) { uint32_t word; memcpy(&word, p, sizeof(word)); return word; };
+        if (length >= 32) {
+            uint64_t lanes[4] = {seed + Xxh64Prime1 + Xxh64Prime2, seed + Xxh64Prime2, seed, seed - Xxh64Prime1};
+            for (; data + 32 <= end; data += 32) {
+                for (int i = 0; i < 4; i++) {
+                    lanes[i] = xxh64Round(lanes[i], read64(data + 8 * i));
+                }
+            }
+            hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) +
+                   rotateLeft(lanes[3], 18);
+            for (uint64_t lane : lanes) {
+                hash = xxh64Merge(hash, lane);
+            }
+        }
+        else {
+            hash = seed + Xxh64Prime5;
+        }
+        hash += length;
+        for (; data + 8 <= end; data += 8) {
+            hash = rotateLeft(hash ^ xxh64Round(0, read64(data)), 27) * Xxh64Prime1 + Xxh64Prime4;
+        }
+        if (data + 4 <= end) {
+            hash = rotateLeft(hash ^ (read32(data) * Xxh64Prime1), 23) * Xxh64Prime2 + Xxh64Prime3;
+            data += 4;
+        }
+        for (; data < end; data++) {
+            hash = rotateLeft(hash ^ (static_cast<unsigned char>(*data) * Xxh64Prime5), 11) * Xxh64Prime1;
+        }
+        hash ^= hash >> 33;
+        hash *= Xxh64Prime2;
+        hash ^= hash >> 29;
+        hash *= Xxh64Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    inline uint64_t xxh64(const std::string& value, uint64_t seed = 0) {
+        return xxh64(value.data(), value.size(), seed);
+    }
+};
+};
+
+#endif  // INCLUDE_UTILITY_HASH_H_
@@ -11,57 +11,130 @@
  * 
  */
 #include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <sys/stat.h>
 #include <logger.h>
 
+#include "constantsSystem.h"
+
 namespace systemspr {
 
 namespace UtilityPivot {  
     /*
-     * Log helper function that will log both in the Fledge syslog file and in stdout for unit tests
+     * Log helper function that will log both in the Fledge syslog file and in stdout for unit tests.
+     * The format is given to the logger as is, a format passed as a std::string built once is not copied.
      */
     template<class... Args>
     void log_debug(const std::string& format, Args&&... args) {  
         #ifdef UNIT_TEST
-        printf(std::string(format).append("\n").c_str(), std::forward<Args>(args)...);
+        printf(format.c_str(), args...);
+        printf("\n");
         fflush(stdout);
         #endif
-        Logger::getLogger()->debug(format.c_str(), std::forward<Args>(args)...);
+        Logger::getLogger()->debug(format, std::forward<Args>(args)...);
     }
 
     template<class... Args>
     void log_info(const std::string& format, Args&&... args) {    
         #ifdef UNIT_TEST
-        printf(std::string(format).append("\n").c_str(), std::forward<Args>(args)...);
+        printf(format.c_str(), args...);
+        printf("\n");
         fflush(stdout);
         #endif
-        Logger::getLogger()->info(format.c_str(), std::forward<Args>(args)...);
+        Logger::getLogger()->info(format, std::forward<Args>(args)...);
     }
 
     template<class... Args>
     void log_warn(const std::string& format, Args&&... args) { 
         #ifdef UNIT_TEST  
-        printf(std::string(format).append("\n").c_str(), std::forward<Args>(args)...);
+        printf(format.c_str(), args...);
+        printf("\n");
         fflush(stdout);
         #endif
-        Logger::getLogger()->warn(format.c_str(), std::forward<Args>(args)...);
+        Logger::getLogger()->warn(format, std::forward<Args>(args)...);
     }
 
     template<class... Args>
     void log_error(const std::string& format, Args&&... args) {   
         #ifdef UNIT_TEST
-        printf(std::string(format).append("\n").c_str(), std::forward<Args>(args)...);
+        printf(format.c_str(), args...);
+        printf("\n");
         fflush(stdout);
         #endif
-        Logger::getLogger()->error(format.c_str(), std::forward<Args>(args)...);
+        Logger::getLogger()->error(format, std::forward<Args>(args)...);
     }
 
     template<class... Args>
     void log_fatal(const std::string& format, Args&&... args) {  
         #ifdef UNIT_TEST
-        printf(std::string(format).append("\n").c_str(), std::forward<Args>(args)...);
+        printf(format.c_str(), args...);
+        printf("\n");
         fflush(stdout);
         #endif
-        Logger::getLogger()->fatal(format.c_str(), std::forward<Args>(args)...);
+        Logger::getLogger()->fatal(format, std::forward<Args>(args)...);
+    }
+
+    /*
+     * Append a string to a JSON document, escaping the characters not allowed in JSON strings
+     */
+    inline void appendJsonEscaped(std::string& out, const std::string& value) {
+        static const char hex[] = "0123456789abcdef";
+        for (char c : value) {
+            unsigned char u = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            }
+            else if (u < 0x20) {
+                out += "\\u00";
+                out += hex[u >> 4];
+                out += hex[u & 0xF];
+            }
+            else {
+                out += c;
+            }
+        }
+    }
+
+    /*
+     * Payloads are logged truncated, with "%.*s%s" and the two following arguments
+     */
+    constexpr size_t LogExcerptLength = 256;
+
+    inline int logExcerptLength(const std::string& payload) {
+        return static_cast<int>(payload.size() < LogExcerptLength ? payload.size() : LogExcerptLength);
+    }
+
+    inline const char *logExcerptEllipsis(const std::string& payload) {
+        return payload.size() > LogExcerptLength ? "..." : "";
+    }
+
+    /*
+     * Fledge data directory: $FLEDGE_DATA, else $FLEDGE_ROOT/data, else the default install path
+     */
+    inline std::string getDataDir() {
+        const char *data = std::getenv("FLEDGE_DATA");
+        if (data && *data) {
+            return data;
+        }
+        const char *root = std::getenv("FLEDGE_ROOT");
+        if (root && *root) {
+            return std::string(root) + "/data";
+        }
+        return "/usr/local/fledge/data";
+    }
+
+    /*
+     * Directory holding the files written by this plugin, created on first use.
+     * Returns an empty string if the directory cannot be created.
+     */
+    inline std::string getPluginDataDir() {
+        std::string dir = getDataDir() + "/" + FILTER_NAME;
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            return "";
+        }
+        return dir;
     }
 };
 };
@@ -0,0 +1,191 @@
+/*
+ * Capture of the evaluated readings in a compressed file
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+
+#include <rapidjson/document.h>
+
+#include "captureFile.h"
+#include "constantsSystem.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr size_t CaptureWriter::MaxPendingSize;
+constexpr uint32_t CaptureWriter::FlushPeriodMs;
+
+namespace {
+// Pending size above which the writer thread is woken before the flush period
+constexpr size_t WakeSize = 256 * 1024;
+};
+
+/**
+ * Open a capture file and start the writer thread, the records are appended to an existing file
+ *
+ * @param path : path of the capture file
+ * @return false if the file cannot be opened
+ */
+bool CaptureWriter::open(const std::string& path) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - CaptureWriter::open :";
+    close();
+    m_file = gzopen(path.c_str(), "ab");
+    if (m_file == nullptr) {
+        UtilityPivot::log_error("%s Unable to open %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+    m_path = path;
+    m_stop = false;
+    m_pending.reserve(WakeSize * 2);
+    m_thread = std::thread(&CaptureWriter::m_run, this);
+    UtilityPivot::log_info("%s Capturing the readings in %s", beforeLog.c_str(), path.c_str());
+    return true;
+}
+
+/**
+ * Write the pending records, stop the writer thread and close the file
+ */
+void CaptureWriter::close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+    if (m_file != nullptr) {
+        gzclose(m_file);
+        m_file = nullptr;
+    }
+    m_path.clear();
+}
+
+/**
+ * Queue a reading to be written, called by the evaluations
+ *
+ * @param timestampNs : realtime of the evaluation
+ * @param reading : JSON reading
+ */
+void CaptureWriter::append(uint64_t timestampNs, const std::string& reading) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_pending.size() + reading.size() > MaxPendingSize) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        formatLine(m_pending, timestampNs, reading);
+        wake = m_pending.size() >= WakeSize;
+    }
+    if (wake) {
+        m_wake.notify_one();
+    }
+}
+
+/**
+ * Append the JSON line of a record
+ */
+void CaptureWriter::formatLine(std::string& out, uint64_t timestampNs, const std::string& reading) {
+    char prefix[48];
+    int length = snprintf(prefix, sizeof(prefix), "{\"ts\": %" PRIu64 ", \"reading\": \"", timestampNs);
+    out.append(prefix, static_cast<size_t>(length));
+    UtilityPivot::appendJsonEscaped(out, reading);
+    out += "\"}\n";
+}
+
+void CaptureWriter::m_run() {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - CaptureWriter::m_run :";
+    std::string writing;
+    writing.reserve(WakeSize * 2);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        bool woken = m_wake.wait_for(lock, std::chrono::milliseconds(FlushPeriodMs), [this]() {
+            return m_stop || m_pending.size() >= WakeSize;
+        });
+        bool stop = m_stop;
+        writing.swap(m_pending);
+        lock.unlock();
+
+        // Flushed at each period, so that a crash loses at most the last period
+        if (!writing.empty() &&
+            gzwrite(m_file, writing.data(), static_cast<unsigned>(writing.size())) != static_cast<int>(writing.size())) {
+            int error;
+            UtilityPivot::log_error("%s Unable to write %s: %s", beforeLog.c_str(), m_path.c_str(),
+                                    gzerror(m_file, &error));
+        }
+        if (!woken && !writing.empty()) {
+            gzflush(m_file, Z_SYNC_FLUSH);
+        }
+        writing.clear();
+        if (stop) {
+            return;
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Open a capture file, gzip compressed or plain
+ *
+ * @return false if the file cannot be opened
+ */
+bool CaptureReader::open(const std::string& path) {
+    close();
+    m_file = gzopen(path.c_str(), "rb");
+    if (m_file == nullptr) {
+        return false;
+    }
+    gzbuffer(m_file, 256 * 1024);
+    m_lineNumber = 0;
+    return true;
+}
+
+void CaptureReader::close() {
+    if (m_file != nullptr) {
+        gzclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+/**
+ * Read the next record, the lines which are not a record are skipped
+ *
+ * @param record : receives the record
+ * @return false at the end of the file
+ */
+bool CaptureReader::next(Record& record) {
+    char chunk[64 * 1024];
+    while (m_file != nullptr) {
+        m_line.clear();
+        while (gzgets(m_file, chunk, sizeof(chunk)) != nullptr) {
+            m_line += chunk;
+            if (!m_line.empty() && m_line.back() == '\n') {
+                break;
+            }
+        }
+        if (m_line.empty()) {
+            return false;
+        }
+        m_lineNumber++;
+
+        rapidjson::Document doc;
+        doc.Parse(m_line.c_str());
+        if (!doc.HasParseError() && doc.IsObject() && doc.HasMember("ts") && doc["ts"].IsUint64() &&
+            doc.HasMember("reading") && doc["reading"].IsString()) {
+            record.timestampNs = doc["ts"].GetUint64();
+            record.reading.assign(doc["reading"].GetString(), doc["reading"].GetStringLength());
+            return true;
+        }
+        UtilityPivot::log_warn("%s - CaptureReader::next : Invalid record at line %" PRIu64,
+                               ConstantsSystem::NamePlugin.c_str(), m_lineNumber);
+    }
+    return false;
+}
@@ -0,0 +1,287 @@
+/*
+ * Binary cache of the compiled exchanged_data
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "compiledConfigFile.h"
+#include "constantsSystem.h"
+#include "utilityHash.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t CompiledConfigFile::Magic;
+constexpr uint16_t CompiledConfigFile::Version;
+constexpr size_t   CompiledConfigFile::MaxFiles;
+
+static_assert(sizeof(CompiledConfigFile::Header) == 72, "Header layout changed, increase Version");
+static_assert(sizeof(CompiledConfigFile::DatapointRecord) == 40, "DatapointRecord layout changed, increase Version");
+static_assert(sizeof(CompiledConfigFile::PointRecord) == 16, "PointRecord layout changed, increase Version");
+
+namespace {
+
+const char FilePrefix[] = "exchanged_data_";
+const char FileSuffix[] = ".bin";
+
+CompiledConfigFile::StringRef appendString(std::string& pool, const std::string& value) {
+    CompiledConfigFile::StringRef ref{static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(value.size())};
+    pool += value;
+    return ref;
+}
+
+template <typename T>
+void appendRecord(std::string& buffer, const T& record) {
+    buffer.append(reinterpret_cast<const char *>(&record), sizeof(T));
+}
+
+bool inBounds(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && count * size <= fileSize - offset;
+}
+};
+
+/**
+ * Path of the file of an exchanged_data in the cache directory
+ *
+ * @param dir : cache directory
+ * @param key : hash of the exchanged_data
+ */
+std::string CompiledConfigFile::getPath(const std::string& dir, uint64_t key) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s%016" PRIx64 "%s", FilePrefix, key, FileSuffix);
+    return dir + "/" + name;
+}
+
+/**
+ * Write the compiled exchanged_data of a configuration, replacing the file atomically
+ *
+ * @param path : path of the file
+ * @param key : hash of the exchanged_data
+ * @param compiled : compiled exchanged_data
+ * @return true if the file was written
+ */
+bool CompiledConfigFile::write(const std::string& path, uint64_t key, const ConfigPlugin::Compiled& compiled) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - CompiledConfigFile::write :";
+    std::string pool;
+    std::string datapoints;
+    std::string protocols;
+    std::string points;
+    std::string subtypes;
+    datapoints.reserve(compiled.datapoints.size() * sizeof(DatapointRecord));
+    for (const ConfigPlugin::Datapoint& datapoint : compiled.datapoints) {
+        DatapointRecord record = {};
+        record.contentHash = datapoint.contentHash;
+        record.subtypeMask = datapoint.subtypeMask;
+        record.pivotId = appendString(pool, datapoint.pivotId);
+        record.label = appendString(pool, datapoint.label);
+        record.prtInf = datapoint.prtInf ? 1 : 0;
+        record.active = datapoint.active ? 1 : 0;
+        appendRecord(datapoints, record);
+    }
+    for (const std::string& protocol : compiled.protocols) {
+        appendRecord(protocols, appendString(pool, protocol));
+    }
+    points.reserve(compiled.prtInfIndex.size() * sizeof(PointRecord));
+    for (const ConfigPlugin::ProtocolPoint& point : compiled.prtInfIndex) {
+        appendRecord(points, PointRecord{point.protocol, point.datapoint, point.address});
+    }
+    for (const std::string& subtype : compiled.subtypes) {
+        appendRecord(subtypes, appendString(pool, subtype));
+    }
+
+    Header header = {};
+    header.magic = Magic;
+    header.version = Version;
+    header.headerSize = sizeof(Header);
+    header.key = key;
+    header.datapointCount = static_cast<uint32_t>(compiled.datapoints.size());
+    header.protocolCount = static_cast<uint32_t>(compiled.protocols.size());
+    header.pointCount = static_cast<uint32_t>(compiled.prtInfIndex.size());
+    header.stringPoolSize = static_cast<uint32_t>(pool.size());
+    header.datapointOffset = sizeof(Header);
+    header.protocolOffset = header.datapointOffset + static_cast<uint32_t>(datapoints.size());
+    header.pointOffset = header.protocolOffset + static_cast<uint32_t>(protocols.size());
+    header.subtypeCount = static_cast<uint32_t>(compiled.subtypes.size());
+    header.subtypeOffset = header.pointOffset + static_cast<uint32_t>(points.size());
+    header.stringPoolOffset = header.subtypeOffset + static_cast<uint32_t>(subtypes.size());
+    header.fileSize = header.stringPoolOffset + pool.size();
+
+    std::string body = datapoints + protocols + points + subtypes + pool;
+    header.checksum = UtilityHash::fnv1a64(body);
+
+    std::string temporaryPath = path + ".tmp";
+    FILE *file = fopen(temporaryPath.c_str(), "w");
+    if (!file) {
+        UtilityPivot::log_warn("%s Unable to write %s: %s", beforeLog.c_str(), temporaryPath.c_str(), strerror(errno));
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(body.data(), 1, body.size(), file) == body.size();
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        UtilityPivot::log_warn("%s Unable to write %s", beforeLog.c_str(), path.c_str());
+        remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copy the compiled exchanged_data of a file into a configuration, the file is unmapped on return
+ *
+ * @param path : path of the file
+ * @param key : hash of the expected exchanged_data
+ * @param compiled : receives the datapoint table, the protocols, the prt.inf index and the subtype index
+ * @return false if the file does not exist, is for another exchanged_data or is corrupted
+ */
+bool CompiledConfigFile::read(const std::string& path, uint64_t key, ConfigPlugin::Compiled& compiled) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - CompiledConfigFile::read :";
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        UtilityPivot::log_warn("%s %s is truncated", beforeLog.c_str(), path.c_str());
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        UtilityPivot::log_warn("%s Unable to map %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+    const char *base = static_cast<const char *>(mapping);
+    const Header& header = *reinterpret_cast<const Header *>(base);
+
+    bool valid = header.magic == Magic && header.version == Version && header.headerSize == sizeof(Header) &&
+                 header.key == key && header.fileSize == size &&
+                 header.datapointOffset == sizeof(Header) &&
+                 inBounds(header.datapointOffset, header.datapointCount, sizeof(DatapointRecord), size) &&
+                 inBounds(header.protocolOffset, header.protocolCount, sizeof(StringRef), size) &&
+                 inBounds(header.pointOffset, header.pointCount, sizeof(PointRecord), size) &&
+                 inBounds(header.subtypeOffset, header.subtypeCount, sizeof(StringRef), size) &&
+                 header.subtypeCount <= ConfigPlugin::MaxSubtypes &&
+                 inBounds(header.stringPoolOffset, header.stringPoolSize, 1, size) &&
+                 UtilityHash::fnv1a64(base + sizeof(Header), size - sizeof(Header)) == header.checksum;
+    if (!valid) {
+        munmap(mapping, size);
+        UtilityPivot::log_warn("%s %s is invalid or stale", beforeLog.c_str(), path.c_str());
+        return false;
+    }
+
+    const char *pool = base + header.stringPoolOffset;
+    auto getString = [&](const StringRef& ref, std::string& value) {
+        if (ref.offset > header.stringPoolSize || ref.length > header.stringPoolSize - ref.offset) {
+            return false;
+        }
+        value.assign(pool + ref.offset, ref.length);
+        return true;
+    };
+
+    std::vector<ConfigPlugin::Datapoint> datapoints(header.datapointCount);
+    const DatapointRecord *datapointRecords = reinterpret_cast<const DatapointRecord *>(base + header.datapointOffset);
+    for (uint32_t i = 0; i < header.datapointCount && valid; i++) {
+        const DatapointRecord& record = datapointRecords[i];
+        datapoints[i].contentHash = record.contentHash;
+        datapoints[i].subtypeMask = record.subtypeMask;
+        datapoints[i].prtInf = record.prtInf != 0;
+        datapoints[i].active = record.active != 0;
+        valid = getString(record.pivotId, datapoints[i].pivotId) && getString(record.label, datapoints[i].label) &&
+                (header.subtypeCount == ConfigPlugin::MaxSubtypes || record.subtypeMask >> header.subtypeCount == 0);
+    }
+    std::vector<std::string> protocols(header.protocolCount);
+    const StringRef *protocolRecords = reinterpret_cast<const StringRef *>(base + header.protocolOffset);
+    for (uint32_t i = 0; i < header.protocolCount && valid; i++) {
+        valid = getString(protocolRecords[i], protocols[i]);
+    }
+    std::vector<ConfigPlugin::ProtocolPoint> points(header.pointCount);
+    const PointRecord *pointRecords = reinterpret_cast<const PointRecord *>(base + header.pointOffset);
+    for (uint32_t i = 0; i < header.pointCount && valid; i++) {
+        const PointRecord& record = pointRecords[i];
+        valid = record.protocol < header.protocolCount && record.datapoint < header.datapointCount;
+        points[i] = ConfigPlugin::ProtocolPoint{record.protocol, record.datapoint, record.address};
+    }
+    std::vector<std::string> subtypes(header.subtypeCount);
+    const StringRef *subtypeRecords = reinterpret_cast<const StringRef *>(base + header.subtypeOffset);
+    for (uint32_t i = 0; i < header.subtypeCount && valid; i++) {
+        valid = getString(subtypeRecords[i], subtypes[i]);
+    }
+    munmap(mapping, size);
+    if (!valid) {
+        UtilityPivot::log_warn("%s %s has invalid references", beforeLog.c_str(), path.c_str());
+        return false;
+    }
+
+    compiled.key = key;
+    compiled.datapoints = std::move(datapoints);
+    compiled.protocols = std::move(protocols);
+    compiled.prtInfIndex = std::move(points);
+    compiled.subtypes = std::move(subtypes);
+    ConfigPlugin::buildSubtypeIndex(compiled);
+    compiled.datapointIds.clear();
+    compiled.datapointIds.reserve(compiled.datapoints.size());
+    compiled.freeDatapoints.clear();
+    compiled.prtInfCount = 0;
+    for (uint32_t i = 0; i < compiled.datapoints.size(); i++) {
+        const ConfigPlugin::Datapoint& datapoint = compiled.datapoints[i];
+        if (!datapoint.active) {
+            compiled.freeDatapoints.push_back(i);
+            continue;
+        }
+        compiled.datapointIds.emplace(datapoint.pivotId, i);
+        if (datapoint.prtInf) {
+            compiled.prtInfCount++;
+        }
+    }
+    return true;
+}
+
+/**
+ * Remove the oldest files of the cache directory, keeping the MaxFiles most recent ones
+ *
+ * @param dir : cache directory
+ */
+void CompiledConfigFile::prune(const std::string& dir) {
+    DIR *directory = opendir(dir.c_str());
+    if (!directory) {
+        return;
+    }
+    std::vector<std::pair<time_t, std::string>> files;
+    while (struct dirent *entry = readdir(directory)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, sizeof(FilePrefix) - 1, FilePrefix) != 0 || name.size() < sizeof(FileSuffix) ||
+            name.compare(name.size() - (sizeof(FileSuffix) - 1), std::string::npos, FileSuffix) != 0) {
+            continue;
+        }
+        struct stat st;
+        std::string path = dir + "/" + name;
+        if (stat(path.c_str(), &st) == 0) {
+            files.emplace_back(st.st_mtime, path);
+        }
+    }
+    closedir(directory);
+    if (files.size() <= MaxFiles) {
+        return;
+    }
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i < files.size() - MaxFiles; i++) {
+        unlink(files[i].second.c_str());
+    }
+}
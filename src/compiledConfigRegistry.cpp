@@ -0,0 +1,72 @@
+/*
+ * Compiled exchanged_data shared by the rule instances of the process
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include "compiledConfigRegistry.h"
+
+using namespace systemspr;
+
+/**
+ * Find the compiled exchanged_data of a key
+ *
+ * @param key : hash of the exchanged_data
+ * @return The compiled exchanged_data, nullptr if no rule instance uses it
+ */
+CompiledConfigRegistry::CompiledPtr CompiledConfigRegistry::find(uint64_t key) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto found = m_compiled.find(key);
+    if (found == m_compiled.end()) {
+        return nullptr;
+    }
+    CompiledPtr compiled = found->second.lock();
+    if (!compiled) {
+        m_compiled.erase(found);
+    }
+    return compiled;
+}
+
+/**
+ * Register a compiled exchanged_data. When two instances compile the same exchanged_data
+ * concurrently, the first one registered is kept.
+ *
+ * @param compiled : compiled exchanged_data, not modified afterwards
+ * @return The registered compiled exchanged_data for the key of compiled
+ */
+CompiledConfigRegistry::CompiledPtr CompiledConfigRegistry::publish(const CompiledPtr& compiled) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    std::weak_ptr<const ConfigPlugin::Compiled>& entry = m_compiled[compiled->key];
+    CompiledPtr existing = entry.lock();
+    if (existing) {
+        return existing;
+    }
+    entry = compiled;
+    return compiled;
+}
+
+/**
+ * Number of compiled exchanged_data in use
+ */
+size_t CompiledConfigRegistry::size() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (auto it = m_compiled.begin(); it != m_compiled.end();) {
+        if (it->second.expired()) {
+            it = m_compiled.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    return m_compiled.size();
+}
+
+/**
+ * Registry shared by all the rule instances of the process
+ */
+CompiledConfigRegistry& CompiledConfigRegistry::getInstance() {
+    static CompiledConfigRegistry instance;
+    return instance;
+}
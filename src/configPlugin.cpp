@@ -1,66 +1,450 @@
 #include <logger.h>
 #include <cctype>
 #include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "configPlugin.h"
+#include "compiledConfigFile.h"
+#include "compiledConfigRegistry.h"
 #include "constantsSystem.h"
+#include "ruleProbes.h"
+#include "utilityHash.h"
 #include "utilityPivot.h"
 
 using namespace systemspr;
 
+constexpr uint64_t ConfigPlugin::NonNumericAddress;
+constexpr uint32_t ConfigPlugin::NoDatapoint;
+constexpr uint32_t ConfigPlugin::NoSubtype;
+constexpr uint32_t ConfigPlugin::MaxSubtypes;
+
+namespace {
+
+uint64_t mix64(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    return value ^ (value >> 33);
+}
+
+/*
+ * Structural hash of a JSON value, independent of the formatting and of the order of the object members
+ */
+uint64_t hashValue(const rapidjson::Value& value) {
+    uint64_t hash = mix64(static_cast<uint64_t>(value.GetType()) + 1);
+    switch (value.GetType()) {
+        case rapidjson::kStringType:
+            return UtilityHash::fnv1a64(value.GetString(), value.GetStringLength(), hash);
+        case rapidjson::kNumberType: {
+            if (value.IsInt64() || value.IsUint64()) {
+                return mix64(hash ^ static_cast<uint64_t>(value.GetInt64()));
+            }
+            double number = value.GetDouble();
+            uint64_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            return mix64(hash ^ bits ^ 1);
+        }
+        case rapidjson::kArrayType:
+            for (const rapidjson::Value& item : value.GetArray()) {
+                hash = mix64(hash ^ hashValue(item));
+            }
+            return hash;
+        case rapidjson::kObjectType: {
+            uint64_t members = 0;
+            for (const auto& member : value.GetObject()) {
+                uint64_t name = UtilityHash::fnv1a64(member.name.GetString(), member.name.GetStringLength());
+                members += mix64(name ^ hashValue(member.value));
+            }
+            return mix64(hash ^ members);
+        }
+        default:
+            return hash;
+    }
+}
+};
+
+ConfigPlugin::ConfigPlugin() {
+    static const std::shared_ptr<const Compiled> empty = std::make_shared<Compiled>();
+    m_compiled = empty;
+}
+
 /**
  * Import data in the form of Exchanged_data
- * The data is saved in a map m_exchangeDefinitions
+ * The TS datapoints are saved in a Compiled table, keyed by pivot_id, with the protocol
+ * addresses of the prt.inf datapoints in a sorted index.
+ *
+ * The compiled table is shared with the other rule instances importing the same exchanged_data.
+ * Otherwise the new configuration is compared to the current one datapoint by datapoint, and only
+ * the added, removed and changed datapoints are updated in a copy of the current table. The
+ * unchanged datapoints keep their identifier.
  * 
  * @param exchangeConfig : configuration Exchanged_data as a string 
+ * @return false if the exchanged_data is not valid, the datapoints are then cleared
 */
-void ConfigPlugin::importExchangedData(const std::string & exchangeConfig) {
-    
+bool ConfigPlugin::importExchangedData(const std::string & exchangeConfig) {
+    return importExchangedData(exchangeConfig.data(), exchangeConfig.size());
+}
+
+/**
+ * Import Exchanged_data from a buffer which is not null terminated
+ *
+ * @param exchangeConfig : configuration Exchanged_data
+ * @param length : size of exchangeConfig
+ * @return false if the exchanged_data is not valid, the datapoints are then cleared
+ */
+bool ConfigPlugin::importExchangedData(const char *exchangeConfig, size_t length) {
+    SYSTEMSPR_PROBE1(import__start, length);
+    bool imported = m_importExchangedData(exchangeConfig, length, false);
+    SYSTEMSPR_PROBE4(import__done, m_lastDelta.added, m_lastDelta.removed, m_lastDelta.changed,
+                     m_lastDelta.unchanged);
+    return imported;
+}
+
+/**
+ * Import Exchanged_data, reusing the tables of another instance or of the configuration cache when possible
+ *
+ * @param exchangeConfig : configuration Exchanged_data
+ * @param length : size of exchangeConfig
+ * @param keepOnError : keep the current datapoints if the exchanged_data is not valid, instead of clearing them
+ * @return false if the exchanged_data is not valid
+ */
+bool ConfigPlugin::m_importExchangedData(const char *exchangeConfig, size_t length, bool keepOnError) {
     std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::importExchangedData :";
-    rapidjson::Document document;
+    uint64_t exchangedDataHash = UtilityHash::fnv1a64(exchangeConfig, length);
+    if (exchangedDataHash == m_compiled->key && !m_compiled->datapointIds.empty()) {
+        m_lastDelta = Delta();
+        m_lastDelta.unchanged = static_cast<uint32_t>(m_compiled->datapointIds.size());
+        UtilityPivot::log_debug("%s Exchanged data unchanged", beforeLog.c_str());
+        return true;
+    }
+    m_loadedFromCache = false;
 
-    m_connectionLossTracking = false;
+    // Exchanged data already compiled by another instance
+    CompiledConfigRegistry& registry = CompiledConfigRegistry::getInstance();
+    std::shared_ptr<const Compiled> shared = registry.find(exchangedDataHash);
+    if (shared) {
+        m_attachCompiled(shared, true);
+        UtilityPivot::log_debug("%s Exchanged data shared with another instance", beforeLog.c_str());
+        return true;
+    }
 
-    if (document.Parse(exchangeConfig.c_str()).HasParseError()) {
+    // At startup, load the result of a previous import of the same exchanged_data
+    std::string cachePath;
+    bool cacheValid = false;
+    if (!m_compiledCacheDir.empty()) {
+        cachePath = CompiledConfigFile::getPath(m_compiledCacheDir, exchangedDataHash);
+        cacheValid = access(cachePath.c_str(), F_OK) == 0;
+        if (cacheValid && m_compiled->datapointIds.empty()) {
+            std::shared_ptr<Compiled> loaded = std::make_shared<Compiled>();
+            if (CompiledConfigFile::read(cachePath, exchangedDataHash, *loaded)) {
+                m_loadedFromCache = true;
+                m_attachCompiled(registry.publish(loaded), true);
+                UtilityPivot::log_info("%s %u datapoints loaded from %s", beforeLog.c_str(), m_lastDelta.added,
+                                       cachePath.c_str());
+                return true;
+            }
+            cacheValid = false;
+        }
+    }
+    rapidjson::Document document;
+
+    if (document.Parse(exchangeConfig, length).HasParseError()) {
         UtilityPivot::log_fatal("%s Parsing error in data exchange configuration", beforeLog.c_str());
-        return;
+        return m_rejectExchangedData(keepOnError);
     }
 
     if (!document.IsObject()) {
         UtilityPivot::log_fatal("%s Root element is not an object", beforeLog.c_str());
-        return;
+        return m_rejectExchangedData(keepOnError);
     }
 
     if (!document.HasMember(ConstantsSystem::JsonExchangedData) || !document[ConstantsSystem::JsonExchangedData].IsObject()) {
         UtilityPivot::log_fatal("%s exchanged_data not found in root object or is not an object", beforeLog.c_str());
-        return;
+        return m_rejectExchangedData(keepOnError);
     }
     const rapidjson::Value& exchangeData = document[ConstantsSystem::JsonExchangedData];
 
     if (!exchangeData.HasMember(ConstantsSystem::JsonDatapoints) || !exchangeData[ConstantsSystem::JsonDatapoints].IsArray()) {
         UtilityPivot::log_fatal("%s datapoints not found in exchanged_data or is not an array", beforeLog.c_str());
-        return;
+        return m_rejectExchangedData(keepOnError);
     }
     const rapidjson::Value& datapoints = exchangeData[ConstantsSystem::JsonDatapoints];
 
-    bool foundPrtInf = false;
+    // The current table may be used by other instances, the changes are applied to a copy
+    std::shared_ptr<Compiled> compiled = std::make_shared<Compiled>(*m_compiled);
+    compiled->key = exchangedDataHash;
+    m_lastDelta = Delta();
+    std::vector<char> seen(compiled->datapoints.size(), 0);
+    std::vector<uint32_t> stale;
+    std::vector<ProtocolPoint> inserted;
+    std::vector<ProtocolPoint> points;
     for (const rapidjson::Value& datapoint : datapoints.GetArray()) {
-        foundPrtInf = m_importDatapoint(datapoint);
-        if (foundPrtInf) {
+        Datapoint entry;
+        points.clear();
+        if (m_importDatapoint(datapoint, *compiled, entry, points)) {
+            m_applyDatapoint(*compiled, std::move(entry), points, seen, stale, inserted);
+        }
+    }
+
+    // Datapoints which are not in the new configuration
+    for (uint32_t id = 0; id < compiled->datapoints.size(); id++) {
+        Datapoint& datapoint = compiled->datapoints[id];
+        if (!datapoint.active || seen[id]) {
+            continue;
+        }
+        if (datapoint.prtInf) {
+            stale.push_back(id);
+            compiled->prtInfCount--;
+        }
+        compiled->datapointIds.erase(datapoint.pivotId);
+        datapoint = Datapoint();
+        datapoint.active = false;
+        compiled->freeDatapoints.push_back(id);
+        m_lastDelta.removed++;
+    }
+    m_updateIndex(*compiled, stale, inserted);
+    buildSubtypeIndex(*compiled);
+
+    UtilityPivot::log_debug("%s %u datapoints added, %u removed, %u changed, %u unchanged", beforeLog.c_str(),
+                            m_lastDelta.added, m_lastDelta.removed, m_lastDelta.changed, m_lastDelta.unchanged);
+    m_attachCompiled(registry.publish(compiled), false);
+    UtilityPivot::log_debug("%s Connection loss tracking is %s", beforeLog.c_str(), m_connectionLossTracking?"active":"inactive");
+
+    if (!cachePath.empty() && !cacheValid &&
+        CompiledConfigFile::write(cachePath, exchangedDataHash, *m_compiled)) {
+        CompiledConfigFile::prune(m_compiledCacheDir);
+    }
+    return true;
+}
+
+/**
+ * Import Exchanged_data from a file, which is read in a buffer: an editor may truncate or rewrite the
+ * file at any time, and a mapping of it would fault past its new end
+ *
+ * @param path : path of the file
+ * @return false if the file cannot be read or is not a valid exchanged_data, the current configuration
+ *         is then kept
+ */
+bool ConfigPlugin::importExchangedDataFile(const std::string& path) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::importExchangedDataFile :";
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        UtilityPivot::log_error("%s Unable to open %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0) {
+        UtilityPivot::log_error("%s %s is not a regular file or is empty", beforeLog.c_str(), path.c_str());
+        close(fd);
+        return false;
+    }
+    size_t length = static_cast<size_t>(status.st_size);
+    std::string content(length, '\0');
+    size_t offset = 0;
+    while (offset < length) {
+        ssize_t count = read(fd, &content[offset], length - offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
             break;
         }
-        
+        offset += static_cast<size_t>(count);
+    }
+    char extra;
+    bool complete = offset == length && read(fd, &extra, 1) == 0;
+    close(fd);
+    if (!complete) {
+        // Modified while read, the watcher imports it again once it is written
+        UtilityPivot::log_warn("%s %s changed while read, the current exchanged_data is kept", beforeLog.c_str(),
+                               path.c_str());
+        return false;
+    }
+    SYSTEMSPR_PROBE1(import__start, length);
+    bool imported = m_importExchangedData(content.data(), length, true);
+    SYSTEMSPR_PROBE4(import__done, m_lastDelta.added, m_lastDelta.removed, m_lastDelta.changed,
+                     m_lastDelta.unchanged);
+    if (!imported) {
+        UtilityPivot::log_error("%s %s is not a valid exchanged_data, the current one is kept", beforeLog.c_str(),
+                                path.c_str());
+    }
+    return imported;
+}
+
+/**
+ * Reject an exchanged_data which is not valid
+ *
+ * @param keepOnError : keep the current datapoints instead of clearing them
+ * @return false
+ */
+bool ConfigPlugin::m_rejectExchangedData(bool keepOnError) {
+    if (keepOnError) {
+        m_lastDelta = Delta();
+        m_lastDelta.unchanged = static_cast<uint32_t>(m_compiled->datapointIds.size());
+    }
+    else {
+        m_clearDatapoints();
+    }
+    return false;
+}
+
+/**
+ * Use a compiled exchanged_data and resolve the connections against it
+ *
+ * @param compiled : compiled exchanged_data
+ * @param computeDelta : compute the changes from the current compiled exchanged_data
+ */
+void ConfigPlugin::m_attachCompiled(const std::shared_ptr<const Compiled>& compiled, bool computeDelta) {
+    if (computeDelta) {
+        m_lastDelta = Delta();
+        for (const auto& entry : compiled->datapointIds) {
+            auto current = m_compiled->datapointIds.find(entry.first);
+            if (current == m_compiled->datapointIds.end()) {
+                m_lastDelta.added++;
+            }
+            else if (m_compiled->datapoints[current->second].contentHash == compiled->datapoints[entry.second].contentHash) {
+                m_lastDelta.unchanged++;
+            }
+            else {
+                m_lastDelta.changed++;
+            }
+        }
+        m_lastDelta.removed = static_cast<uint32_t>(m_compiled->datapointIds.size()) - m_lastDelta.unchanged -
+                              m_lastDelta.changed;
+    }
+    m_compiled = compiled;
+    m_connectionLossTracking = m_compiled->prtInfCount > 0;
+    m_compileConnections();
+    m_updateFingerprint();
+}
+
+/**
+ * Remove all the datapoints
+ */
+void ConfigPlugin::m_clearDatapoints() {
+    m_lastDelta = Delta();
+    m_lastDelta.removed = static_cast<uint32_t>(m_compiled->datapointIds.size());
+    m_attachCompiled(std::make_shared<Compiled>(), false);
+}
+
+/**
+ * Compare an imported datapoint to the current one with the same pivot_id and apply the difference
+ *
+ * @param compiled : table being updated
+ * @param entry : imported datapoint
+ * @param points : protocol addresses of the imported datapoint if it is a prt.inf
+ * @param seen : datapoints of the current configuration found in the new one
+ * @param stale : datapoints whose addresses are removed from the prt.inf index
+ * @param inserted : addresses added to the prt.inf index
+ */
+void ConfigPlugin::m_applyDatapoint(Compiled& compiled, Datapoint&& entry, std::vector<ProtocolPoint>& points,
+                                    std::vector<char>& seen, std::vector<uint32_t>& stale,
+                                    std::vector<ProtocolPoint>& inserted) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::m_applyDatapoint :";
+    uint32_t id;
+    auto existing = compiled.datapointIds.find(entry.pivotId);
+    if (existing != compiled.datapointIds.end()) {
+        id = existing->second;
+        if (seen[id]) {
+            UtilityPivot::log_error("%s pivot_id %s is defined more than once, ignoring", beforeLog.c_str(),
+                                    entry.pivotId.c_str());
+            return;
+        }
+        seen[id] = 1;
+        Datapoint& current = compiled.datapoints[id];
+        if (current.contentHash == entry.contentHash) {
+            m_lastDelta.unchanged++;
+            return;
+        }
+        m_lastDelta.changed++;
+        if (current.prtInf) {
+            stale.push_back(id);
+            compiled.prtInfCount--;
+        }
+        current = std::move(entry);
+    }
+    else {
+        if (!compiled.freeDatapoints.empty()) {
+            id = compiled.freeDatapoints.back();
+            compiled.freeDatapoints.pop_back();
+            compiled.datapoints[id] = std::move(entry);
+        }
+        else {
+            id = static_cast<uint32_t>(compiled.datapoints.size());
+            compiled.datapoints.push_back(std::move(entry));
+            seen.push_back(0);
+        }
+        seen[id] = 1;
+        compiled.datapointIds.emplace(compiled.datapoints[id].pivotId, id);
+        m_lastDelta.added++;
+    }
+    if (compiled.datapoints[id].prtInf) {
+        compiled.prtInfCount++;
+        for (ProtocolPoint& point : points) {
+            point.datapoint = id;
+            inserted.push_back(point);
+        }
+    }
+}
+
+/**
+ * Remove the addresses of the stale datapoints from the prt.inf index and merge the inserted ones
+ */
+void ConfigPlugin::m_updateIndex(Compiled& compiled, const std::vector<uint32_t>& stale,
+                                 std::vector<ProtocolPoint>& inserted) {
+    auto lower = [](const ProtocolPoint& a, const ProtocolPoint& b) {
+        if (a.protocol != b.protocol) {
+            return a.protocol < b.protocol;
+        }
+        return a.address != b.address ? a.address < b.address : a.datapoint < b.datapoint;
+    };
+    std::vector<ProtocolPoint>& index = compiled.prtInfIndex;
+    if (!stale.empty()) {
+        std::vector<char> staleMark(compiled.datapoints.size(), 0);
+        for (uint32_t id : stale) {
+            staleMark[id] = 1;
+        }
+        // The points of a changed datapoint are inserted again below
+        index.erase(std::remove_if(index.begin(), index.end(), [&staleMark](const ProtocolPoint& point) {
+            return staleMark[point.datapoint] != 0;
+        }), index.end());
+    }
+    if (!inserted.empty()) {
+        std::sort(inserted.begin(), inserted.end(), lower);
+        size_t middle = index.size();
+        index.insert(index.end(), inserted.begin(), inserted.end());
+        std::inplace_merge(index.begin(), index.begin() + middle, index.end(), lower);
     }
-    UtilityPivot::log_debug("%s Connection loss tracking is %s", beforeLog.c_str(), foundPrtInf?"active":"inactive");
-    m_connectionLossTracking = foundPrtInf;
+}
+
+/**
+ * Find a datapoint by pivot_id
+ *
+ * @param pivotId : pivot_id of the datapoint
+ * @return The identifier of the datapoint in getDatapoints, NoDatapoint if not found
+ */
+uint32_t ConfigPlugin::findDatapoint(const std::string& pivotId) const {
+    auto found = m_compiled->datapointIds.find(pivotId);
+    return found == m_compiled->datapointIds.end() ? NoDatapoint : found->second;
 }
 
 /**
  * Import data from a single datapoint of exchanged data
  * 
  * @param datapoint : datapoint to parse and import
+ * @param compiled : table receiving the protocol names
+ * @param entry : imported datapoint
+ * @param points : protocol addresses of the datapoint if it is a prt.inf, without datapoint identifier
+ * @return true if the datapoint is a valid TS
 */
-bool ConfigPlugin::m_importDatapoint(const rapidjson::Value& datapoint) {
+bool ConfigPlugin::m_importDatapoint(const rapidjson::Value& datapoint, Compiled& compiled, Datapoint& entry,
+                                     std::vector<ProtocolPoint>& points) {
 
     std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::m_importDatapoint :";
     if (!datapoint.IsObject()) {
@@ -83,38 +467,434 @@ bool ConfigPlugin::m_importDatapoint(const rapidjson::Value& datapoint) {
         UtilityPivot::log_error("%s pivot_id not found in datapoint or is not a string", beforeLog.c_str());
         return false;
     }
-    std::string pivot_id = datapoint[ConstantsSystem::JsonPivotId].GetString();
+    entry.pivotId = datapoint[ConstantsSystem::JsonPivotId].GetString();
+    entry.contentHash = hashValue(datapoint);
 
     if (!datapoint.HasMember(ConstantsSystem::JsonPivotSubtypes) || !datapoint[ConstantsSystem::JsonPivotSubtypes].IsArray()) {
-        // No pivot subtypes, nothing to do
-        return false;
+        // No pivot subtypes, nothing more to do
+        return true;
     }
 
     if (!datapoint.HasMember(ConstantsSystem::JsonLabel) || !datapoint[ConstantsSystem::JsonLabel].IsString()) {
         UtilityPivot::log_error("%s label not found in datapoint or is not a string", beforeLog.c_str());
         return false;
     }
-    std::string label = datapoint[ConstantsSystem::JsonLabel].GetString();
+    entry.label = datapoint[ConstantsSystem::JsonLabel].GetString();
 
     auto subtypes = datapoint[ConstantsSystem::JsonPivotSubtypes].GetArray();
 
-    bool foundPrtInf = false;
     for (rapidjson::Value::ConstValueIterator itr = subtypes.Begin(); itr != subtypes.End(); ++itr) {
         if (!(*itr).IsString()) {
             continue;
         }
         std::string s = (*itr).GetString();
-        if(s == "prt.inf") {
-            foundPrtInf = true;
-            break;
+        uint32_t subtype = m_internSubtype(compiled, s);
+        if (subtype == NoSubtype) {
+            UtilityPivot::log_error("%s more than %u pivot_subtypes, %s of %s is ignored", beforeLog.c_str(),
+                                    MaxSubtypes, s.c_str(), entry.pivotId.c_str());
+            continue;
         }
+        entry.subtypeMask |= 1ULL << subtype;
+        if (s == ConstantsSystem::JsonPrtInf) {
+            entry.prtInf = true;
+        }
+    }
+
+    if (!entry.prtInf ||
+        !datapoint.HasMember(ConstantsSystem::JsonProtocols) || !datapoint[ConstantsSystem::JsonProtocols].IsArray()) {
+        return true;
+    }
+    for (const rapidjson::Value& protocol : datapoint[ConstantsSystem::JsonProtocols].GetArray()) {
+        if (!protocol.IsObject() || !protocol.HasMember(ConstantsSystem::JsonProtocolName) ||
+            !protocol[ConstantsSystem::JsonProtocolName].IsString()) {
+            UtilityPivot::log_error("%s protocol of %s has no name", beforeLog.c_str(), entry.pivotId.c_str());
+            continue;
+        }
+        ProtocolPoint point;
+        point.protocol = m_internProtocol(compiled, protocol[ConstantsSystem::JsonProtocolName].GetString());
+        point.datapoint = NoDatapoint;
+        point.address = NonNumericAddress;
+        if (protocol.HasMember(ConstantsSystem::JsonProtocolAddress)) {
+            const rapidjson::Value& address = protocol[ConstantsSystem::JsonProtocolAddress];
+            if (address.IsUint64()) {
+                point.address = address.GetUint64();
+            }
+            else if (address.IsString() && address.GetStringLength() > 0) {
+                char *end = nullptr;
+                errno = 0;
+                unsigned long long value = strtoull(address.GetString(), &end, 10);
+                if (errno == 0 && *end == '\0' && isdigit(static_cast<unsigned char>(address.GetString()[0]))) {
+                    point.address = value;
+                }
+            }
+        }
+        points.push_back(point);
+    }
+    return true;
+}
+
+/**
+ * Return the identifier of a protocol name, adding it to the protocol table if needed
+ */
+uint32_t ConfigPlugin::m_internProtocol(Compiled& compiled, const std::string& name) {
+    for (uint32_t i = 0; i < compiled.protocols.size(); i++) {
+        if (compiled.protocols[i] == name) {
+            return i;
+        }
+    }
+    compiled.protocols.push_back(name);
+    return static_cast<uint32_t>(compiled.protocols.size() - 1);
+}
+
+/**
+ * Return the identifier of a subtype, adding it to the subtype table if needed
+ *
+ * @return NoSubtype if the table already holds MaxSubtypes subtypes
+ */
+uint32_t ConfigPlugin::m_internSubtype(Compiled& compiled, const std::string& name) {
+    auto found = compiled.subtypeIds.find(name);
+    if (found != compiled.subtypeIds.end()) {
+        return found->second;
+    }
+    if (compiled.subtypes.size() >= MaxSubtypes) {
+        return NoSubtype;
+    }
+    uint32_t id = static_cast<uint32_t>(compiled.subtypes.size());
+    compiled.subtypes.push_back(name);
+    compiled.subtypeIds.emplace(name, id);
+    return id;
+}
+
+/**
+ * Build the list of the active datapoints of each subtype from the subtype masks of the datapoints
+ *
+ * @param compiled : table whose subtypes and datapoints are set
+ */
+void ConfigPlugin::buildSubtypeIndex(Compiled& compiled) {
+    compiled.subtypeIds.clear();
+    for (uint32_t i = 0; i < compiled.subtypes.size(); i++) {
+        compiled.subtypeIds.emplace(compiled.subtypes[i], i);
+    }
+    std::vector<uint32_t> counts(compiled.subtypes.size(), 0);
+    for (const Datapoint& datapoint : compiled.datapoints) {
+        for (uint64_t mask = datapoint.active ? datapoint.subtypeMask : 0; mask != 0; mask &= mask - 1) {
+            counts[static_cast<uint32_t>(__builtin_ctzll(mask))]++;
+        }
+    }
+    compiled.subtypeIndex.assign(compiled.subtypes.size(), std::vector<uint32_t>());
+    for (uint32_t i = 0; i < compiled.subtypes.size(); i++) {
+        compiled.subtypeIndex[i].reserve(counts[i]);
+    }
+    // Datapoints are visited in order of identifier, each list is sorted
+    for (uint32_t id = 0; id < compiled.datapoints.size(); id++) {
+        const Datapoint& datapoint = compiled.datapoints[id];
+        for (uint64_t mask = datapoint.active ? datapoint.subtypeMask : 0; mask != 0; mask &= mask - 1) {
+            compiled.subtypeIndex[static_cast<uint32_t>(__builtin_ctzll(mask))].push_back(id);
+        }
+    }
+}
+
+/**
+ * Find a subtype by name
+ *
+ * @param subtype : pivot_subtypes entry
+ * @return The identifier of the subtype, NoSubtype if no datapoint has it
+ */
+uint32_t ConfigPlugin::findSubtype(const std::string& subtype) const {
+    auto found = m_compiled->subtypeIds.find(subtype);
+    return found == m_compiled->subtypeIds.end() ? NoSubtype : found->second;
+}
+
+/**
+ * Datapoints having a subtype
+ *
+ * @param subtypeId : identifier of the subtype
+ * @return The sorted identifiers of the datapoints, empty if the subtype is unknown
+ */
+const std::vector<uint32_t>& ConfigPlugin::getSubtypeDatapoints(uint32_t subtypeId) const {
+    static const std::vector<uint32_t> none;
+    return subtypeId < m_compiled->subtypeIndex.size() ? m_compiled->subtypeIndex[subtypeId] : none;
+}
+
+/**
+ * Import the connection assets and the protocol addresses reachable through each of them
+ *
+ * @param connectionsConfig : configuration of the connections as a string
+ */
+void ConfigPlugin::importConnections(const std::string & connectionsConfig) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::importConnections :";
+    rapidjson::Document document;
+
+    m_connectionDefinitions.clear();
+
+    if (document.Parse(connectionsConfig.c_str()).HasParseError() || !document.IsObject() ||
+        !document.HasMember(ConstantsSystem::JsonConnections) || !document[ConstantsSystem::JsonConnections].IsArray()) {
+        UtilityPivot::log_error("%s connections not found in root object or is not an array", beforeLog.c_str());
+    }
+    else {
+        for (const rapidjson::Value& connection : document[ConstantsSystem::JsonConnections].GetArray()) {
+            if (!connection.IsObject() ||
+                !connection.HasMember(ConstantsSystem::JsonConnectionAsset) ||
+                !connection[ConstantsSystem::JsonConnectionAsset].IsString() ||
+                !connection.HasMember(ConstantsSystem::JsonConnectionProtocol) ||
+                !connection[ConstantsSystem::JsonConnectionProtocol].IsString()) {
+                UtilityPivot::log_error("%s connection without asset or protocol, ignoring", beforeLog.c_str());
+                continue;
+            }
+            ConnectionDefinition definition;
+            definition.asset = connection[ConstantsSystem::JsonConnectionAsset].GetString();
+            definition.protocol = connection[ConstantsSystem::JsonConnectionProtocol].GetString();
+            bool duplicate = definition.asset.empty();
+            for (const ConnectionDefinition& other : m_connectionDefinitions) {
+                duplicate = duplicate || other.asset == definition.asset;
+            }
+            if (duplicate) {
+                UtilityPivot::log_error("%s connection asset '%s' is empty or already defined, ignoring",
+                                        beforeLog.c_str(), definition.asset.c_str());
+                continue;
+            }
+            if (connection.HasMember(ConstantsSystem::JsonAddressRanges) &&
+                connection[ConstantsSystem::JsonAddressRanges].IsArray()) {
+                for (const rapidjson::Value& range : connection[ConstantsSystem::JsonAddressRanges].GetArray()) {
+                    if (!range.IsObject() ||
+                        !range.HasMember(ConstantsSystem::JsonRangeFrom) || !range[ConstantsSystem::JsonRangeFrom].IsUint64() ||
+                        !range.HasMember(ConstantsSystem::JsonRangeTo) || !range[ConstantsSystem::JsonRangeTo].IsUint64() ||
+                        range[ConstantsSystem::JsonRangeTo].GetUint64() < range[ConstantsSystem::JsonRangeFrom].GetUint64()) {
+                        UtilityPivot::log_error("%s invalid address range for %s, ignoring",
+                                                beforeLog.c_str(), definition.asset.c_str());
+                        continue;
+                    }
+                    definition.addressRanges.emplace_back(range[ConstantsSystem::JsonRangeFrom].GetUint64(),
+                                                          range[ConstantsSystem::JsonRangeTo].GetUint64());
+                }
+                if (definition.addressRanges.empty()) {
+                    UtilityPivot::log_error("%s no valid address range for %s, ignoring",
+                                            beforeLog.c_str(), definition.asset.c_str());
+                    continue;
+                }
+            }
+            m_connectionDefinitions.push_back(std::move(definition));
+        }
+    }
+    m_compileConnections();
+    m_updateFingerprint();
+}
+
+/**
+ * Resolve the address ranges of the connections into ranges of the prt.inf protocol index
+ */
+void ConfigPlugin::m_compileConnections() {
+    m_connections.clear();
+    m_connections.reserve(m_connectionDefinitions.size());
+    auto compare = [](const ProtocolPoint& point, const std::pair<uint32_t, uint64_t>& key) {
+        return point.protocol != key.first ? point.protocol < key.first : point.address < key.second;
+    };
+    for (const ConnectionDefinition& definition : m_connectionDefinitions) {
+        Connection connection;
+        connection.asset = definition.asset;
+        connection.protocol = definition.protocol;
+        const std::vector<std::string>& protocols = m_compiled->protocols;
+        const std::vector<ProtocolPoint>& index = m_compiled->prtInfIndex;
+        auto protocol = std::find(protocols.begin(), protocols.end(), definition.protocol);
+        if (protocol != protocols.end()) {
+            uint32_t protocolId = static_cast<uint32_t>(protocol - protocols.begin());
+            std::vector<std::pair<uint64_t, uint64_t>> ranges = definition.addressRanges;
+            if (ranges.empty()) {
+                ranges.emplace_back(0, NonNumericAddress);
+            }
+            std::sort(ranges.begin(), ranges.end());
+            for (const auto& range : ranges) {
+                auto first = std::lower_bound(index.begin(), index.end(),
+                                              std::make_pair(protocolId, range.first), compare);
+                auto last = first;
+                while (last != index.end() && last->protocol == protocolId && last->address <= range.second) {
+                    ++last;
+                }
+                IndexRange indexRange{static_cast<uint32_t>(first - index.begin()),
+                                      static_cast<uint32_t>(last - index.begin())};
+                if (indexRange.begin == indexRange.end) {
+                    continue;
+                }
+                if (!connection.ranges.empty() && indexRange.begin <= connection.ranges.back().end) {
+                    connection.ranges.back().end = std::max(connection.ranges.back().end, indexRange.end);
+                }
+                else {
+                    connection.ranges.push_back(indexRange);
+                }
+            }
+        }
+        m_connections.push_back(std::move(connection));
     }
+    m_updateTrackedAssets();
+}
 
-    return foundPrtInf;
+/**
+ * Find the connection of an asset
+ *
+ * @param asset : name of the connection asset
+ * @return The connection, nullptr if the asset is not a connection
+ */
+const ConfigPlugin::Connection* ConfigPlugin::findConnection(const std::string& asset) const {
+    for (const Connection& connection : m_connections) {
+        if (connection.asset == asset) {
+            return &connection;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Datapoints reachable through a connection
+ *
+ * @param connection : connection returned by findConnection or getConnections
+ * @return The sorted identifiers of the prt.inf datapoints in getDatapoints
+ */
+std::vector<uint32_t> ConfigPlugin::getConnectionDatapoints(const Connection& connection) const {
+    std::vector<uint32_t> datapoints;
+    for (const IndexRange& range : connection.ranges) {
+        for (uint32_t i = range.begin; i < range.end; i++) {
+            datapoints.push_back(m_compiled->prtInfIndex[i].datapoint);
+        }
+    }
+    std::sort(datapoints.begin(), datapoints.end());
+    datapoints.erase(std::unique(datapoints.begin(), datapoints.end()), datapoints.end());
+    return datapoints;
 }
 
 void ConfigPlugin::importAsset(const std::string & assetConfig) {
     std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::importAsset :";
     m_trackedAsset = assetConfig;
     UtilityPivot::log_debug("%s Connection loss asset tracked: %s", beforeLog.c_str(), m_trackedAsset.c_str());
+    m_updateTrackedAssets();
+    m_updateFingerprint();
+}
+
+/**
+ * Assets whose south_event are evaluated: the tracked asset followed by the connection assets
+ */
+void ConfigPlugin::m_updateTrackedAssets() {
+    m_trackedAssets.clear();
+    if (!m_trackedAsset.empty()) {
+        m_trackedAssets.push_back(m_trackedAsset);
+    }
+    for (const Connection& connection : m_connections) {
+        if (connection.asset != m_trackedAsset) {
+            m_trackedAssets.push_back(connection.asset);
+        }
+    }
+    m_compileTopology();
+}
+
+/**
+ * Import the gateway topology: the connection assets lost with each parent asset
+ *
+ * @param topologyConfig : configuration topology as a string
+ */
+void ConfigPlugin::importTopology(const std::string & topologyConfig) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::importTopology :";
+    rapidjson::Document document;
+
+    m_topologyEdges.clear();
+    if (document.Parse(topologyConfig.c_str()).HasParseError() || !document.IsObject() ||
+        !document.HasMember(ConstantsSystem::JsonTopology) || !document[ConstantsSystem::JsonTopology].IsArray()) {
+        UtilityPivot::log_error("%s topology not found in root object or is not an array", beforeLog.c_str());
+    }
+    else {
+        for (const rapidjson::Value& node : document[ConstantsSystem::JsonTopology].GetArray()) {
+            if (!node.IsObject() ||
+                !node.HasMember(ConstantsSystem::JsonTopologyParent) || !node[ConstantsSystem::JsonTopologyParent].IsString() ||
+                !node.HasMember(ConstantsSystem::JsonTopologyChildren) || !node[ConstantsSystem::JsonTopologyChildren].IsArray()) {
+                UtilityPivot::log_error("%s topology node without parent or children, ignoring", beforeLog.c_str());
+                continue;
+            }
+            std::string parent = node[ConstantsSystem::JsonTopologyParent].GetString();
+            for (const rapidjson::Value& child : node[ConstantsSystem::JsonTopologyChildren].GetArray()) {
+                if (child.IsString()) {
+                    m_topologyEdges.emplace_back(parent, child.GetString());
+                }
+            }
+        }
+    }
+    m_compileTopology();
+}
+
+/**
+ * Compile the topology into the descendants of each tracked asset, stored in a single array.
+ * Assets which are not tracked are ignored, and a topology with a cycle is dropped.
+ */
+void ConfigPlugin::m_compileTopology() {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConfigPlugin::m_compileTopology :";
+    uint32_t count = static_cast<uint32_t>(m_trackedAssets.size());
+    m_descendantRanges.assign(count, IndexRange{0, 0});
+    m_descendants.clear();
+    if (m_topologyEdges.empty()) {
+        return;
+    }
+
+    std::unordered_map<std::string, uint32_t> indexes;
+    for (uint32_t i = 0; i < count; i++) {
+        indexes.emplace(m_trackedAssets[i], i);
+    }
+    // Children of each asset in compressed rows
+    std::vector<uint32_t> childBegin(count + 1, 0);
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (const auto& edge : m_topologyEdges) {
+        auto parent = indexes.find(edge.first);
+        auto child = indexes.find(edge.second);
+        if (parent == indexes.end() || child == indexes.end()) {
+            UtilityPivot::log_warn("%s %s -> %s: asset not tracked, ignoring", beforeLog.c_str(),
+                                   edge.first.c_str(), edge.second.c_str());
+            continue;
+        }
+        edges.emplace_back(parent->second, child->second);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    std::vector<uint32_t> children;
+    children.reserve(edges.size());
+    for (const auto& edge : edges) {
+        childBegin[edge.first + 1]++;
+        children.push_back(edge.second);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        childBegin[i + 1] += childBegin[i];
+    }
+
+    // Depth-first walk from each asset, the visit mark of a walk is the index of its root
+    std::vector<uint32_t> visited(count, UINT32_MAX);
+    std::vector<uint32_t> stack;
+    for (uint32_t root = 0; root < count; root++) {
+        uint32_t begin = static_cast<uint32_t>(m_descendants.size());
+        stack.assign(children.begin() + childBegin[root], children.begin() + childBegin[root + 1]);
+        visited[root] = root;
+        while (!stack.empty()) {
+            uint32_t asset = stack.back();
+            stack.pop_back();
+            if (asset == root) {
+                UtilityPivot::log_error("%s %s is its own descendant, topology ignored", beforeLog.c_str(),
+                                        m_trackedAssets[root].c_str());
+                m_descendantRanges.assign(count, IndexRange{0, 0});
+                m_descendants.clear();
+                return;
+            }
+            if (visited[asset] == root) {
+                continue;
+            }
+            visited[asset] = root;
+            m_descendants.push_back(asset);
+            stack.insert(stack.end(), children.begin() + childBegin[asset], children.begin() + childBegin[asset + 1]);
+        }
+        std::sort(m_descendants.begin() + begin, m_descendants.end());
+        m_descendantRanges[root] = IndexRange{begin, static_cast<uint32_t>(m_descendants.size())};
+    }
+}
+
+/**
+ * Hash of the configuration items the evaluation of a reading depends on
+ */
+void ConfigPlugin::m_updateFingerprint() {
+    m_fingerprint = UtilityHash::fnv1a64(m_connectionLossTracking ? "1" : "0", 1);
+    for (const std::string& asset : m_trackedAssets) {
+        m_fingerprint = UtilityHash::fnv1a64(asset.c_str(), asset.size() + 1, m_fingerprint);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,249 @@
+/*
+ * Persistent connection state of the tracked assets
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "connectionStateStore.h"
+#include "constantsSystem.h"
+#include "utilityHash.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t ConnectionStateStore::Magic;
+constexpr uint16_t ConnectionStateStore::Version;
+constexpr uint32_t ConnectionStateStore::Capacity;
+constexpr size_t   ConnectionStateStore::MaxAssetLength;
+constexpr uint32_t ConnectionStateStore::SyncInterval;
+
+ConnectionStateStore::~ConnectionStateStore() {
+    close();
+}
+
+/**
+ * Map the state file, creating or resetting it when it does not match the current layout
+ *
+ * @param path : path of the state file
+ * @return true if the file is mapped
+ */
+bool ConnectionStateStore::open(const std::string& path) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConnectionStateStore::open :";
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_mapping) {
+        return true;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        UtilityPivot::log_warn("%s Unable to open %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+
+    size_t expectedSize = sizeof(Header) + Capacity * sizeof(Entry);
+    struct stat st;
+    bool resized = false;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expectedSize) {
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(expectedSize)) != 0) {
+            UtilityPivot::log_warn("%s Unable to size %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+            ::close(fd);
+            return false;
+        }
+        resized = true;
+    }
+
+    void *mapping = mmap(nullptr, expectedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        UtilityPivot::log_warn("%s Unable to map %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingSize = expectedSize;
+    m_header = static_cast<Header *>(mapping);
+    m_entries = reinterpret_cast<Entry *>(static_cast<char *>(mapping) + sizeof(Header));
+
+    if (resized || m_header->magic != Magic || m_header->version != Version ||
+        m_header->entrySize != sizeof(Entry) || m_header->capacity != Capacity) {
+        if (!resized) {
+            UtilityPivot::log_warn("%s %s has an unknown layout, resetting it", beforeLog.c_str(), path.c_str());
+        }
+        m_initialize();
+    }
+    UtilityPivot::log_debug("%s %u connection states loaded from %s", beforeLog.c_str(), m_header->count, path.c_str());
+    return true;
+}
+
+/**
+ * Flush and unmap the state file
+ */
+void ConnectionStateStore::close() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_mapping) {
+        return;
+    }
+    msync(m_mapping, m_mappingSize, MS_SYNC);
+    munmap(m_mapping, m_mappingSize);
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+    m_entries = nullptr;
+}
+
+/**
+ * Schedule the write back of the mapping to the file
+ */
+void ConnectionStateStore::sync() {
+    if (m_mapping) {
+        msync(m_mapping, m_mappingSize, MS_ASYNC);
+    }
+}
+
+/**
+ * Return the entry of an asset, allocating it if it does not exist yet
+ *
+ * @param asset : name of the connection asset
+ * @return The entry, nullptr if the store is not open or is full
+ */
+ConnectionStateStore::Entry* ConnectionStateStore::acquire(const std::string& asset) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_entries) {
+        return nullptr;
+    }
+    uint64_t hash = m_hashAsset(asset);
+    for (uint32_t probe = 0; probe < Capacity; probe++) {
+        Entry& entry = m_entries[(hash + probe) % Capacity];
+        if (m_matches(entry, hash, asset)) {
+            return &entry;
+        }
+        if (entry.assetHash == 0) {
+            size_t length = std::min(asset.size(), MaxAssetLength);
+            memcpy(entry.asset, asset.data(), length);
+            entry.asset[length] = '\0';
+            entry.assetHash = hash;
+            m_header->count++;
+            return &entry;
+        }
+    }
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ConnectionStateStore::acquire :";
+    UtilityPivot::log_error("%s No free entry for asset %s", beforeLog.c_str(), asset.c_str());
+    return nullptr;
+}
+
+/**
+ * Return the entry of an asset
+ *
+ * @param asset : name of the connection asset
+ * @return The entry, nullptr if the asset is unknown
+ */
+const ConnectionStateStore::Entry* ConnectionStateStore::find(const std::string& asset) const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_entries) {
+        return nullptr;
+    }
+    uint64_t hash = m_hashAsset(asset);
+    for (uint32_t probe = 0; probe < Capacity; probe++) {
+        const Entry& entry = m_entries[(hash + probe) % Capacity];
+        if (entry.assetHash == 0) {
+            return nullptr;
+        }
+        if (m_matches(entry, hash, asset)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Record the statuses of a south_event received for an asset
+ *
+ * @param entry : entry returned by acquire
+ * @param connx : connx_status of the south_event
+ * @param gi : gi_status of the south_event
+ * @param nowNs : realtime of the event in nanoseconds
+ * @return The link state before the update
+ */
+LinkState ConnectionStateStore::update(Entry* entry, ConnxStatus connx, GiStatus gi, uint64_t nowNs) {
+    LinkState previous;
+    LinkState next;
+    {
+        // The next state depends on the previous one, another instance must not update the entry in between
+        std::lock_guard<std::mutex> guard(m_entryMutexes[entry - m_entries]);
+        previous = entry->getLinkState();
+        next = SouthEvent::nextLinkState(previous, connx, gi);
+
+        if (connx != ConnxStatus::None) {
+            entry->connxStatus.store(static_cast<uint8_t>(connx), std::memory_order_relaxed);
+        }
+        if (gi != GiStatus::None) {
+            entry->giStatus.store(static_cast<uint8_t>(gi), std::memory_order_relaxed);
+        }
+        if (next != previous) {
+            entry->linkState.store(static_cast<uint8_t>(next), std::memory_order_relaxed);
+            entry->updatedNs.store(nowNs, std::memory_order_relaxed);
+            entry->lossNotified.store(0, std::memory_order_relaxed);
+            if (next == LinkState::NotConnected) {
+                entry->lossCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    if (next != previous && m_pendingUpdates.fetch_add(1, std::memory_order_relaxed) + 1 >= SyncInterval) {
+        m_pendingUpdates.store(0, std::memory_order_relaxed);
+        sync();
+    }
+    return previous;
+}
+
+/**
+ * Record that the loss of an asset is notified, until its link state changes again
+ *
+ * @param entry : entry returned by acquire
+ */
+void ConnectionStateStore::setLossNotified(Entry* entry) {
+    entry->lossNotified.store(1, std::memory_order_relaxed);
+}
+
+/**
+ * Store shared by all the rule instances of the process, mapped from the plugin data directory
+ */
+ConnectionStateStore& ConnectionStateStore::getInstance() {
+    static ConnectionStateStore instance;
+    static std::once_flag opened;
+    std::call_once(opened, []() {
+        std::string dir = UtilityPivot::getPluginDataDir();
+        if (!dir.empty()) {
+            instance.open(dir + "/connection_state.bin");
+        }
+    });
+    return instance;
+}
+
+uint64_t ConnectionStateStore::m_hashAsset(const std::string& asset) {
+    uint64_t hash = UtilityHash::fnv1a64(asset);
+    return hash == 0 ? 1 : hash;
+}
+
+bool ConnectionStateStore::m_matches(const Entry& entry, uint64_t hash, const std::string& asset) {
+    return entry.assetHash == hash &&
+           strncmp(entry.asset, asset.c_str(), MaxAssetLength) == 0;
+}
+
+void ConnectionStateStore::m_initialize() {
+    memset(m_mapping, 0, m_mappingSize);
+    m_header->magic = Magic;
+    m_header->version = Version;
+    m_header->entrySize = sizeof(Entry);
+    m_header->capacity = Capacity;
+    m_header->count = 0;
+}
@@ -0,0 +1,350 @@
+/*
+ * In-memory trace of the evaluation decisions
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <signal.h>
+#include <thread>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "decisionTrace.h"
+#include "constantsSystem.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t DecisionTrace::RingSize;
+constexpr uint32_t DecisionTrace::MaxRings;
+std::atomic<int> DecisionTrace::m_dumpPipe{-1};
+
+namespace {
+
+/*
+ * Ring written by a single thread. claimed is raised before a slot is written and head
+ * after, so a reader can tell which of the slots it copied may have been overwritten.
+ */
+struct TraceRing {
+    struct Slot {
+        std::atomic<uint64_t> timestampNs;
+        std::atomic<uint64_t> info;         // payload size | decision << 32 | thread id << 40
+    };
+
+    std::atomic<uint64_t> claimed{0};
+    std::atomic<uint64_t> head{0};
+    std::atomic<bool>     owned{false};
+    uint64_t              threadTag{0};     // Thread id of the owner, shifted in place in info
+    Slot                  slots[DecisionTrace::RingSize];
+};
+
+std::mutex                                                   ringsMutex;
+std::array<std::atomic<TraceRing *>, DecisionTrace::MaxRings> rings{};
+std::atomic<uint32_t>                                        ringCount{0};
+
+/*
+ * Ring of the current thread, released for reuse when the thread exits
+ */
+struct RingOwner {
+    TraceRing *ring{nullptr};
+    bool       exhausted{false};
+
+    ~RingOwner() {
+        if (ring) {
+            ring->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local RingOwner ringOwner;
+
+TraceRing *acquireRing() {
+    std::lock_guard<std::mutex> guard(ringsMutex);
+    uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    uint32_t count = ringCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++) {
+        TraceRing *ring = rings[i].load(std::memory_order_relaxed);
+        bool expected = false;
+        if (ring->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            ring->threadTag = static_cast<uint64_t>(tid & 0xFFFFFF) << 40;
+            return ring;
+        }
+    }
+    if (count >= DecisionTrace::MaxRings) {
+        return nullptr;
+    }
+    TraceRing *ring = new TraceRing();
+    ring->owned.store(true, std::memory_order_relaxed);
+    ring->threadTag = static_cast<uint64_t>(tid & 0xFFFFFF) << 40;
+    rings[count].store(ring, std::memory_order_release);
+    ringCount.store(count + 1, std::memory_order_release);
+    return ring;
+}
+
+const char DumpRequest = 1;
+const char DumpStop    = 0;
+
+/*
+ * Dump thread shared by the subscriptions. The pipe is created once and never closed, so a
+ * handler running while the last subscription ends never writes to a reused descriptor.
+ */
+struct SignalDumpState {
+    std::mutex       mutex;
+    int              signalNumber{0};
+    uint32_t         subscribers{0};
+    struct sigaction previous;
+    int              pipeFds[2]{-1, -1};
+    std::thread      thread;
+};
+
+SignalDumpState& signalDumpState() {
+    static SignalDumpState state;
+    return state;
+}
+};
+
+/**
+ * Record the decision of an evaluation in the ring of the calling thread
+ *
+ * @param decision : branch taken by the evaluation
+ * @param payloadSize : size of the evaluated JSON
+ * @param timestampNs : realtime of the evaluation
+ */
+void DecisionTrace::record(EvalDecision decision, uint32_t payloadSize, uint64_t timestampNs) {
+    RingOwner& owner = ringOwner;
+    if (!owner.ring) {
+        if (owner.exhausted) {
+            return;
+        }
+        owner.ring = acquireRing();
+        if (!owner.ring) {
+            owner.exhausted = true;
+            return;
+        }
+    }
+    TraceRing *ring = owner.ring;
+    uint64_t index = ring->head.load(std::memory_order_relaxed);
+    ring->claimed.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceRing::Slot& slot = ring->slots[index & (RingSize - 1)];
+    slot.timestampNs.store(timestampNs, std::memory_order_relaxed);
+    slot.info.store(static_cast<uint64_t>(payloadSize) | (static_cast<uint64_t>(decision) << 32) | ring->threadTag,
+                    std::memory_order_relaxed);
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * Copy the content of all the rings
+ *
+ * @return The recorded decisions sorted by timestamp
+ */
+std::vector<DecisionTrace::Event> DecisionTrace::snapshot() {
+    std::vector<Event> events;
+    uint32_t count = ringCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; i++) {
+        const TraceRing *ring = rings[i].load(std::memory_order_acquire);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = head > RingSize ? head - RingSize : 0;
+        size_t first = events.size();
+        for (uint64_t index = begin; index < head; index++) {
+            const TraceRing::Slot& slot = ring->slots[index & (RingSize - 1)];
+            uint64_t info = slot.info.load(std::memory_order_relaxed);
+            Event event;
+            event.timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+            event.threadId = static_cast<uint32_t>(info >> 40);
+            event.payloadSize = static_cast<uint32_t>(info);
+            event.decision = static_cast<EvalDecision>((info >> 32) & 0xFF);
+            events.push_back(event);
+        }
+        // Drop the slots overwritten by the owner thread during the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = ring->claimed.load(std::memory_order_relaxed);
+        uint64_t firstValid = claimed > RingSize ? claimed - RingSize : 0;
+        if (firstValid > begin) {
+            size_t dropped = static_cast<size_t>(std::min(firstValid - begin, head - begin));
+            events.erase(events.begin() + first, events.begin() + first + dropped);
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.timestampNs < b.timestampNs;
+    });
+    return events;
+}
+
+/**
+ * Write a snapshot of the rings to a text file
+ *
+ * @param path : path of the file to write
+ * @return true if the file was written
+ */
+bool DecisionTrace::dumpToFile(const std::string& path) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - DecisionTrace::dumpToFile :";
+    FILE *file = path.empty() ? nullptr : fopen(path.c_str(), "w");
+    if (!file) {
+        UtilityPivot::log_error("%s Unable to write decision trace to %s", beforeLog.c_str(), path.c_str());
+        return false;
+    }
+    std::vector<Event> events = snapshot();
+    uint64_t counts[static_cast<size_t>(EvalDecision::Count)] = {};
+    fprintf(file, "# timestamp_ns\tthread\tdecision\tpayload_size\n");
+    for (const Event& event : events) {
+        fprintf(file, "%" PRIu64 "\t%u\t%s\t%u\n", event.timestampNs, event.threadId,
+                EvalDecisionName::toString(event.decision), event.payloadSize);
+        if (event.decision < EvalDecision::Count) {
+            counts[static_cast<size_t>(event.decision)]++;
+        }
+    }
+    fprintf(file, "# %zu decisions\n", events.size());
+    for (size_t i = 0; i < static_cast<size_t>(EvalDecision::Count); i++) {
+        if (counts[i] > 0) {
+            fprintf(file, "# %s: %" PRIu64 "\n", EvalDecisionName::toString(static_cast<EvalDecision>(i)), counts[i]);
+        }
+    }
+    fclose(file);
+    UtilityPivot::log_info("%s %zu decisions written to %s", beforeLog.c_str(), events.size(), path.c_str());
+    return true;
+}
+
+/**
+ * Default location of the dumps: decision_trace_<pid>.log in the plugin data directory
+ */
+std::string DecisionTrace::getDefaultDumpPath() {
+    std::string dir = UtilityPivot::getPluginDataDir();
+    if (dir.empty()) {
+        return "";
+    }
+    return dir + "/decision_trace_" + std::to_string(getpid()) + ".log";
+}
+
+/**
+ * Change the signal dumping the trace for this subscription
+ *
+ * @param signalNumber : signal triggering the dump, 0 to stop dumping the trace on a signal
+ * @return true if the trace is dumped on the signal
+ */
+bool DecisionTrace::SignalDump::set(int signalNumber) {
+    if (signalNumber == m_signalNumber) {
+        return true;
+    }
+    if (m_signalNumber != 0) {
+        m_unsubscribeSignal();
+        m_signalNumber = 0;
+    }
+    if (signalNumber != 0) {
+        if (!m_subscribeSignal(signalNumber)) {
+            return false;
+        }
+        m_signalNumber = signalNumber;
+    }
+    return true;
+}
+
+/**
+ * Install the handler of the signal and start the dump thread for the first subscription
+ *
+ * @param signalNumber : signal triggering the dump
+ * @return true if the trace is dumped on the signal
+ */
+bool DecisionTrace::m_subscribeSignal(int signalNumber) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - DecisionTrace::m_subscribeSignal :";
+    SignalDumpState& state = signalDumpState();
+    std::lock_guard<std::mutex> guard(state.mutex);
+    if (state.subscribers > 0) {
+        if (state.signalNumber != signalNumber) {
+            UtilityPivot::log_warn("%s The trace is already dumped on signal %d, signal %d is not used",
+                                   beforeLog.c_str(), state.signalNumber, signalNumber);
+            return false;
+        }
+        state.subscribers++;
+        return true;
+    }
+    if (state.pipeFds[0] < 0) {
+        if (pipe2(state.pipeFds, O_CLOEXEC) != 0) {
+            UtilityPivot::log_error("%s Unable to create the dump pipe: %s", beforeLog.c_str(), strerror(errno));
+            return false;
+        }
+        // The handler never blocks, the requests already in a full pipe are enough for a dump
+        fcntl(state.pipeFds[1], F_SETFL, O_NONBLOCK);
+    }
+    m_dumpPipe.store(state.pipeFds[1], std::memory_order_relaxed);
+    struct sigaction action = {};
+    action.sa_handler = m_signalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(signalNumber, &action, &state.previous) != 0) {
+        UtilityPivot::log_error("%s Unable to handle signal %d: %s", beforeLog.c_str(), signalNumber, strerror(errno));
+        m_dumpPipe.store(-1, std::memory_order_relaxed);
+        return false;
+    }
+    state.signalNumber = signalNumber;
+    state.subscribers = 1;
+    state.thread = std::thread(&DecisionTrace::m_runDump, state.pipeFds[0]);
+    return true;
+}
+
+/**
+ * Restore the previous action of the signal and stop the dump thread with the last subscription
+ */
+void DecisionTrace::m_unsubscribeSignal() {
+    SignalDumpState& state = signalDumpState();
+    std::lock_guard<std::mutex> guard(state.mutex);
+    if (state.subscribers == 0 || --state.subscribers > 0) {
+        return;
+    }
+    sigaction(state.signalNumber, &state.previous, nullptr);
+    m_dumpPipe.store(-1, std::memory_order_relaxed);
+    state.signalNumber = 0;
+    // Queued after the requests received so far, which are dumped first
+    while (write(state.pipeFds[1], &DumpStop, 1) < 0 && (errno == EAGAIN || errno == EINTR)) {
+        std::this_thread::yield();
+    }
+    state.thread.join();
+}
+
+/**
+ * Only writes to the pipe, the dump thread writes the file
+ */
+void DecisionTrace::m_signalHandler(int) {
+    int fd = m_dumpPipe.load(std::memory_order_relaxed);
+    if (fd >= 0) {
+        int savedErrno = errno;
+        ssize_t written = write(fd, &DumpRequest, 1);
+        (void)written;
+        errno = savedErrno;
+    }
+}
+
+/**
+ * Loop of the dump thread: write the trace for the requests read from the pipe until the stop request
+ *
+ * @param readFd : read end of the pipe
+ */
+void DecisionTrace::m_runDump(int readFd) {
+    char requests[64];
+    for (;;) {
+        ssize_t count = read(readFd, requests, sizeof(requests));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return;
+        }
+        // The signals received during a dump are served by a single next dump
+        if (std::find(requests, requests + count, DumpRequest) != requests + count) {
+            dumpToFile(getDefaultDumpPath());
+        }
+        if (std::find(requests, requests + count, DumpStop) != requests + count) {
+            return;
+        }
+    }
+}
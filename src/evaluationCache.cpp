@@ -0,0 +1,72 @@
+/*
+ * Process-wide cache of the evaluation results
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include "evaluationCache.h"
+
+using namespace systemspr;
+
+constexpr uint32_t EvaluationCache::Stripes;
+constexpr uint32_t EvaluationCache::SlotsPerStripe;
+
+/**
+ * Find the result of a previous evaluation of the same reading by the same configuration
+ *
+ * @param payloadHash : hash of the reading
+ * @param payloadSize : size of the reading
+ * @param fingerprint : fingerprint of the configuration
+ * @param result : cached result
+ * @return true if the result was found
+ */
+bool EvaluationCache::lookup(uint64_t payloadHash, uint32_t payloadSize, uint64_t fingerprint, EvalResult& result) {
+    uint64_t key = m_mix(payloadHash, fingerprint);
+    Stripe& stripe = m_stripes[key % Stripes];
+    {
+        std::lock_guard<std::mutex> guard(stripe.mutex);
+        const Slot& slot = stripe.slots[(key / Stripes) % SlotsPerStripe];
+        if (slot.valid && slot.payloadHash == payloadHash && slot.payloadSize == payloadSize &&
+            slot.fingerprint == fingerprint) {
+            result = slot.result;
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * Record the result of an evaluation, replacing the entry using the same slot
+ */
+void EvaluationCache::store(uint64_t payloadHash, uint32_t payloadSize, uint64_t fingerprint, const EvalResult& result) {
+    uint64_t key = m_mix(payloadHash, fingerprint);
+    Stripe& stripe = m_stripes[key % Stripes];
+    std::lock_guard<std::mutex> guard(stripe.mutex);
+    Slot& slot = stripe.slots[(key / Stripes) % SlotsPerStripe];
+    slot.payloadHash = payloadHash;
+    slot.payloadSize = payloadSize;
+    slot.fingerprint = fingerprint;
+    slot.result = result;
+    slot.valid = true;
+}
+
+void EvaluationCache::clear() {
+    for (Stripe& stripe : m_stripes) {
+        std::lock_guard<std::mutex> guard(stripe.mutex);
+        for (Slot& slot : stripe.slots) {
+            slot.valid = false;
+        }
+    }
+}
+
+/**
+ * Cache shared by all the rule instances of the process
+ */
+EvaluationCache& EvaluationCache::getInstance() {
+    static EvaluationCache instance;
+    return instance;
+}
@@ -0,0 +1,128 @@
+/*
+ * Watch of the exchanged_data file
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include "exchangedDataWatcher.h"
+#include "constantsSystem.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t ExchangedDataWatcher::DefaultDebounceMs;
+
+/**
+ * Start watching a file
+ *
+ * @param path : path of the file, which may not exist yet
+ * @param debounceMs : delay without modification before onChange is called
+ * @param onChange : function called by the watch thread when the file was modified
+ * @return false if the directory of the file cannot be watched
+ */
+bool ExchangedDataWatcher::start(const std::string& path, uint32_t debounceMs, std::function<void()> onChange) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ExchangedDataWatcher::start :";
+    stop();
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    m_fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_inotifyFd < 0 || m_stopFd < 0 ||
+        inotify_add_watch(m_inotifyFd, dir.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        UtilityPivot::log_error("%s Unable to watch %s: %s", beforeLog.c_str(), dir.c_str(), strerror(errno));
+        stop();
+        return false;
+    }
+    m_path = path;
+    m_debounceMs = debounceMs;
+    m_onChange = std::move(onChange);
+    m_thread = std::thread(&ExchangedDataWatcher::m_run, this);
+    UtilityPivot::log_info("%s Watching %s", beforeLog.c_str(), path.c_str());
+    return true;
+}
+
+/**
+ * Stop the watch thread. Must not be called from onChange.
+ */
+void ExchangedDataWatcher::stop() {
+    if (m_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(m_stopFd, &one, sizeof(one)) != sizeof(one)) {
+            UtilityPivot::log_error("%s - ExchangedDataWatcher::stop : Unable to stop the watch thread",
+                                    ConstantsSystem::NamePlugin.c_str());
+        }
+        m_thread.join();
+    }
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+    if (m_stopFd >= 0) {
+        close(m_stopFd);
+        m_stopFd = -1;
+    }
+    m_path.clear();
+    m_onChange = nullptr;
+}
+
+void ExchangedDataWatcher::m_run() {
+    using Clock = std::chrono::steady_clock;
+    bool pending = false;
+    Clock::time_point deadline;
+    while (true) {
+        int timeoutMs = -1;
+        if (pending) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            timeoutMs = remaining > 0 ? static_cast<int>(remaining) : 0;
+        }
+        struct pollfd fds[2] = {{m_inotifyFd, POLLIN, 0}, {m_stopFd, POLLIN, 0}};
+        int ready = poll(fds, 2, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN) && m_readEvents()) {
+            pending = true;
+            deadline = Clock::now() + std::chrono::milliseconds(m_debounceMs);
+        }
+        else if (pending && Clock::now() >= deadline) {
+            pending = false;
+            m_onChange();
+        }
+    }
+}
+
+/**
+ * Consume the pending inotify events
+ *
+ * @return true if one of them is about the watched file
+ */
+bool ExchangedDataWatcher::m_readEvents() {
+    alignas(struct inotify_event) char buffer[4096];
+    bool modified = false;
+    ssize_t length;
+    while ((length = read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            if (event->len > 0 && m_fileName == event->name) {
+                modified = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+    return modified;
+}
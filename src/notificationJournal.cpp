@@ -0,0 +1,223 @@
+/*
+ * Binary journal of the evaluated south_event
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "notificationJournal.h"
+#include "constantsSystem.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t NotificationJournal::Magic;
+constexpr uint16_t NotificationJournal::Version;
+constexpr uint32_t NotificationJournal::MaxAssets;
+constexpr size_t   NotificationJournal::MaxAssetLength;
+constexpr uint32_t NotificationJournal::DefaultCapacity;
+constexpr uint32_t NotificationJournal::NoAsset;
+
+NotificationJournal::~NotificationJournal() {
+    close();
+}
+
+/**
+ * Map the journal file. In write mode the file is created, or reset when its layout
+ * or capacity does not match, otherwise the records of the previous runs are kept.
+ *
+ * @param path : path of the journal file
+ * @param capacity : number of records of the ring, ignored in read only mode
+ * @param readOnly : map an existing journal for reading
+ * @return true if the file is mapped
+ */
+bool NotificationJournal::open(const std::string& path, uint32_t capacity, bool readOnly) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - NotificationJournal::open :";
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_mapping) {
+        return true;
+    }
+    if (!readOnly && capacity == 0) {
+        UtilityPivot::log_error("%s Journal capacity cannot be 0", beforeLog.c_str());
+        return false;
+    }
+
+    int fd = ::open(path.c_str(), readOnly ? (O_RDONLY | O_CLOEXEC) : (O_RDWR | O_CREAT | O_CLOEXEC), 0644);
+    if (fd < 0) {
+        UtilityPivot::log_warn("%s Unable to open %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t fixedSize = sizeof(Header) + MaxAssets * sizeof(AssetName);
+    size_t size = readOnly ? static_cast<size_t>(st.st_size) : fixedSize + capacity * sizeof(Record);
+    bool resized = false;
+    if (readOnly && size < fixedSize) {
+        UtilityPivot::log_error("%s %s is not a journal", beforeLog.c_str(), path.c_str());
+        ::close(fd);
+        return false;
+    }
+    if (!readOnly && static_cast<size_t>(st.st_size) != size) {
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            UtilityPivot::log_warn("%s Unable to size %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+            ::close(fd);
+            return false;
+        }
+        resized = true;
+    }
+
+    void *mapping = mmap(nullptr, size, readOnly ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        UtilityPivot::log_warn("%s Unable to map %s: %s", beforeLog.c_str(), path.c_str(), strerror(errno));
+        return false;
+    }
+    m_mapping = mapping;
+    m_mappingSize = size;
+    m_header = static_cast<Header *>(mapping);
+    m_assets = reinterpret_cast<AssetName *>(static_cast<char *>(mapping) + sizeof(Header));
+    m_records = reinterpret_cast<Record *>(static_cast<char *>(mapping) + fixedSize);
+
+    bool valid = m_header->magic == Magic && m_header->version == Version &&
+                 m_header->recordSize == sizeof(Record) && m_header->assetCount <= MaxAssets &&
+                 fixedSize + m_header->capacity * sizeof(Record) == size;
+    if (readOnly && !valid) {
+        UtilityPivot::log_error("%s %s has an unknown layout", beforeLog.c_str(), path.c_str());
+        munmap(m_mapping, m_mappingSize);
+        m_mapping = nullptr;
+        m_header = nullptr;
+        m_assets = nullptr;
+        m_records = nullptr;
+        return false;
+    }
+    if (!readOnly && (resized || !valid)) {
+        m_initialize(capacity);
+    }
+    return true;
+}
+
+/**
+ * Unmap the journal file, the kernel writes back the dirty pages
+ */
+void NotificationJournal::close() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_mapping) {
+        return;
+    }
+    munmap(m_mapping, m_mappingSize);
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+    m_assets = nullptr;
+    m_records = nullptr;
+}
+
+/**
+ * Return the identifier of an asset in the journal, adding it to the asset table if needed
+ *
+ * @param asset : name of the asset
+ * @return The asset identifier, NoAsset if the journal is not open or the table is full
+ */
+uint32_t NotificationJournal::registerAsset(const std::string& asset) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_header) {
+        return NoAsset;
+    }
+    for (uint32_t i = 0; i < m_header->assetCount; i++) {
+        if (strncmp(m_assets[i].name, asset.c_str(), MaxAssetLength) == 0) {
+            return i;
+        }
+    }
+    if (m_header->assetCount >= MaxAssets) {
+        std::string beforeLog = ConstantsSystem::NamePlugin + " - NotificationJournal::registerAsset :";
+        UtilityPivot::log_error("%s Asset table is full, %s is not journaled", beforeLog.c_str(), asset.c_str());
+        return NoAsset;
+    }
+    AssetName& entry = m_assets[m_header->assetCount];
+    size_t length = std::min(asset.size(), MaxAssetLength);
+    memcpy(entry.name, asset.data(), length);
+    entry.name[length] = '\0';
+    return m_header->assetCount++;
+}
+
+/**
+ * Append a record to the ring, overwriting the oldest one when it is full
+ */
+void NotificationJournal::append(uint32_t assetId, bool verdict, ConnxStatus connx, GiStatus gi,
+                                 uint64_t payloadHash, uint32_t payloadSize, uint64_t timestampNs) {
+    if (!m_header) {
+        return;
+    }
+    uint64_t index = m_header->writeIndex.fetch_add(1, std::memory_order_relaxed);
+    Record& record = m_records[index % m_header->capacity];
+    record.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.timestampNs.store(timestampNs, std::memory_order_relaxed);
+    record.payloadHash.store(payloadHash, std::memory_order_relaxed);
+    record.assetId.store(assetId, std::memory_order_relaxed);
+    record.payloadSize.store(payloadSize, std::memory_order_relaxed);
+    record.verdict.store(verdict ? 1 : 0, std::memory_order_relaxed);
+    record.connxStatus.store(static_cast<uint8_t>(connx), std::memory_order_relaxed);
+    record.giStatus.store(static_cast<uint8_t>(gi), std::memory_order_relaxed);
+    record.sequence.store(static_cast<uint32_t>(index + 1), std::memory_order_release);
+}
+
+/**
+ * Copy a record out of the ring
+ *
+ * @param index : write index of the record
+ * @param event : decoded record
+ * @return false if the record was overwritten or is being written
+ */
+bool NotificationJournal::readEvent(uint64_t index, Event& event) const {
+    if (!m_header) {
+        return false;
+    }
+    const Record& record = m_records[index % m_header->capacity];
+    uint32_t sequence = static_cast<uint32_t>(index + 1);
+    if (record.sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+    event.index = index;
+    event.timestampNs = record.timestampNs.load(std::memory_order_relaxed);
+    event.payloadHash = record.payloadHash.load(std::memory_order_relaxed);
+    event.assetId = record.assetId.load(std::memory_order_relaxed);
+    event.payloadSize = record.payloadSize.load(std::memory_order_relaxed);
+    event.verdict = record.verdict.load(std::memory_order_relaxed) != 0;
+    event.connxStatus = static_cast<ConnxStatus>(record.connxStatus.load(std::memory_order_relaxed));
+    event.giStatus = static_cast<GiStatus>(record.giStatus.load(std::memory_order_relaxed));
+    // A writer overwriting the record changed its sequence before any field
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return record.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+/**
+ * Journal shared by all the rule instances of the process
+ */
+NotificationJournal& NotificationJournal::getInstance() {
+    static NotificationJournal instance;
+    return instance;
+}
+
+void NotificationJournal::m_initialize(uint32_t capacity) {
+    memset(m_mapping, 0, m_mappingSize);
+    m_header->magic = Magic;
+    m_header->version = Version;
+    m_header->recordSize = sizeof(Record);
+    m_header->capacity = capacity;
+    m_header->assetCount = 0;
+    m_header->writeIndex.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,76 @@
+/*
+ * Aggregation of the connection losses received within a window
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include "outageAggregator.h"
+
+using namespace systemspr;
+
+/**
+ * Size the set for the tracked assets, the pending losses are dropped
+ *
+ * @param assetCount : number of tracked assets
+ * @param windowNs : duration of the aggregation window, 0 to disable the aggregation
+ */
+void OutageAggregator::configure(uint32_t assetCount, uint64_t windowNs) {
+    m_windowNs = windowNs;
+    m_pending.assign(assetCount, 0);
+    m_order.clear();
+    m_order.reserve(assetCount);
+}
+
+/**
+ * Add the loss of an asset, the first loss opens the window
+ *
+ * @param assetIndex : index of the asset in the tracked assets
+ * @param nowNs : monotonic time of the loss
+ * @return false if the asset was already pending
+ */
+bool OutageAggregator::add(uint32_t assetIndex, uint64_t nowNs) {
+    if (assetIndex >= m_pending.size() || m_pending[assetIndex]) {
+        return false;
+    }
+    if (m_order.empty()) {
+        m_windowStartNs = nowNs;
+    }
+    m_pending[assetIndex] = 1;
+    m_order.push_back(assetIndex);
+    return true;
+}
+
+/**
+ * Remove an asset which recovered before the end of the window
+ *
+ * @param assetIndex : index of the asset in the tracked assets
+ * @return false if the asset was not pending
+ */
+bool OutageAggregator::remove(uint32_t assetIndex) {
+    if (!isPending(assetIndex)) {
+        return false;
+    }
+    m_pending[assetIndex] = 0;
+    for (size_t i = 0; i < m_order.size(); i++) {
+        if (m_order[i] == assetIndex) {
+            m_order.erase(m_order.begin() + i);
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Close the window and return the pending assets
+ *
+ * @param assets : receives the pending assets in order of arrival
+ */
+void OutageAggregator::take(std::vector<uint32_t>& assets) {
+    assets.assign(m_order.begin(), m_order.end());
+    for (uint32_t assetIndex : m_order) {
+        m_pending[assetIndex] = 0;
+    }
+    m_order.clear();
+}
@@ -0,0 +1,106 @@
+/*
+ * Limits of the size and of the structure of the readings
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstring>
+
+#include "payloadGuard.h"
+#include "utilityHash.h"
+
+using namespace systemspr;
+
+void PayloadGuard::configure(const Limits& limits) {
+    m_limits = limits;
+    uint64_t values[] = {limits.maxSize, limits.maxDepth, limits.maxMembers};
+    m_key = UtilityHash::fnv1a64(reinterpret_cast<const char *>(values), sizeof(values));
+}
+
+/**
+ * Check the size and the structure of a reading
+ *
+ * The members are counted as the commas outside of the strings, plus one for each object or
+ * array which is not empty.
+ *
+ * @param data : JSON reading
+ * @param length : size of the reading
+ * @return The first limit crossed, Accepted if none
+ */
+PayloadGuard::Verdict PayloadGuard::check(const char *data, size_t length) const {
+    if (checkSize(length) != Verdict::Accepted) {
+        return Verdict::TooLarge;
+    }
+    if (m_limits.maxDepth == 0 && m_limits.maxMembers == 0) {
+        return Verdict::Accepted;
+    }
+    uint32_t maxDepth = m_limits.maxDepth > 0 ? m_limits.maxDepth : UINT32_MAX;
+    uint64_t maxMembers = m_limits.maxMembers > 0 ? m_limits.maxMembers : UINT64_MAX;
+    uint32_t depth = 0;
+    uint64_t members = 0;
+    bool opened = false;    // Just after an opening bracket, the next value is the first member
+    for (size_t i = 0; i < length; i++) {
+        char c = data[i];
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            continue;
+        }
+        if (opened) {
+            opened = false;
+            if (c != '}' && c != ']' && ++members > maxMembers) {
+                return Verdict::TooManyMembers;
+            }
+        }
+        switch (c) {
+            case '"':
+                // Jump from quote to quote, an escaped one is preceded by an odd count of backslashes
+                for (;;) {
+                    const char *quote = static_cast<const char *>(memchr(data + i + 1, '"', length - i - 1));
+                    if (quote == nullptr) {
+                        return Verdict::Accepted;
+                    }
+                    i = static_cast<size_t>(quote - data);
+                    size_t backslashes = 0;
+                    while (data[i - 1 - backslashes] == '\\') {
+                        backslashes++;
+                    }
+                    if (backslashes % 2 == 0) {
+                        break;
+                    }
+                }
+                break;
+            case '{':
+            case '[':
+                if (++depth > maxDepth) {
+                    return Verdict::TooDeep;
+                }
+                opened = true;
+                break;
+            case '}':
+            case ']':
+                if (depth > 0) {
+                    depth--;
+                }
+                break;
+            case ',':
+                if (++members > maxMembers) {
+                    return Verdict::TooManyMembers;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return Verdict::Accepted;
+}
+
+const char *PayloadGuard::toString(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::Accepted:       return "accepted";
+        case Verdict::TooLarge:       return "too large";
+        case Verdict::TooDeep:        return "too deep";
+        case Verdict::TooManyMembers: return "too many members";
+        default:                      return "unknown";
+    }
+}
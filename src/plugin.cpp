@@ -35,6 +35,117 @@ static const char *default_config = QUOTE({
 			"type" : "string",
 			"default" : "CONNECTION-1"
 		    },
+		"eval_cache": {
+			"description": "Share the results of the evaluations between the rule instances of the service, so that identical readings are parsed only once",
+			"displayName": "Evaluation cache",
+			"type": "boolean",
+			"default": "true"
+			},
+		"config_cache": {
+			"description": "Keep the imported exchanged_data in a binary file of the Fledge data directory, loaded at the next start instead of parsing the JSON",
+			"displayName": "Configuration cache",
+			"type": "boolean",
+			"default": "true"
+			},
+		"json_backend": {
+			"description": "Parser of the readings: rapidjson parses the whole reading, ondemand only reads the south_event of the tracked asset using a vectorized structural index",
+			"displayName": "JSON backend",
+			"type": "enumeration",
+			"options": ["rapidjson", "ondemand"],
+			"default": "rapidjson"
+			},
+		"max_payload_size": {
+			"description": "Maximum size in bytes of the readings, larger readings are rejected without being parsed. 0 for no limit",
+			"displayName": "Max payload size",
+			"type": "integer",
+			"default": "4194304"
+			},
+		"max_depth": {
+			"description": "Maximum nesting of objects and arrays in the readings. 0 for no limit",
+			"displayName": "Max depth",
+			"type": "integer",
+			"default": "64"
+			},
+		"max_members": {
+			"description": "Maximum number of object members and array elements in the readings. 0 for no limit",
+			"displayName": "Max members",
+			"type": "integer",
+			"default": "1000000"
+			},
+		"decision_trace_signal": {
+			"description": "Signal dumping the trace of the last evaluation decisions to the Fledge data directory, none to leave the signals of the process untouched",
+			"displayName": "Decision trace dump signal",
+			"type": "enumeration",
+			"options": ["none", "SIGUSR1", "SIGUSR2"],
+			"default": "none"
+			},
+		"journal": {
+			"description": "Record every evaluated south_event in a memory-mapped journal of the Fledge data directory",
+			"displayName": "Notification journal",
+			"type": "boolean",
+			"default": "false"
+			},
+		"journal_size": {
+			"description": "Number of records kept in the notification journal",
+			"displayName": "Journal size",
+			"type": "integer",
+			"default": "65536"
+			},
+		"capture_file": {
+			"description": "File where the evaluated readings are appended as gzip compressed JSON lines, for systemspr_replay, relative to the plugin data directory. Empty to disable",
+			"displayName": "Capture file",
+			"type": "string",
+			"default": ""
+			},
+		"aggregation_window": {
+			"description": "Delay in milliseconds during which the connection losses are gathered in a single notification, 0 to notify each loss",
+			"displayName": "Aggregation window",
+			"type": "integer",
+			"default": "0"
+			},
+		"site_down_threshold": {
+			"description": "Percentage of the tracked assets lost within the aggregation window above which the notification reports the site down, 0 to disable",
+			"displayName": "Site down threshold",
+			"type": "integer",
+			"default": "0"
+			},
+		"reason_template": {
+			"description": "Template of the reason of the notifications, a JSON object with the placeholders <asset>, <reason>, <fired_asset>, <connection>, <timestamp>, <assets>, <implied_assets>, <pivot_ids>, <site_down> and <details>. Empty for the default reason",
+			"displayName": "Reason template",
+			"type": "string",
+			"default": ""
+			},
+		"shared_state_name": {
+			"description": "Name of the POSIX shared memory object where the link state of the tracked assets is published for the local consumers. Empty to disable",
+			"displayName": "Shared state name",
+			"type": "string",
+			"default": ""
+			},
+		"metrics_file": {
+			"description": "File where the metrics of the rule are periodically written, relative to the plugin data directory. Empty to disable",
+			"displayName": "Metrics file",
+			"type": "string",
+			"default": ""
+			},
+		"metrics_format": {
+			"description": "Format of the metrics file",
+			"displayName": "Metrics format",
+			"type": "enumeration",
+			"options": ["json", "prometheus"],
+			"default": "json"
+			},
+		"metrics_interval": {
+			"description": "Delay in seconds between two writes of the metrics file, 0 to only write it when the rule stops or is reconfigured",
+			"displayName": "Metrics interval",
+			"type": "integer",
+			"default": "10"
+			},
+		"exchanged_data_file": {
+			"description": "File holding the exchanged data list, relative to the plugin data directory, reloaded when it is modified. Empty to use the exchanged data list below",
+			"displayName": "Exchanged data file",
+			"type": "string",
+			"default": ""
+			},
 		"exchanged_data" : {
 			"description" : "exchanged data list",
 			"type" : "JSON",
@@ -77,7 +188,25 @@ static const char *default_config = QUOTE({
 					]
 				}
 			})
-   		}
+   		},
+		"connections" : {
+			"description" : "Connection assets with the protocol and the address ranges of the prt.inf datapoints reachable through each of them",
+			"type" : "JSON",
+			"displayName" : "Connections",
+			"order" : "4",
+			"default" : QUOTE({
+				"connections": []
+			})
+		},
+		"topology" : {
+			"description" : "Parent assets, such as a gateway link, with the connection assets lost with them",
+			"type" : "JSON",
+			"displayName" : "Topology",
+			"order" : "5",
+			"default" : QUOTE({
+				"topology": []
+			})
+		}
 	});
 
 /**
@@ -185,6 +314,22 @@ void plugin_shutdown(PLUGIN_HANDLE *handle)
 	delete ruleSystemSp;
 }
 
+#ifdef SYSTEMSPR_EXPORT_SET_CLOCK
+/**
+ * Replace the clock giving the time of the evaluations. Not called by the notification
+ * service: the replay tool gives the rule the time of the capture with it. Only built with
+ * EXPORT_SET_CLOCK, as the clock is a C++ object of the plugin passed across dlopen.
+ *
+ * @param	handle	The plugin handle
+ * @param	clock	The clock of the evaluations, nullptr for the clock of the system
+ */
+void plugin_set_clock(PLUGIN_HANDLE handle, const RuleClock *clock)
+{
+	auto ruleSystemSp = (RuleSystemSp *)handle;
+	ruleSystemSp->setClock(clock);
+}
+#endif
+
 // End of extern "C"
 };
 
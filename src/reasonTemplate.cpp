@@ -0,0 +1,120 @@
+/*
+ * Template of the reason of the notifications
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstring>
+
+#include <rapidjson/document.h>
+
+#include "reasonTemplate.h"
+#include "constantsSystem.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+const char *const ReasonTemplate::Default = "{ \"asset\": \"<asset>\", \"reason\": \"<reason>\"<details> }";
+
+namespace {
+
+const char *const slotNames[] = {
+    "", "asset", "reason", "fired_asset", "connection", "timestamp",
+    "assets", "implied_assets", "pivot_ids", "site_down", "details"
+};
+static_assert(sizeof(slotNames) / sizeof(slotNames[0]) == static_cast<size_t>(ReasonTemplate::Slot::Count),
+              "A slot has no name");
+
+bool isNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || c == '_';
+}
+};
+
+const char *ReasonTemplate::slotName(Slot slot) {
+    return slot < Slot::Count ? slotNames[static_cast<size_t>(slot)] : "";
+}
+
+/**
+ * Compile a template. A '<' which does not start a placeholder is kept as is.
+ *
+ * @param text : template of the reason, a JSON document once the placeholders are replaced
+ * @return false if the template has an unknown placeholder or does not give a JSON object,
+ *         the current template is then kept
+ */
+bool ReasonTemplate::compile(const std::string& text) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - ReasonTemplate::compile :";
+    std::string literals;
+    std::vector<Segment> segments;
+    uint32_t usedSlots = 0;
+    size_t literalStart = 0;
+    auto flushLiteral = [&](size_t end) {
+        if (end > literalStart) {
+            segments.push_back(Segment{Slot::Literal, static_cast<uint32_t>(literals.size()),
+                                       static_cast<uint32_t>(end - literalStart)});
+            literals.append(text, literalStart, end - literalStart);
+        }
+    };
+
+    size_t position = 0;
+    while ((position = text.find('<', position)) != std::string::npos) {
+        size_t nameEnd = position + 1;
+        while (nameEnd < text.size() && isNameChar(text[nameEnd])) {
+            nameEnd++;
+        }
+        if (nameEnd == position + 1 || nameEnd >= text.size() || text[nameEnd] != '>') {
+            position++;
+            continue;
+        }
+        std::string name = text.substr(position + 1, nameEnd - position - 1);
+        Slot slot = Slot::Count;
+        for (size_t i = 1; i < static_cast<size_t>(Slot::Count); i++) {
+            if (name == slotNames[i]) {
+                slot = static_cast<Slot>(i);
+                break;
+            }
+        }
+        if (slot == Slot::Count) {
+            UtilityPivot::log_error("%s Unknown placeholder <%s> in reason template", beforeLog.c_str(), name.c_str());
+            return false;
+        }
+        flushLiteral(position);
+        segments.push_back(Segment{slot, 0, 0});
+        usedSlots |= 1U << static_cast<uint32_t>(slot);
+        position = nameEnd + 1;
+        literalStart = position;
+    }
+    flushLiteral(text.size());
+
+    std::string sample;
+    auto sampleSlot = [](std::string& out, Slot slot) {
+        switch (slot) {
+            case Slot::Assets:
+            case Slot::ImpliedAssets:
+            case Slot::PivotIds:
+                out += "[ ]";
+                break;
+            case Slot::SiteDown:
+                out += "false";
+                break;
+            case Slot::Details:
+                break;
+            default:
+                out += "x";
+                break;
+        }
+    };
+    m_render(literals, segments, sample, sampleSlot);
+    rapidjson::Document document;
+    if (document.Parse(sample.c_str()).HasParseError() || !document.IsObject()) {
+        UtilityPivot::log_error("%s Reason template is not a JSON object: %s", beforeLog.c_str(), text.c_str());
+        return false;
+    }
+
+    m_text = text;
+    m_literals = std::move(literals);
+    m_segments = std::move(segments);
+    m_usedSlots = usedSlots;
+    return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Clocks giving the time of the evaluations
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <ctime>
+
+#include "ruleClock.h"
+
+using namespace systemspr;
+
+namespace {
+
+uint64_t readClock(clockid_t clock) {
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+}
+};
+
+constexpr uint64_t VirtualClock::DefaultRealtimeNs;
+
+const CoarseClock& CoarseClock::getInstance() {
+    static CoarseClock instance;
+    return instance;
+}
+
+/**
+ * Read the coarse monotonic clock and realtime clock
+ *
+ * @return The time of the evaluation
+ */
+RuleClock::Time CoarseClock::now() const {
+    Time time;
+    time.monotonicNs = readClock(CLOCK_MONOTONIC_COARSE);
+    time.realtimeNs = readClock(CLOCK_REALTIME_COARSE);
+    return time;
+}
+
+/**
+ * Time reached by the advances of the clock, the realtime moving along with the monotonic time
+ *
+ * @return The time of the evaluation
+ */
+RuleClock::Time VirtualClock::now() const {
+    Time time;
+    time.monotonicNs = m_monotonicNs.load(std::memory_order_relaxed);
+    time.realtimeNs = m_realtimeOffsetNs + time.monotonicNs;
+    return time;
+}
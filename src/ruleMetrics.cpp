@@ -0,0 +1,299 @@
+/*
+ * Counters and latency histograms of the rule
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+#include "ruleMetrics.h"
+#include "constantsSystem.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t LatencyHistogram::SubBucketBits;
+constexpr uint32_t LatencyHistogram::SubBuckets;
+constexpr uint32_t LatencyHistogram::MaxBits;
+constexpr uint32_t LatencyHistogram::BucketCount;
+
+/**
+ * Index of the bucket holding a value
+ */
+uint32_t LatencyHistogram::bucketIndex(uint64_t valueNs) {
+    if (valueNs < SubBuckets) {
+        return static_cast<uint32_t>(valueNs);
+    }
+    uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(valueNs));
+    if (msb >= MaxBits) {
+        return BucketCount - 1;
+    }
+    uint32_t shift = msb - SubBucketBits;
+    return (shift + 1) * SubBuckets + static_cast<uint32_t>((valueNs >> shift) & (SubBuckets - 1));
+}
+
+/**
+ * Largest value stored in a bucket
+ */
+uint64_t LatencyHistogram::bucketUpperBound(uint32_t index) {
+    if (index < SubBuckets) {
+        return index;
+    }
+    uint32_t shift = index / SubBuckets - 1;
+    uint64_t lower = static_cast<uint64_t>(SubBuckets + index % SubBuckets) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t valueNs) {
+    m_buckets[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(valueNs, std::memory_order_relaxed);
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (valueNs > currentMax &&
+           !m_max.compare_exchange_weak(currentMax, valueNs, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * Value below which the given percentage of the recorded values fall
+ *
+ * @param percent : percentile between 0 and 100
+ * @return The upper bound of the bucket holding the percentile, 0 if nothing was recorded
+ */
+uint64_t LatencyHistogram::percentile(double percent) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(total)));
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t cumulated = 0;
+    for (uint32_t i = 0; i < BucketCount; i++) {
+        cumulated += m_buckets[i].load(std::memory_order_relaxed);
+        if (cumulated >= target) {
+            uint64_t bound = bucketUpperBound(i);
+            return bound < max() ? bound : max();
+        }
+    }
+    return max();
+}
+
+/**
+ * Number of evaluations decided before parsing the reading
+ */
+uint64_t RuleMetrics::getPrefiltered() const {
+    return getDecisionCount(EvalDecision::Disabled) + getDecisionCount(EvalDecision::NoTracking);
+}
+
+namespace {
+
+const std::array<std::pair<const char *, double>, 4> exportedPercentiles = {{
+    {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}
+}};
+
+void appendf(std::string& out, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+void appendf(std::string& out, const char *format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0) {
+        out.append(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+    }
+}
+
+void appendJsonHistogram(std::string& out, const char *name, const LatencyHistogram& histogram) {
+    uint64_t count = histogram.count();
+    appendf(out, "\"%s\":{\"count\":%" PRIu64 ",\"mean\":%" PRIu64, name, count, count ? histogram.sum() / count : 0);
+    for (const auto& percentile : exportedPercentiles) {
+        appendf(out, ",\"%s\":%" PRIu64, percentile.first, histogram.percentile(percentile.second));
+    }
+    appendf(out, ",\"max\":%" PRIu64 "}", histogram.max());
+}
+
+void appendPrometheusSummary(std::string& out, const char *name, const char *help,
+                             const std::string& instance, const LatencyHistogram& histogram) {
+    appendf(out, "# HELP systemspr_%s_seconds %s\n# TYPE systemspr_%s_seconds summary\n", name, help, name);
+    for (const auto& percentile : exportedPercentiles) {
+        appendf(out, "systemspr_%s_seconds{instance=\"%s\",quantile=\"%g\"} %.9f\n", name, instance.c_str(),
+                percentile.second / 100.0, static_cast<double>(histogram.percentile(percentile.second)) / 1e9);
+    }
+    appendf(out, "systemspr_%s_seconds_sum{instance=\"%s\"} %.9f\n", name, instance.c_str(),
+            static_cast<double>(histogram.sum()) / 1e9);
+    appendf(out, "systemspr_%s_seconds_count{instance=\"%s\"} %" PRIu64 "\n", name, instance.c_str(), histogram.count());
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+};
+
+/**
+ * Snapshot of the metrics as a JSON document, latencies are in nanoseconds
+ *
+ * @param instance : name of the rule instance
+ */
+std::string RuleMetrics::toJson(const std::string& instance) const {
+    std::string out;
+    appendf(out, "{\"instance\":\"%s\",\"evaluations\":%" PRIu64 ",\"prefiltered\":%" PRIu64 ",\"decisions\":{",
+            escapeLabel(instance).c_str(), getEvaluations(), getPrefiltered());
+    for (size_t i = 0; i < static_cast<size_t>(EvalDecision::Count); i++) {
+        appendf(out, "%s\"%s\":%" PRIu64, i ? "," : "", EvalDecisionName::toString(static_cast<EvalDecision>(i)),
+                m_decisions[i].load(std::memory_order_relaxed));
+    }
+    appendf(out, "},\"cache_hits\":%" PRIu64 ",\"reconfigure_stall_ns\":%" PRIu64 ",\"latency_ns\":{",
+            getCacheHits(), getReconfigureStallNs());
+    appendJsonHistogram(out, "eval", m_evalLatency);
+    out += ',';
+    appendJsonHistogram(out, "reason", m_reasonLatency);
+    out += ',';
+    appendJsonHistogram(out, "reconfigure", m_reconfigureLatency);
+    out += ',';
+    appendJsonHistogram(out, "reconfigure_stall", m_reconfigureStall);
+    out += "}}\n";
+    return out;
+}
+
+/**
+ * Snapshot of the metrics in the Prometheus text exposition format
+ *
+ * @param instance : name of the rule instance
+ */
+std::string RuleMetrics::toPrometheus(const std::string& instance) const {
+    std::string label = escapeLabel(instance);
+    std::string out;
+    appendf(out, "# HELP systemspr_evaluations_total Evaluations by decision\n# TYPE systemspr_evaluations_total counter\n");
+    for (size_t i = 0; i < static_cast<size_t>(EvalDecision::Count); i++) {
+        appendf(out, "systemspr_evaluations_total{instance=\"%s\",decision=\"%s\"} %" PRIu64 "\n", label.c_str(),
+                EvalDecisionName::toString(static_cast<EvalDecision>(i)), m_decisions[i].load(std::memory_order_relaxed));
+    }
+    appendf(out, "# HELP systemspr_prefiltered_total Evaluations decided before parsing the reading\n"
+                 "# TYPE systemspr_prefiltered_total counter\n"
+                 "systemspr_prefiltered_total{instance=\"%s\"} %" PRIu64 "\n", label.c_str(), getPrefiltered());
+    appendf(out, "# HELP systemspr_cache_hits_total Evaluations answered by the evaluation cache\n"
+                 "# TYPE systemspr_cache_hits_total counter\n"
+                 "systemspr_cache_hits_total{instance=\"%s\"} %" PRIu64 "\n", label.c_str(), getCacheHits());
+    appendf(out, "# HELP systemspr_reconfigure_stall_seconds_total Time evaluations were blocked by reconfigurations\n"
+                 "# TYPE systemspr_reconfigure_stall_seconds_total counter\n"
+                 "systemspr_reconfigure_stall_seconds_total{instance=\"%s\"} %.9f\n", label.c_str(),
+            static_cast<double>(getReconfigureStallNs()) / 1e9);
+    appendPrometheusSummary(out, "eval_latency", "Duration of evalRule", label, m_evalLatency);
+    appendPrometheusSummary(out, "reason_latency", "Duration of getReason", label, m_reasonLatency);
+    appendPrometheusSummary(out, "reconfigure_latency", "Duration of reconfigure", label, m_reconfigureLatency);
+    return out;
+}
+
+/**
+ * Configure the periodic export of the metrics, starting the thread writing the file
+ *
+ * @param instance : name of the rule instance
+ * @param path : file to write, empty to disable the export
+ * @param format : format of the file
+ * @param intervalNs : delay between two exports, 0 to only export when the export stops
+ */
+void RuleMetrics::setExport(const std::string& instance, const std::string& path, Format format, uint64_t intervalNs) {
+    if (m_exportThread.joinable() && instance == m_exportInstance && path == m_exportPath &&
+        format == m_exportFormat && intervalNs == m_exportIntervalNs) {
+        return;
+    }
+    stopExport();
+    m_exportInstance = instance;
+    m_exportPath = path;
+    m_exportFormat = format;
+    m_exportIntervalNs = intervalNs;
+    if (!path.empty()) {
+        m_exportStop = false;
+        m_exportThread = std::thread(&RuleMetrics::m_runExport, this);
+    }
+}
+
+/**
+ * Stop the export thread, once it has written the metrics a last time
+ */
+void RuleMetrics::stopExport() {
+    if (m_exportThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(m_exportMutex);
+            m_exportStop = true;
+        }
+        m_exportWake.notify_one();
+        m_exportThread.join();
+    }
+    m_exportPath.clear();
+}
+
+/**
+ * Write the metrics to the export file, replacing it atomically
+ *
+ * @param instance : name of the rule instance
+ * @return true if the file was written
+ */
+bool RuleMetrics::exportToFile(const std::string& instance) const {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleMetrics::exportToFile :";
+    std::string content = m_exportFormat == Format::Prometheus ? toPrometheus(instance) : toJson(instance);
+    std::string temporaryPath = m_exportPath + ".tmp";
+    FILE *file = fopen(temporaryPath.c_str(), "w");
+    if (!file) {
+        UtilityPivot::log_error("%s Unable to write metrics to %s", beforeLog.c_str(), temporaryPath.c_str());
+        return false;
+    }
+    bool written = fwrite(content.data(), 1, content.size(), file) == content.size();
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporaryPath.c_str(), m_exportPath.c_str()) != 0) {
+        UtilityPivot::log_error("%s Unable to write metrics to %s", beforeLog.c_str(), m_exportPath.c_str());
+        remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loop of the export thread: write the file at each interval, on a schedule of its own so that the
+ * evaluations never wait for it, and a last time when the export stops
+ */
+void RuleMetrics::m_runExport() {
+    std::unique_lock<std::mutex> lock(m_exportMutex);
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    for (;;) {
+        if (m_exportIntervalNs == 0) {
+            m_exportWake.wait(lock, [this]() { return m_exportStop; });
+        }
+        else {
+            next += std::chrono::nanoseconds(m_exportIntervalNs);
+            m_exportWake.wait_until(lock, next, [this]() { return m_exportStop; });
+        }
+        bool stop = m_exportStop;
+        lock.unlock();
+
+        exportToFile(m_exportInstance);
+        if (stop) {
+            return;
+        }
+        lock.lock();
+    }
+}
+
+uint64_t RuleMetrics::monotonicNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
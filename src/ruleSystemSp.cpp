@@ -8,33 +8,170 @@
  * Author: Yannick Marchetaux
  *
  */
-#include <regex>
+#include <algorithm>
+#include <cinttypes>
+#include <ctime>
+#include <cstdlib>
+#include <csignal>
+#include <cstdio>
 #include <datapoint.h>
 #include <reading.h>
 #include <plugin_api.h>
-#include <rapidjson/document.h>
 
 #include "ruleSystemSp.h"
 #include "constantsSystem.h"
+#include "decisionTrace.h"
+#include "evaluationCache.h"
+#include "ruleProbes.h"
+#include "southEventReader.h"
 #include "datapoint_utility.h"
+#include "utilityHash.h"
 #include "utilityPivot.h"
 
 using namespace DatapointUtility;
 using namespace systemspr;
 
+constexpr size_t RuleSystemSp::MaxHeldNotifications;
+
 
 /**
  * Modification of configuration
+ * When exchanged_data_file is set, the exchanged_data is read from this file, relative
+ * to the plugin data directory, instead of the configuration category.
  *
  * @param config : configuration ExchangedData + Asset
  */
 void RuleSystemSp::setJsonConfig(const ConfigCategory& config) {
-    if (config.itemExists("exchanged_data")) {
+    if (config.itemExists("config_cache")) {
+        std::string dir;
+        if (config.getValue("config_cache").compare("true") == 0 || config.getValue("config_cache").compare("True") == 0) {
+            dir = UtilityPivot::getPluginDataDir();
+            if (!dir.empty()) {
+                dir += "/cache";
+                if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+                    dir.clear();
+                }
+            }
+        }
+        m_configPlugin.setCompiledCacheDir(dir);
+    }
+    m_exchangedDataFile = config.itemExists("exchanged_data_file") ? config.getValue("exchanged_data_file") : "";
+    if (!m_exchangedDataFile.empty() && m_exchangedDataFile[0] != '/') {
+        std::string dir = UtilityPivot::getPluginDataDir();
+        m_exchangedDataFile = dir.empty() ? "" : dir + "/" + m_exchangedDataFile;
+    }
+    if (!m_exchangedDataFile.empty()) {
+        m_configPlugin.importExchangedDataFile(m_exchangedDataFile);
+    }
+    else if (config.itemExists("exchanged_data")) {
         m_configPlugin.importExchangedData(config.getValue("exchanged_data"));
     }
     if (config.itemExists("asset")) {
         m_configPlugin.importAsset(config.getValue("asset"));
     }
+    if (config.itemExists("connections")) {
+        m_configPlugin.importConnections(config.getValue("connections"));
+    }
+    if (config.itemExists("topology")) {
+        m_configPlugin.importTopology(config.getValue("topology"));
+    }
+    m_attachStateEntries();
+}
+
+/**
+ * Attach the persistent state entries of the tracked assets, reloaded from the previous run if any,
+ * and their entries in the shared state table when shared_state_name is set
+ */
+void RuleSystemSp::m_attachStateEntries() {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_attachStateEntries :";
+    SharedStateTable& sharedTable = SharedStateTable::getInstance();
+    bool shared = !m_sharedStateName.empty() && sharedTable.open(m_sharedStateName);
+    if (shared && sharedTable.getName() != m_sharedStateName) {
+        UtilityPivot::log_warn("%s States are already published in %s, %s is not used", beforeLog.c_str(),
+                               sharedTable.getName().c_str(), m_sharedStateName.c_str());
+    }
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    m_trackedStates.assign(trackedAssets.size(), TrackedAssetState());
+    if (m_aggregator.getPendingCount() > 0) {
+        UtilityPivot::log_warn("%s %zu connection losses pending aggregation are dropped", beforeLog.c_str(),
+                               m_aggregator.getPendingCount());
+    }
+    if (m_heldCount > 0) {
+        UtilityPivot::log_warn("%s %zu notifications held by the aggregation are dropped", beforeLog.c_str(),
+                               m_heldCount);
+    }
+    m_aggregator.configure(static_cast<uint32_t>(trackedAssets.size()), m_aggregationWindowNs);
+    // Sized for all the tracked assets, holding a window never allocates
+    for (PendingNotification& held : m_heldNotifications) {
+        held.assets.clear();
+        held.assets.reserve(trackedAssets.size());
+    }
+    m_heldFirst = 0;
+    m_heldCount = 0;
+    m_aggregatedAssets.clear();
+    m_aggregatedAssets.reserve(trackedAssets.size());
+    // The state of the previous run is only resumed when the rule starts
+    bool restore = !m_stateRestored;
+    m_stateRestored = true;
+    for (size_t i = 0; i < trackedAssets.size(); i++) {
+        ConnectionStateStore::Entry *entry = ConnectionStateStore::getInstance().acquire(trackedAssets[i]);
+        m_trackedStates[i].stateEntry = entry;
+        if (restore && entry && entry->getLinkState() == LinkState::NotConnected) {
+            if (entry->isLossNotified()) {
+                // The south service reports the loss again when it restarts, it is not notified twice
+                m_trackedStates[i].knownLoss = true;
+                UtilityPivot::log_info("%s Connection %s was lost before restart and has not recovered yet",
+                                        beforeLog.c_str(), trackedAssets[i].c_str());
+            }
+            else if (m_aggregator.isEnabled()) {
+                m_resumeHeldLosses = true;
+                UtilityPivot::log_info("%s Loss of connection %s was held at shutdown, it is notified at the end of "
+                                        "a new aggregation window", beforeLog.c_str(), trackedAssets[i].c_str());
+            }
+            else {
+                UtilityPivot::log_info("%s Loss of connection %s was not notified before restart",
+                                        beforeLog.c_str(), trackedAssets[i].c_str());
+            }
+        }
+        SharedStateTable::Entry *sharedEntry = shared ? sharedTable.acquire(trackedAssets[i]) : nullptr;
+        m_trackedStates[i].sharedEntry = sharedEntry;
+        if (sharedEntry && entry) {
+            sharedTable.publish(sharedEntry, entry->getLinkState(),
+                                static_cast<ConnxStatus>(entry->connxStatus.load(std::memory_order_relaxed)),
+                                static_cast<GiStatus>(entry->giStatus.load(std::memory_order_relaxed)),
+                                entry->lossCount.load(std::memory_order_relaxed),
+                                entry->updatedNs.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+/**
+ * Open the notification journal and register the tracked assets in it when journaling is enabled
+ */
+void RuleSystemSp::m_attachJournal() {
+    for (TrackedAssetState& state : m_trackedStates) {
+        state.journalAssetId = NotificationJournal::NoAsset;
+    }
+    if (!m_journalEnabled || m_trackedStates.empty()) {
+        return;
+    }
+    NotificationJournal& journal = NotificationJournal::getInstance();
+    if (!journal.isOpen()) {
+        std::string dir = UtilityPivot::getPluginDataDir();
+        if (dir.empty() || !journal.open(dir + "/journal.bin", m_journalSize)) {
+            return;
+        }
+    }
+    else if (journal.getHeader()->capacity != m_journalSize) {
+        // The records of the other instances are in the ring, it is not resized
+        static const std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_attachJournal :";
+        UtilityPivot::log_warn("%s The journal shared by the rule instances holds %u records, journal_size %u is ignored",
+                               beforeLog.c_str(), journal.getHeader()->capacity, m_journalSize);
+    }
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    for (size_t i = 0; i < m_trackedStates.size(); i++) {
+        m_trackedStates[i].journalAssetId = journal.registerAsset(trackedAssets[i]);
+    }
 }
 
 /**
@@ -43,121 +180,637 @@ void RuleSystemSp::setJsonConfig(const ConfigCategory& config) {
  * @param assetValues : JSON string document with notification data.
  */
 bool RuleSystemSp::evalRule(const std::string& assetValues) {
+    uint64_t startNs = RuleMetrics::monotonicNs();
+    SYSTEMSPR_PROBE2(eval__start, assetValues.c_str(), assetValues.size());
     std::lock_guard<std::mutex> guard(m_configMutex);
-    std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::evalRule :";
+    static const std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::evalRule :";
+    static const std::string sendingLog = "%s Sending %s notification";
+    static const std::string sendingAggregatedLog = "%s Sending connection lost notification for %zu assets";
     // Reinitialize reason, asset cause
     m_reason = "";
     m_asset = "";
-    // Plugin disabled, no filtering
-    if (!isEnabled()) {
-        return false;
+    m_firedAsset = "";
+    m_firedTimeNs = 0;
+
+    // The time is read once, every step of the evaluation sees the same
+    RuleClock::Time now = m_clock->now();
+    uint64_t nowNs = now.realtimeNs;
+
+    if (m_capture.isOpen()) {
+        m_capture.append(nowNs, assetValues);
     }
-    // No asset to track, no filtering
-    if (!m_configPlugin.hasConnectionLossTracking()) {
-        return false;
+    if (m_resumeHeldLosses) {
+        m_resumeHeldLosses = false;
+        m_holdRestoredLosses(now.monotonicNs);
+    }
+    uint64_t payloadHash = 0;
+    bool hashed = false;
+    EvalResult result = m_evaluate(assetValues, payloadHash, hashed);
+    DecisionTrace::record(result.decision, static_cast<uint32_t>(assetValues.size()), nowNs);
+    m_metrics.countDecision(result.decision);
+    m_aggregatedAssets.clear();
+    m_siteDown = false;
+    bool fired = false;
+    // Event notified by this evaluation, an earlier one held by the aggregation if any
+    EvalResult notified = result;
+    if (!m_propagateLoss(result, nowNs)) {
+        fired = m_aggregator.isEnabled() ? m_aggregate(result, now.monotonicNs, notified) : result.isFired();
+    }
+    else if (m_aggregator.isEnabled()) {
+        fired = m_aggregate(EvalResult(), now.monotonicNs, notified);
     }
-    rapidjson::Document doc;
-	doc.Parse(assetValues.c_str());
-	if (doc.HasParseError()) {
-        UtilityPivot::log_error("%s JSON parse error in: %s", beforeLog.c_str(), assetValues.c_str());
-		return false;
-	}
 
-    if (!doc.IsObject()) {
-        UtilityPivot::log_error("%s Asset is not an object, ignoring: %s", beforeLog.c_str(), assetValues.c_str());
-        return false;
+    if (result.isSouthEvent() && result.assetIndex < m_trackedStates.size()) {
+        const TrackedAssetState& state = m_trackedStates[result.assetIndex];
+        if (state.stateEntry) {
+            ConnectionStateStore::getInstance().update(state.stateEntry, result.connxStatus, result.giStatus, nowNs);
+        }
+        if (state.sharedEntry) {
+            SharedStateTable::getInstance().update(state.sharedEntry, result.connxStatus, result.giStatus, nowNs);
+        }
+        // The verdict of this reading, not of a notification held by the aggregation and sent with it
+        if (state.journalAssetId != NotificationJournal::NoAsset) {
+            if (!hashed) {
+                payloadHash = UtilityHash::xxh64(assetValues);
+            }
+            NotificationJournal::getInstance().append(state.journalAssetId, result.isFired(), result.connxStatus,
+                                                      result.giStatus, payloadHash,
+                                                      static_cast<uint32_t>(assetValues.size()), nowNs);
+        }
+    }
+    if (fired) {
+        m_firedTimeNs = nowNs;
+        m_setLossesNotified(notified);
+    }
+    if (!m_aggregatedAssets.empty()) {
+        UtilityPivot::log_debug(sendingAggregatedLog, beforeLog.c_str(), m_aggregatedAssets.size());
+        m_firedAsset = m_configPlugin.getTrackedAssets()[m_aggregatedAssets[0]];
+        m_asset = "connx_status";
+        m_reason = "not connected";
+        if (m_aggregatedAssets.size() == 1 && !m_siteDown) {
+            // Same notification as without aggregation
+            m_aggregatedAssets.clear();
+        }
+    }
+    else if (fired) {
+        m_firedAsset = m_configPlugin.getTrackedAssets()[notified.assetIndex];
+        if (notified.decision == EvalDecision::FiredConnectionLost) {
+            UtilityPivot::log_debug(sendingLog, beforeLog.c_str(), "connection lost");
+            m_asset = "connx_status";
+            m_reason = "not connected";
+        }
+        else {
+            UtilityPivot::log_debug(sendingLog, beforeLog.c_str(), "connected");
+            m_asset = "gi_status";
+            m_reason = "finished";
+        }
     }
 
-    const std::string& trackedAsset = m_configPlugin.getTrackedAsset();
-    if (!doc.HasMember(trackedAsset.c_str())) {
-        UtilityPivot::log_debug("%s Asset is not the one being tracked, ignoring: %s", beforeLog.c_str(), assetValues.c_str());
-        return false;
+    uint64_t endNs = RuleMetrics::monotonicNs();
+    m_metrics.evalLatency().record(endNs - startNs);
+    // Asset of the south_event evaluated, empty for the other readings
+    SYSTEMSPR_PROBE5(eval__done,
+                     result.isSouthEvent() && result.assetIndex < m_trackedStates.size() ?
+                         m_configPlugin.getTrackedAssets()[result.assetIndex].c_str() : "",
+                     fired, assetValues.size(), static_cast<uint32_t>(result.decision), endNs - startNs);
+    return fired;
+}
+
+/**
+ * Replace the clock giving the time of the evaluations, such as a VirtualClock in the tests.
+ * The clock is not owned and must outlive the rule or be replaced before it is destroyed.
+ *
+ * @param clock : clock of the evaluations, nullptr for the coarse clocks of the kernel
+ */
+void RuleSystemSp::setClock(const RuleClock *clock) {
+    std::lock_guard<std::mutex> guard(m_configMutex);
+    m_clock = clock != nullptr ? clock : &CoarseClock::getInstance();
+}
+
+/**
+ * Put back in the aggregation window the losses held at shutdown. Done by the first evaluation, so
+ * that the window follows the clock of the evaluations.
+ *
+ * @param nowNs : monotonic time of the evaluation
+ */
+void RuleSystemSp::m_holdRestoredLosses(uint64_t nowNs) {
+    if (!m_aggregator.isEnabled()) {
+        return;
+    }
+    for (size_t i = 0; i < m_trackedStates.size(); i++) {
+        const ConnectionStateStore::Entry *entry = m_trackedStates[i].stateEntry;
+        if (entry && entry->getLinkState() == LinkState::NotConnected && !entry->isLossNotified()) {
+            m_aggregator.add(static_cast<uint32_t>(i), nowNs);
+        }
     }
+}
 
-    const rapidjson::Value& reading = doc[trackedAsset.c_str()];
-    if (!reading.IsObject()) {
-        UtilityPivot::log_error("%s Reading is not an object, ignoring: %s", beforeLog.c_str(), assetValues.c_str());
+/**
+ * Apply the loss of an asset to its descendants in the topology, and suppress the
+ * losses reported afterwards by the descendants
+ *
+ * @param result : result of the evaluation of the reading
+ * @param nowNs : realtime of the evaluation
+ * @return true if the reading is the loss of an asset already lost with its parent or before the restart
+ */
+bool RuleSystemSp::m_propagateLoss(const EvalResult& result, uint64_t nowNs) {
+    if (!result.isFired() || result.assetIndex >= m_trackedStates.size()) {
         return false;
     }
-
-    if (!reading.HasMember("south_event")) {
-        UtilityPivot::log_debug("%s Reading is not a south event, ignoring: %s", beforeLog.c_str(), assetValues.c_str());
+    TrackedAssetState& state = m_trackedStates[result.assetIndex];
+    if (result.decision == EvalDecision::FiredGiFinished) {
+        state.knownLoss = false;
         return false;
     }
+    if (state.knownLoss) {
+        return true;
+    }
+    ConfigPlugin::IndexRange range = m_configPlugin.getDescendantRange(result.assetIndex);
+    const std::vector<uint32_t>& descendants = m_configPlugin.getDescendants();
+    for (uint32_t i = range.begin; i < range.end && descendants[i] < m_trackedStates.size(); i++) {
+        TrackedAssetState& descendant = m_trackedStates[descendants[i]];
+        descendant.knownLoss = true;
+        if (descendant.stateEntry) {
+            ConnectionStateStore::getInstance().update(descendant.stateEntry, ConnxStatus::NotConnected,
+                                                       GiStatus::None, nowNs);
+            // Notified with its parent
+            ConnectionStateStore::getInstance().setLossNotified(descendant.stateEntry);
+        }
+        if (descendant.sharedEntry) {
+            SharedStateTable::getInstance().update(descendant.sharedEntry, ConnxStatus::NotConnected,
+                                                   GiStatus::None, nowNs);
+        }
+    }
+    return false;
+}
 
-    const rapidjson::Value& south_event = reading["south_event"];
-    if (!south_event.IsObject()) {
-        UtilityPivot::log_error("%s South event is not an object, ignoring: %s", beforeLog.c_str(), assetValues.c_str());
+/**
+ * Hold the connection losses until the end of the aggregation window, then send a single
+ * notification for all of them.
+ *
+ * The window is closed by the first evaluation after its end, before the event of the reading is
+ * handled, so a recovery arriving after the end no longer cancels the loss. It is also closed by the
+ * evaluation of the loss which makes all the tracked assets lost, as no other loss can join it: the
+ * outage of a whole site is notified with its last loss, without waiting for another reading.
+ * An evaluation sends a single notification, the one of its reading or the oldest held: the others
+ * are held in a fixed ring and sent in order by the next evaluations.
+ *
+ * @param result : result of the evaluation of the reading
+ * @param nowNs : monotonic time of the evaluation
+ * @param notified : receives the event notified when it is not an aggregated notification
+ * @return true if a notification is sent, m_aggregatedAssets then holds the assets of an aggregated notification
+ */
+bool RuleSystemSp::m_aggregate(const EvalResult& result, uint64_t nowNs, EvalResult& notified) {
+    static const std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_aggregate :";
+    static const std::string recoveredLog = "%s %s recovered within the aggregation window";
+    size_t trackedCount = m_configPlugin.getTrackedAssets().size();
+    auto closeWindow = [this, trackedCount]() {
+        PendingNotification& window = m_holdNotification();
+        m_aggregator.take(window.assets);
+        window.siteDown = m_siteDownThreshold > 0 && window.assets.size() * 100 >= m_siteDownThreshold * trackedCount;
+    };
+    if (m_aggregator.isDue(nowNs)) {
+        closeWindow();
+    }
+
+    if (result.decision == EvalDecision::FiredConnectionLost) {
+        if (m_aggregator.add(result.assetIndex, nowNs) && m_isWindowComplete()) {
+            closeWindow();
+        }
+    }
+    else if (result.decision == EvalDecision::FiredGiFinished && m_aggregator.remove(result.assetIndex)) {
+        // Neither the loss nor the recovery are notified
+        UtilityPivot::log_debug(recoveredLog, beforeLog.c_str(),
+                                m_configPlugin.getTrackedAssets()[result.assetIndex].c_str());
+    }
+    else if (result.isFired()) {
+        PendingNotification& event = m_holdNotification();
+        event.result = result;
+        event.assets.clear();
+        event.siteDown = false;
+    }
+    if (m_heldCount == 0) {
         return false;
     }
 
-    std::string connx_status;
-    if (south_event.HasMember("connx_status") && south_event["connx_status"].IsString()) {
-        connx_status = south_event["connx_status"].GetString();
+    PendingNotification& next = m_heldNotifications[m_heldFirst];
+    m_aggregatedAssets.swap(next.assets);
+    m_siteDown = next.siteDown;
+    notified = next.result;
+    m_heldFirst = (m_heldFirst + 1) % MaxHeldNotifications;
+    m_heldCount--;
+    return true;
+}
+
+/**
+ * Whether all the tracked assets are lost, in the window or with a parent of the topology
+ */
+bool RuleSystemSp::m_isWindowComplete() const {
+    size_t lost = m_aggregator.getPendingCount();
+    for (size_t i = 0; i < m_trackedStates.size() && lost < m_trackedStates.size(); i++) {
+        lost += m_trackedStates[i].knownLoss && !m_aggregator.isPending(static_cast<uint32_t>(i));
     }
-    std::string gi_status;
-    if (south_event.HasMember("gi_status") && south_event["gi_status"].IsString()) {
-        gi_status = south_event["gi_status"].GetString();
+    return lost >= m_trackedStates.size();
+}
+
+/**
+ * Record in the persistent state the losses sent by the evaluation, so that a restarted rule does not notify
+ * them again
+ *
+ * @param notified : event notified when it is not an aggregated notification
+ */
+void RuleSystemSp::m_setLossesNotified(const EvalResult& notified) {
+    ConnectionStateStore& store = ConnectionStateStore::getInstance();
+    for (uint32_t assetIndex : m_aggregatedAssets) {
+        if (assetIndex < m_trackedStates.size() && m_trackedStates[assetIndex].stateEntry) {
+            store.setLossNotified(m_trackedStates[assetIndex].stateEntry);
+        }
+    }
+    if (m_aggregatedAssets.empty() && notified.decision == EvalDecision::FiredConnectionLost &&
+        notified.assetIndex < m_trackedStates.size() && m_trackedStates[notified.assetIndex].stateEntry) {
+        store.setLossNotified(m_trackedStates[notified.assetIndex].stateEntry);
     }
+}
 
-    if (connx_status == "not connected") {
-        UtilityPivot::log_debug("%s Sending connection lost notification", beforeLog.c_str());
-        m_asset = "connx_status";
-        m_reason = "not connected";
-        return true;
+/**
+ * Slot at the end of the ring of the held notifications. An evaluation holds at most one more notification
+ * than it sends, and only when a window closes on a fired reading, so the ring does not fill up; if it does,
+ * the oldest notification is dropped rather than allocating.
+ */
+RuleSystemSp::PendingNotification& RuleSystemSp::m_holdNotification() {
+    if (m_heldCount == MaxHeldNotifications) {
+        static const std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_holdNotification :";
+        UtilityPivot::log_error("%s %zu notifications held, the oldest is dropped", beforeLog.c_str(), m_heldCount);
+        m_heldFirst = (m_heldFirst + 1) % MaxHeldNotifications;
+        m_heldCount--;
     }
-    else if (gi_status == "finished") {
-        UtilityPivot::log_debug("%s Sending connected notification", beforeLog.c_str());
-        m_asset = "gi_status";
-        m_reason = "finished";
-        return true;
+    PendingNotification& held = m_heldNotifications[(m_heldFirst + m_heldCount) % MaxHeldNotifications];
+    held.result = EvalResult();
+    m_heldCount++;
+    return held;
+}
+
+/**
+ * Find the branch of the rule matched by a reading, reusing the result of a previous
+ * evaluation of the same reading by an identical configuration when possible
+ *
+ * @param assetValues : JSON string document with notification data.
+ * @param payloadHash : hash of assetValues, only computed for the evaluation cache
+ * @param hashed : set if payloadHash is computed
+ * @return The decision and the statuses of the south_event if any
+ */
+EvalResult RuleSystemSp::m_evaluate(const std::string& assetValues, uint64_t& payloadHash, bool& hashed) const {
+    static const std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_evaluate :";
+    EvalResult result;
+    // Plugin disabled, no filtering
+    if (!isEnabled()) {
+        result.decision = EvalDecision::Disabled;
+        return result;
+    }
+    // No asset to track, no filtering
+    if (!m_configPlugin.hasConnectionLossTracking()) {
+        result.decision = EvalDecision::NoTracking;
+        return result;
     }
+    // Oversized readings are neither hashed nor parsed
+    if (m_payloadGuard.checkSize(assetValues.size()) != PayloadGuard::Verdict::Accepted) {
+        UtilityPivot::log_warn("%s Reading of %zu bytes rejected, above max_payload_size %" PRIu64, beforeLog.c_str(),
+                               assetValues.size(), m_payloadGuard.getLimits().maxSize);
+        result.decision = EvalDecision::PayloadRejected;
+        return result;
+    }
+    if (!m_evalCacheEnabled) {
+        return m_parseReading(assetValues);
+    }
+    payloadHash = UtilityHash::xxh64(assetValues);
+    hashed = true;
+    EvaluationCache& cache = EvaluationCache::getInstance();
+    uint32_t payloadSize = static_cast<uint32_t>(assetValues.size());
+    uint64_t guardKey = m_payloadGuard.getKey();
+    uint64_t fingerprint = UtilityHash::fnv1a64(reinterpret_cast<const char *>(&guardKey), sizeof(guardKey),
+                                                m_configPlugin.getFingerprint());
+    if (cache.lookup(payloadHash, payloadSize, fingerprint, result)) {
+        m_metrics.countCacheHit();
+        return result;
+    }
+    result = m_parseReading(assetValues);
+    cache.store(payloadHash, payloadSize, fingerprint, result);
+    return result;
+}
 
-    return false;
+/**
+ * Parse a reading and find the branch of the rule it matches
+ *
+ * @param assetValues : JSON string document with notification data.
+ * @return The decision and the statuses of the south_event if any
+ */
+EvalResult RuleSystemSp::m_parseReading(const std::string& assetValues) const {
+    static const std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_parseReading :";
+    PayloadGuard::Verdict verdict = m_payloadGuard.check(assetValues.data(), assetValues.size());
+    if (verdict != PayloadGuard::Verdict::Accepted) {
+        const PayloadGuard::Limits& limits = m_payloadGuard.getLimits();
+        UtilityPivot::log_warn("%s Reading of %zu bytes rejected, %s (max_depth %u, max_members %u)", beforeLog.c_str(),
+                               assetValues.size(), PayloadGuard::toString(verdict), limits.maxDepth, limits.maxMembers);
+        EvalResult result;
+        result.decision = EvalDecision::PayloadRejected;
+        return result;
+    }
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    EvalResult result = m_jsonBackend == JsonBackend::OnDemand ?
+        SouthEventReader::readOnDemand(m_structuralIndex, assetValues.data(), assetValues.size(), trackedAssets) :
+        SouthEventReader::readDom(assetValues.c_str(), trackedAssets);
+
+    // The readings of the other assets are ignored at each evaluation, their log allocates nothing
+    const char *message = nullptr;
+    bool error = true;
+    switch (result.decision) {
+        case EvalDecision::ParseError:            message = "JSON parse error in"; break;
+        case EvalDecision::NotAnObject:           message = "Asset is not an object, ignoring"; break;
+        case EvalDecision::WrongAsset:            message = "Asset is not one being tracked, ignoring"; error = false; break;
+        case EvalDecision::ReadingNotAnObject:    message = "Reading is not an object, ignoring"; break;
+        case EvalDecision::NoSouthEvent:          message = "Reading is not a south event, ignoring"; error = false; break;
+        case EvalDecision::SouthEventNotAnObject: message = "South event is not an object, ignoring"; break;
+        default:                                  break;
+    }
+    static const std::string ignoredLog = "%s %s: %.*s%s";
+    if (message != nullptr && error) {
+        UtilityPivot::log_error(ignoredLog, beforeLog.c_str(), message, UtilityPivot::logExcerptLength(assetValues),
+                                assetValues.c_str(), UtilityPivot::logExcerptEllipsis(assetValues));
+    }
+    else if (message != nullptr) {
+        UtilityPivot::log_debug(ignoredLog, beforeLog.c_str(), message, UtilityPivot::logExcerptLength(assetValues),
+                                assetValues.c_str(), UtilityPivot::logExcerptEllipsis(assetValues));
+    }
+    return result;
 }
 
 /**
- * Returns the json string containing the notification data
+ * Returns the json string containing the notification data, rendered from the reason template.
+ * When the asset which fired is a connection, the default reason also holds the
+ * connection and the pivot_id of the prt.inf datapoints reachable through it.
  *
  * @return The JSON containing the notification reason
  */
 std::string RuleSystemSp::getReason() const {
+    uint64_t startNs = RuleMetrics::monotonicNs();
+    std::lock_guard<std::mutex> guard(m_configMutex);
     if (m_reason.empty()) {
+        uint64_t latencyNs = RuleMetrics::monotonicNs() - startNs;
+        m_metrics.reasonLatency().record(latencyNs);
+        SYSTEMSPR_PROBE3(reason__done, m_reason.c_str(), m_reason.size(), latencyNs);
         return m_reason;
     }
-    std::string asset = m_asset;
-    if (asset.empty()) {
-        asset = "prt.inf";
+    m_collectReasonContext(m_reasonContext);
+    m_reasonBuffer.clear();
+    m_reasonTemplate.render(m_reasonBuffer, [this](std::string& out, ReasonTemplate::Slot slot) {
+        m_appendReasonSlot(out, slot, m_reasonContext);
+    });
+    uint64_t latencyNs = RuleMetrics::monotonicNs() - startNs;
+    m_metrics.reasonLatency().record(latencyNs);
+    SYSTEMSPR_PROBE3(reason__done, m_reasonBuffer.c_str(), m_reasonBuffer.size(), latencyNs);
+    return m_reasonBuffer;
+}
+
+/**
+ * Collect the assets of the last notification, their descendants in the topology and the prt.inf
+ * datapoints reachable through those which are connections
+ *
+ * @param context : receives the values of the reason, its vectors are reused
+ */
+void RuleSystemSp::m_collectReasonContext(ReasonContext& context) const {
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    context.connection = nullptr;
+    context.assets.clear();
+    context.impliedAssets.clear();
+    context.datapoints.clear();
+    bool lost = true;
+    if (!m_aggregatedAssets.empty()) {
+        context.assets.assign(m_aggregatedAssets.begin(), m_aggregatedAssets.end());
+        for (uint32_t assetIndex : context.assets) {
+            m_appendConnectionDatapoints(assetIndex, context.datapoints);
+        }
+        context.hasPivotIds = true;
+    }
+    else {
+        context.connection = m_configPlugin.findConnection(m_firedAsset);
+        if (context.connection) {
+            std::vector<uint32_t> datapoints = m_configPlugin.getConnectionDatapoints(*context.connection);
+            context.datapoints.insert(context.datapoints.end(), datapoints.begin(), datapoints.end());
+        }
+        context.hasPivotIds = context.connection != nullptr;
+        auto fired = std::find(trackedAssets.begin(), trackedAssets.end(), m_firedAsset);
+        if (fired != trackedAssets.end()) {
+            context.assets.push_back(static_cast<uint32_t>(fired - trackedAssets.begin()));
+        }
+        lost = m_asset == "connx_status";
     }
 
-    static const std::string reasonTemplate = QUOTE({
-        "asset": "<asset>",
-        "reason": "<reason>"
-    });
-    std::string result = std::regex_replace(reasonTemplate, std::regex("<asset>"), asset);
-    return std::regex_replace(result, std::regex("<reason>"), m_reason);
+    if (lost) {
+        const std::vector<uint32_t>& descendants = m_configPlugin.getDescendants();
+        for (uint32_t assetIndex : context.assets) {
+            ConfigPlugin::IndexRange range = m_configPlugin.getDescendantRange(assetIndex);
+            context.impliedAssets.insert(context.impliedAssets.end(), descendants.begin() + range.begin,
+                                         descendants.begin() + range.end);
+        }
+        std::sort(context.impliedAssets.begin(), context.impliedAssets.end());
+        context.impliedAssets.erase(std::unique(context.impliedAssets.begin(), context.impliedAssets.end()),
+                                    context.impliedAssets.end());
+        context.impliedAssets.erase(std::remove_if(context.impliedAssets.begin(), context.impliedAssets.end(),
+            [&context](uint32_t assetIndex) {
+                return std::find(context.assets.begin(), context.assets.end(), assetIndex) != context.assets.end();
+            }), context.impliedAssets.end());
+        for (uint32_t assetIndex : context.impliedAssets) {
+            m_appendConnectionDatapoints(assetIndex, context.datapoints);
+        }
+    }
+    std::sort(context.datapoints.begin(), context.datapoints.end());
+    context.datapoints.erase(std::unique(context.datapoints.begin(), context.datapoints.end()), context.datapoints.end());
+}
+
+/**
+ * Append the prt.inf datapoints reachable through a tracked asset if it is a connection
+ */
+void RuleSystemSp::m_appendConnectionDatapoints(uint32_t assetIndex, std::vector<uint32_t>& datapoints) const {
+    const ConfigPlugin::Connection *connection =
+        m_configPlugin.findConnection(m_configPlugin.getTrackedAssets()[assetIndex]);
+    if (connection) {
+        std::vector<uint32_t> connectionDatapoints = m_configPlugin.getConnectionDatapoints(*connection);
+        datapoints.insert(datapoints.end(), connectionDatapoints.begin(), connectionDatapoints.end());
+    }
+}
+
+/**
+ * Append the value of a placeholder of the reason template
+ *
+ * @param reason : JSON of the reason being built
+ * @param slot : placeholder
+ * @param context : values of the last notification
+ */
+void RuleSystemSp::m_appendReasonSlot(std::string& reason, ReasonTemplate::Slot slot,
+                                      const ReasonContext& context) const {
+    switch (slot) {
+        case ReasonTemplate::Slot::Asset:
+            UtilityPivot::appendJsonEscaped(reason, m_asset.empty() ? std::string("prt.inf") : m_asset);
+            break;
+        case ReasonTemplate::Slot::Reason:
+            UtilityPivot::appendJsonEscaped(reason, m_reason);
+            break;
+        case ReasonTemplate::Slot::FiredAsset:
+            UtilityPivot::appendJsonEscaped(reason, m_firedAsset);
+            break;
+        case ReasonTemplate::Slot::Connection:
+            if (context.connection) {
+                UtilityPivot::appendJsonEscaped(reason, context.connection->asset);
+            }
+            break;
+        case ReasonTemplate::Slot::Timestamp: {
+            time_t seconds = static_cast<time_t>(m_firedTimeNs / 1000000000ULL);
+            struct tm utc;
+            char buffer[64];
+            gmtime_r(&seconds, &utc);
+            size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &utc);
+            snprintf(buffer + length, sizeof(buffer) - length, ".%06u+00:00",
+                     static_cast<unsigned>(m_firedTimeNs % 1000000000ULL / 1000));
+            reason += buffer;
+            break;
+        }
+        case ReasonTemplate::Slot::Assets:
+            m_appendAssetArray(reason, context.assets);
+            break;
+        case ReasonTemplate::Slot::ImpliedAssets:
+            m_appendAssetArray(reason, context.impliedAssets);
+            break;
+        case ReasonTemplate::Slot::PivotIds:
+            m_appendPivotIds(reason, context.datapoints);
+            break;
+        case ReasonTemplate::Slot::SiteDown:
+            reason += m_siteDown ? "true" : "false";
+            break;
+        case ReasonTemplate::Slot::Details:
+            m_appendReasonDetails(reason, context);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Append the members of the default reason following asset and reason: the connection or the
+ * aggregated assets, the implied assets, the pivot_ids and site_down, each when relevant
+ *
+ * @param reason : JSON of the reason being built
+ * @param context : values of the last notification
+ */
+void RuleSystemSp::m_appendReasonDetails(std::string& reason, const ReasonContext& context) const {
+    bool aggregated = !m_aggregatedAssets.empty();
+    if (aggregated) {
+        reason += ", \"assets\": ";
+        m_appendAssetArray(reason, context.assets);
+    }
+    else if (context.connection) {
+        reason += ", \"connection\": \"";
+        UtilityPivot::appendJsonEscaped(reason, context.connection->asset);
+        reason += '"';
+    }
+    if (!context.impliedAssets.empty()) {
+        reason += ", \"implied_assets\": ";
+        m_appendAssetArray(reason, context.impliedAssets);
+    }
+    if (context.hasPivotIds) {
+        reason += ", \"pivot_ids\": ";
+        m_appendPivotIds(reason, context.datapoints);
+    }
+    if (aggregated && m_siteDownThreshold > 0) {
+        reason += m_siteDown ? ", \"site_down\": true" : ", \"site_down\": false";
+    }
+}
+
+/**
+ * Append the names of tracked assets to the reason as a JSON array
+ */
+void RuleSystemSp::m_appendAssetArray(std::string& reason, const std::vector<uint32_t>& assets) const {
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    reason += '[';
+    const char *separator = " \"";
+    for (uint32_t assetIndex : assets) {
+        reason += separator;
+        UtilityPivot::appendJsonEscaped(reason, trackedAssets[assetIndex]);
+        reason += '"';
+        separator = ", \"";
+    }
+    reason += " ]";
+}
+
+/**
+ * Append the pivot_id of datapoints to the reason as a JSON array
+ */
+void RuleSystemSp::m_appendPivotIds(std::string& reason, const std::vector<uint32_t>& datapoints) const {
+    reason += '[';
+    const char *separator = " \"";
+    for (uint32_t datapoint : datapoints) {
+        reason += separator;
+        UtilityPivot::appendJsonEscaped(reason, m_configPlugin.getDatapoints()[datapoint].pivotId);
+        reason += '"';
+        separator = ", \"";
+    }
+    reason += " ]";
+}
+
+/**
+ * Returns the link state of the tracked asset, kept across restarts
+ *
+ * @return The link state, Unknown if no state is recorded
+ */
+LinkState RuleSystemSp::getLinkState() const {
+    return getLinkState(m_configPlugin.getTrackedAsset());
+}
+
+/**
+ * Returns the link state of one of the tracked assets or connections, kept across restarts
+ *
+ * @param asset : name of the asset
+ * @return The link state, Unknown if no state is recorded
+ */
+LinkState RuleSystemSp::getLinkState(const std::string& asset) const {
+    std::lock_guard<std::mutex> guard(m_configMutex);
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    for (size_t i = 0; i < trackedAssets.size() && i < m_trackedStates.size(); i++) {
+        if (trackedAssets[i] == asset && m_trackedStates[i].stateEntry) {
+            return m_trackedStates[i].stateEntry->getLinkState();
+        }
+    }
+    return LinkState::Unknown;
 }
 
 /**
  * Returns the json triggers that should cause eval to be called
  *
- * @return The JSON containing the trigger asset
+ * @return The JSON containing the tracked asset and the connection assets
  */
 std::string RuleSystemSp::getTriggers() const {
     std::lock_guard<std::mutex> guard(m_configMutex);
-    const std::string& trackedAsset = m_configPlugin.getTrackedAsset();
-    if (trackedAsset.empty()) {
+    const std::vector<std::string>& trackedAssets = m_configPlugin.getTrackedAssets();
+    if (trackedAssets.empty()) {
         return QUOTE({"triggers": []});
     }
 
-    static const std::string triggersTemplate = QUOTE({
-		"triggers": [
-			{
-				"asset": "<asset>"
-			}
-		]
-	});
-    return std::regex_replace(triggersTemplate, std::regex("<asset>"), trackedAsset);
+    // Sized once, the returned string is the only allocation
+    static const char prefix[] = "{ \"triggers\": [ ";
+    static const char assetPrefix[] = ", { \"asset\": \"";
+    size_t length = sizeof(prefix) + 4;
+    for (const std::string& asset : trackedAssets) {
+        length += sizeof(assetPrefix) + 3 + asset.size();
+    }
+    std::string triggers;
+    triggers.reserve(length);
+    triggers += prefix;
+    for (size_t i = 0; i < trackedAssets.size(); i++) {
+        triggers += i ? assetPrefix : assetPrefix + 2;
+        UtilityPivot::appendJsonEscaped(triggers, trackedAssets[i]);
+        triggers += "\" }";
+    }
+    triggers += " ] }";
+    return triggers;
 }
 
 /**
@@ -174,10 +827,168 @@ std::string RuleSystemSp::getTriggers() const {
  * @param newConfig  The JSON of the new configuration
  */
 void RuleSystemSp::reconfigure(const ConfigCategory& config) {
-    std::lock_guard<std::mutex> guard(m_configMutex);
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::reconfigure :";
+    uint64_t startNs = RuleMetrics::monotonicNs();
+    SYSTEMSPR_PROBE(reconfigure__start);
+    // Concurrent reconfigurations would stop and start the watch thread together
+    std::lock_guard<std::mutex> reconfigureGuard(m_reconfigureMutex);
+    // The watch thread takes the lock to swap the exchanged_data, it is stopped first
+    m_watcher.stop();
+    std::unique_lock<std::mutex> guard(m_configMutex);
+    uint64_t lockedNs = RuleMetrics::monotonicNs();
     if (config.itemExists("enable")) {
         m_enabled = config.getValue("enable").compare("true") == 0 ||
                     config.getValue("enable").compare("True") == 0;
     }
+    if (config.itemExists("decision_trace_signal")) {
+        std::string signalName = config.getValue("decision_trace_signal");
+        // true is the value of the boolean item of the previous versions
+        int signalNumber = signalName == "SIGUSR1" ? SIGUSR1 :
+                           signalName == "SIGUSR2" || signalName == "true" || signalName == "True" ? SIGUSR2 : 0;
+        m_traceSignal.set(signalNumber);
+    }
+    if (config.itemExists("journal")) {
+        m_journalEnabled = config.getValue("journal").compare("true") == 0 ||
+                           config.getValue("journal").compare("True") == 0;
+    }
+    if (config.itemExists("journal_size")) {
+        unsigned long size = strtoul(config.getValue("journal_size").c_str(), nullptr, 10);
+        m_journalSize = size > 0 && size <= UINT32_MAX ? static_cast<uint32_t>(size) : NotificationJournal::DefaultCapacity;
+    }
+    if (config.itemExists("eval_cache")) {
+        m_evalCacheEnabled = config.getValue("eval_cache").compare("true") == 0 ||
+                             config.getValue("eval_cache").compare("True") == 0;
+    }
+    if (config.itemExists("json_backend") &&
+        !SouthEventReader::parseBackend(config.getValue("json_backend"), m_jsonBackend)) {
+        UtilityPivot::log_error("%s Unknown json_backend %s, using rapidjson", beforeLog.c_str(),
+                                config.getValue("json_backend").c_str());
+        m_jsonBackend = JsonBackend::RapidJson;
+    }
+    PayloadGuard::Limits limits = m_payloadGuard.getLimits();
+    if (config.itemExists("max_payload_size")) {
+        limits.maxSize = strtoull(config.getValue("max_payload_size").c_str(), nullptr, 10);
+    }
+    if (config.itemExists("max_depth")) {
+        unsigned long depth = strtoul(config.getValue("max_depth").c_str(), nullptr, 10);
+        limits.maxDepth = depth <= UINT32_MAX ? static_cast<uint32_t>(depth) : UINT32_MAX;
+    }
+    if (config.itemExists("max_members")) {
+        unsigned long members = strtoul(config.getValue("max_members").c_str(), nullptr, 10);
+        limits.maxMembers = members <= UINT32_MAX ? static_cast<uint32_t>(members) : UINT32_MAX;
+    }
+    m_payloadGuard.configure(limits);
+    if (config.itemExists("aggregation_window")) {
+        unsigned long windowMs = strtoul(config.getValue("aggregation_window").c_str(), nullptr, 10);
+        m_aggregationWindowNs = static_cast<uint64_t>(windowMs) * 1000000ULL;
+    }
+    if (config.itemExists("site_down_threshold")) {
+        unsigned long threshold = strtoul(config.getValue("site_down_threshold").c_str(), nullptr, 10);
+        m_siteDownThreshold = threshold <= 100 ? static_cast<uint32_t>(threshold) : 100;
+    }
+    if (config.itemExists("reason_template")) {
+        std::string reasonTemplate = config.getValue("reason_template");
+        m_reasonTemplate.compile(reasonTemplate.empty() ? ReasonTemplate::Default : reasonTemplate);
+    }
+    if (config.itemExists("shared_state_name")) {
+        m_sharedStateName = config.getValue("shared_state_name");
+        if (!m_sharedStateName.empty() && m_sharedStateName[0] != '/') {
+            m_sharedStateName.insert(0, "/");
+        }
+    }
+    m_configureMetrics(config);
+    m_configureCapture(config);
     setJsonConfig(config);
+    m_attachJournal();
+
+    std::string exchangedDataFile = m_exchangedDataFile;
+    size_t trackedCount = m_trackedStates.size();
+    uint64_t stallNs = RuleMetrics::monotonicNs() - lockedNs;
+    m_metrics.countReconfigureStall(stallNs);
+    guard.unlock();
+
+    if (!exchangedDataFile.empty()) {
+        m_watcher.start(exchangedDataFile, ExchangedDataWatcher::DefaultDebounceMs,
+                        [this]() { m_reloadExchangedDataFile(); });
+    }
+    uint64_t latencyNs = RuleMetrics::monotonicNs() - startNs;
+    m_metrics.reconfigureLatency().record(latencyNs);
+    SYSTEMSPR_PROBE3(reconfigure__done, trackedCount, stallNs, latencyNs);
+}
+
+/**
+ * Reload the exchanged_data file after a modification, called by the watch thread.
+ *
+ * The file is imported into a copy of the configuration without holding the lock, so that
+ * evaluations go on with the current configuration, which is then replaced under the lock.
+ */
+void RuleSystemSp::m_reloadExchangedDataFile() {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_reloadExchangedDataFile :";
+    ConfigPlugin staged;
+    {
+        std::lock_guard<std::mutex> guard(m_configMutex);
+        staged = m_configPlugin;
+    }
+    if (!staged.importExchangedDataFile(m_watcher.getPath())) {
+        return;
+    }
+    const ConfigPlugin::Delta& delta = staged.getLastDelta();
+    UtilityPivot::log_info("%s %s reloaded, %u datapoints added, %u removed, %u changed", beforeLog.c_str(),
+                           m_watcher.getPath().c_str(), delta.added, delta.removed, delta.changed);
+
+    std::lock_guard<std::mutex> guard(m_configMutex);
+    uint64_t lockedNs = RuleMetrics::monotonicNs();
+    m_configPlugin = std::move(staged);
+    m_metrics.countReconfigureStall(RuleMetrics::monotonicNs() - lockedNs);
+}
+
+/**
+ * Open the capture file of the readings, a relative file is written in the plugin data directory
+ *
+ * @param config : configuration of the plugin
+ */
+void RuleSystemSp::m_configureCapture(const ConfigCategory& config) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - RuleSystemSp::m_configureCapture :";
+    if (!config.itemExists("capture_file")) {
+        return;
+    }
+    std::string path = config.getValue("capture_file");
+    if (!path.empty() && path[0] != '/') {
+        std::string dir = UtilityPivot::getPluginDataDir();
+        path = dir.empty() ? "" : dir + "/" + path;
+    }
+    if (path == m_capture.getPath()) {
+        return;
+    }
+    if (m_capture.isOpen() && m_capture.getDropped() > 0) {
+        UtilityPivot::log_warn("%s %" PRIu64 " readings dropped from %s", beforeLog.c_str(), m_capture.getDropped(),
+                               m_capture.getPath().c_str());
+    }
+    m_capture.close();
+    if (!path.empty()) {
+        m_capture.open(path);
+    }
+}
+
+/**
+ * Configure the periodic export of the metrics, a relative file is written in the plugin data directory
+ *
+ * @param config : configuration of the plugin
+ */
+void RuleSystemSp::m_configureMetrics(const ConfigCategory& config) {
+    std::string path = config.itemExists("metrics_file") ? config.getValue("metrics_file") : "";
+    if (!path.empty() && path[0] != '/') {
+        std::string dir = UtilityPivot::getPluginDataDir();
+        path = dir.empty() ? "" : dir + "/" + path;
+    }
+    RuleMetrics::Format format = RuleMetrics::Format::Json;
+    if (config.itemExists("metrics_format") && config.getValue("metrics_format").compare("prometheus") == 0) {
+        format = RuleMetrics::Format::Prometheus;
+    }
+    uint64_t intervalNs = 10ULL * 1000000000ULL;
+    if (config.itemExists("metrics_interval")) {
+        unsigned long seconds = strtoul(config.getValue("metrics_interval").c_str(), nullptr, 10);
+        intervalNs = static_cast<uint64_t>(seconds) * 1000000000ULL;
+    }
+    m_metrics.setExport(config.getName(), path, format, intervalNs);
 }
@@ -0,0 +1,400 @@
+/*
+ * Connection states published in shared memory for the local consumers
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "sharedStateTable.h"
+#include "constantsSystem.h"
+#include "utilityHash.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+constexpr uint32_t SharedStateTable::Magic;
+constexpr uint16_t SharedStateTable::Version;
+constexpr uint32_t SharedStateTable::Capacity;
+constexpr size_t   SharedStateTable::MaxAssetLength;
+constexpr int      SharedStateTable::PollIntervalMs;
+constexpr uint32_t SharedStateTable::MaxReadRetries;
+
+namespace {
+
+long futex(const std::atomic<uint32_t> *word, int operation, uint32_t value, const struct timespec *timeout) {
+    // Not FUTEX_PRIVATE_FLAG, the word is shared between processes
+    return syscall(SYS_futex, reinterpret_cast<const uint32_t *>(word), operation, value, timeout, nullptr, 0);
+}
+};
+
+SharedStateTable::~SharedStateTable() {
+    close();
+}
+
+/**
+ * Map the shared memory object, creating or resetting it when it does not match the current layout.
+ * A writer also releases the entries left locked by a writer killed during an update.
+ *
+ * @param name : name of the shared memory object, starting with '/'
+ * @param readOnly : map an existing object for reading only
+ * @return true if the object is mapped
+ */
+bool SharedStateTable::open(const std::string& name, bool readOnly) {
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - SharedStateTable::open :";
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_mapping) {
+        return true;
+    }
+
+    // A reader which may write the object maps its header writable too, to count itself among the waiters
+    int fd = shm_open(name.c_str(), readOnly ? O_RDWR : O_RDWR | O_CREAT, 0644);
+    bool writable = fd >= 0;
+    if (!writable && readOnly) {
+        fd = shm_open(name.c_str(), O_RDONLY, 0644);
+    }
+    if (fd < 0) {
+        UtilityPivot::log_warn("%s Unable to open %s: %s", beforeLog.c_str(), name.c_str(), strerror(errno));
+        return false;
+    }
+
+    size_t expectedSize = sizeof(Header) + Capacity * sizeof(Entry);
+    struct stat st;
+    bool resized = false;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expectedSize) {
+        if (readOnly || ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(expectedSize)) != 0) {
+            UtilityPivot::log_warn("%s %s does not have the expected size", beforeLog.c_str(), name.c_str());
+            ::close(fd);
+            return false;
+        }
+        resized = true;
+    }
+
+    void *mapping = mmap(nullptr, expectedSize, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void *waitMapping = MAP_FAILED;
+    if (readOnly && writable && mapping != MAP_FAILED) {
+        waitMapping = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        UtilityPivot::log_warn("%s Unable to map %s: %s", beforeLog.c_str(), name.c_str(), strerror(errno));
+        return false;
+    }
+
+    m_name = name;
+    m_mapping = mapping;
+    m_mappingSize = expectedSize;
+    m_header = static_cast<Header *>(mapping);
+    m_entries = reinterpret_cast<Entry *>(static_cast<char *>(mapping) + sizeof(Header));
+
+    if (resized || m_header->magic != Magic || m_header->version != Version ||
+        m_header->entrySize != sizeof(Entry) || m_header->capacity != Capacity) {
+        if (readOnly) {
+            UtilityPivot::log_warn("%s %s has an unknown layout", beforeLog.c_str(), name.c_str());
+            munmap(mapping, expectedSize);
+            if (waitMapping != MAP_FAILED) {
+                munmap(waitMapping, sizeof(Header));
+            }
+            m_mapping = nullptr;
+            m_header = nullptr;
+            m_entries = nullptr;
+            return false;
+        }
+        m_initialize();
+    }
+    if (!readOnly) {
+        m_waiters = &m_header->waiters;
+        for (uint32_t i = 0; i < Capacity; i++) {
+            uint32_t sequence = m_entries[i].sequence.load(std::memory_order_relaxed);
+            if (sequence & 1) {
+                UtilityPivot::log_warn("%s Entry %s was left locked, released", beforeLog.c_str(), m_entries[i].asset);
+                m_entries[i].sequence.store(sequence + 1, std::memory_order_release);
+            }
+        }
+    }
+    else if (waitMapping != MAP_FAILED) {
+        m_waitMapping = waitMapping;
+        m_waiters = &static_cast<Header *>(waitMapping)->waiters;
+    }
+    return true;
+}
+
+/**
+ * Unmap the shared memory object, which is kept for the readers
+ */
+void SharedStateTable::close() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_mapping) {
+        return;
+    }
+    munmap(m_mapping, m_mappingSize);
+    if (m_waitMapping) {
+        munmap(m_waitMapping, sizeof(Header));
+        m_waitMapping = nullptr;
+    }
+    m_waiters = nullptr;
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_name.clear();
+}
+
+/**
+ * Return the entry of an asset, allocating it if it does not exist yet.
+ * The entries are allocated under a lock of the process, so a single process may allocate them;
+ * any thread of this process may then update them.
+ *
+ * @param asset : name of the connection asset
+ * @return The entry, nullptr if the table is not open or is full
+ */
+SharedStateTable::Entry* SharedStateTable::acquire(const std::string& asset) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_entries) {
+        return nullptr;
+    }
+    uint64_t hash = m_hashAsset(asset);
+    for (uint32_t probe = 0; probe < Capacity; probe++) {
+        Entry& entry = m_entries[(hash + probe) % Capacity];
+        uint64_t entryHash = entry.assetHash.load(std::memory_order_relaxed);
+        if (entryHash == hash && strncmp(entry.asset, asset.c_str(), MaxAssetLength) == 0) {
+            return &entry;
+        }
+        if (entryHash == 0) {
+            size_t length = std::min(asset.size(), MaxAssetLength);
+            memcpy(entry.asset, asset.data(), length);
+            entry.asset[length] = '\0';
+            // Readers only look at the name once the hash is visible
+            entry.assetHash.store(hash, std::memory_order_release);
+            m_header->count.fetch_add(1, std::memory_order_relaxed);
+            return &entry;
+        }
+    }
+    std::string beforeLog = ConstantsSystem::NamePlugin + " - SharedStateTable::acquire :";
+    UtilityPivot::log_error("%s No free entry for asset %s", beforeLog.c_str(), asset.c_str());
+    return nullptr;
+}
+
+/**
+ * Record the statuses of a south_event received for an asset, as ConnectionStateStore::update
+ *
+ * @param entry : entry returned by acquire
+ * @param connx : connx_status of the south_event
+ * @param gi : gi_status of the south_event
+ * @param nowNs : realtime of the event in nanoseconds
+ * @return true if the entry changed
+ */
+bool SharedStateTable::update(Entry* entry, ConnxStatus connx, GiStatus gi, uint64_t nowNs) {
+    // The new state depends on the current one, both are read and written under the entry lock
+    uint32_t sequence = m_lockEntry(entry);
+    LinkState previous = static_cast<LinkState>(entry->linkState.load(std::memory_order_relaxed));
+    LinkState next = SouthEvent::nextLinkState(previous, connx, gi);
+    bool changed = next != previous;
+    if (changed) {
+        entry->linkState.store(static_cast<uint8_t>(next), std::memory_order_relaxed);
+        entry->updatedNs.store(nowNs, std::memory_order_relaxed);
+        if (next == LinkState::NotConnected) {
+            entry->lossCount.store(entry->lossCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+    if (connx != ConnxStatus::None && entry->connxStatus.load(std::memory_order_relaxed) != static_cast<uint8_t>(connx)) {
+        entry->connxStatus.store(static_cast<uint8_t>(connx), std::memory_order_relaxed);
+        changed = true;
+    }
+    if (gi != GiStatus::None && entry->giStatus.load(std::memory_order_relaxed) != static_cast<uint8_t>(gi)) {
+        entry->giStatus.store(static_cast<uint8_t>(gi), std::memory_order_relaxed);
+        changed = true;
+    }
+    m_unlockEntry(entry, sequence, changed);
+    return changed;
+}
+
+/**
+ * Write an entry and wake up the readers waiting for a change
+ *
+ * @param entry : entry returned by acquire
+ * @return false if the entry already held these values
+ */
+bool SharedStateTable::publish(Entry* entry, LinkState linkState, ConnxStatus connx, GiStatus gi, uint32_t lossCount,
+                               uint64_t updatedNs) {
+    uint32_t sequence = m_lockEntry(entry);
+    bool changed = entry->linkState.load(std::memory_order_relaxed) != static_cast<uint8_t>(linkState) ||
+                   entry->connxStatus.load(std::memory_order_relaxed) != static_cast<uint8_t>(connx) ||
+                   entry->giStatus.load(std::memory_order_relaxed) != static_cast<uint8_t>(gi) ||
+                   entry->lossCount.load(std::memory_order_relaxed) != lossCount ||
+                   entry->updatedNs.load(std::memory_order_relaxed) != updatedNs;
+    if (changed) {
+        entry->linkState.store(static_cast<uint8_t>(linkState), std::memory_order_relaxed);
+        entry->connxStatus.store(static_cast<uint8_t>(connx), std::memory_order_relaxed);
+        entry->giStatus.store(static_cast<uint8_t>(gi), std::memory_order_relaxed);
+        entry->lossCount.store(lossCount, std::memory_order_relaxed);
+        entry->updatedNs.store(updatedNs, std::memory_order_relaxed);
+    }
+    m_unlockEntry(entry, sequence, changed);
+    return changed;
+}
+
+/**
+ * Find the entry of an asset
+ *
+ * @param asset : name of the connection asset
+ * @return The entry, nullptr if the asset is not published
+ */
+const SharedStateTable::Entry* SharedStateTable::find(const std::string& asset) const {
+    if (!m_entries) {
+        return nullptr;
+    }
+    uint64_t hash = m_hashAsset(asset);
+    for (uint32_t probe = 0; probe < Capacity; probe++) {
+        const Entry& entry = m_entries[(hash + probe) % Capacity];
+        uint64_t entryHash = entry.assetHash.load(std::memory_order_acquire);
+        if (entryHash == 0) {
+            return nullptr;
+        }
+        if (entryHash == hash && strncmp(entry.asset, asset.c_str(), MaxAssetLength) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Copy an entry, retrying while it is written
+ *
+ * @param entry : entry of the table
+ * @param state : receives the copy
+ * @return false if the slot is free, or still being written after MaxReadRetries tries
+ */
+bool SharedStateTable::read(const Entry& entry, State& state) {
+    if (entry.assetHash.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    state.asset.assign(entry.asset, strnlen(entry.asset, MaxAssetLength));
+    for (uint32_t retry = 0; retry < MaxReadRetries; retry++) {
+        if (retry > 0) {
+            std::this_thread::yield();
+        }
+        uint32_t before = entry.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        state.linkState = static_cast<LinkState>(entry.linkState.load(std::memory_order_relaxed));
+        state.connxStatus = static_cast<ConnxStatus>(entry.connxStatus.load(std::memory_order_relaxed));
+        state.giStatus = static_cast<GiStatus>(entry.giStatus.load(std::memory_order_relaxed));
+        state.lossCount = entry.lossCount.load(std::memory_order_relaxed);
+        state.updatedNs = entry.updatedNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Sleep until the table is updated
+ *
+ * @param changes : value of getChanges when the table was last read
+ * @param timeoutMs : maximum wait, negative to wait forever
+ * @return true if the table was updated since changes
+ */
+bool SharedStateTable::waitForChange(uint32_t changes, int timeoutMs) const {
+    if (!m_header) {
+        return false;
+    }
+    if (!m_waiters) {
+        // Not allowed to write the object, so not woken up: poll it
+        for (int waitedMs = 0; timeoutMs < 0 || waitedMs < timeoutMs; waitedMs += PollIntervalMs) {
+            if (m_header->changes.load(std::memory_order_acquire) != changes) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(PollIntervalMs));
+        }
+        return m_header->changes.load(std::memory_order_acquire) != changes;
+    }
+    struct timespec timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    // Counted before reading changes: the writer incrementing changes then sees the waiter
+    m_waiters->fetch_add(1, std::memory_order_seq_cst);
+    while (m_header->changes.load(std::memory_order_seq_cst) == changes) {
+        long result = futex(&m_header->changes, FUTEX_WAIT, changes, timeoutMs < 0 ? nullptr : &timeout);
+        if (result != 0 && errno == ETIMEDOUT) {
+            break;
+        }
+    }
+    m_waiters->fetch_sub(1, std::memory_order_relaxed);
+    return m_header->changes.load(std::memory_order_acquire) != changes;
+}
+
+/**
+ * Remove a shared memory object
+ */
+bool SharedStateTable::unlink(const std::string& name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+/**
+ * Table shared by all the rule instances of the process, opened by the first instance publishing states
+ */
+SharedStateTable& SharedStateTable::getInstance() {
+    static SharedStateTable instance;
+    return instance;
+}
+
+uint64_t SharedStateTable::m_hashAsset(const std::string& asset) {
+    uint64_t hash = UtilityHash::fnv1a64(asset);
+    return hash == 0 ? 1 : hash;
+}
+
+/**
+ * Lock the mutex of an entry, then make its sequence odd
+ *
+ * @return The even sequence before the lock
+ */
+uint32_t SharedStateTable::m_lockEntry(Entry* entry) {
+    m_entryMutexes[entry - m_entries].lock();
+    uint32_t sequence = entry->sequence.load(std::memory_order_relaxed);
+    entry->sequence.store(sequence + 1, std::memory_order_relaxed);
+    // The fields written afterwards are not visible before the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+}
+
+/**
+ * Make the sequence of an entry even again and, if it changed, wake up the readers waiting for a change
+ *
+ * @param sequence : value returned by m_lockEntry
+ * @param changed : false to restore the sequence, the readers then do not see any change
+ */
+void SharedStateTable::m_unlockEntry(Entry* entry, uint32_t sequence, bool changed) {
+    entry->sequence.store(changed ? sequence + 2 : sequence, std::memory_order_release);
+    m_entryMutexes[entry - m_entries].unlock();
+    if (!changed) {
+        return;
+    }
+    m_header->changes.fetch_add(1, std::memory_order_seq_cst);
+    if (m_header->waiters.load(std::memory_order_seq_cst) != 0) {
+        futex(&m_header->changes, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+}
+
+void SharedStateTable::m_initialize() {
+    memset(m_mapping, 0, m_mappingSize);
+    m_header->magic = Magic;
+    m_header->version = Version;
+    m_header->entrySize = sizeof(Entry);
+    m_header->capacity = Capacity;
+}
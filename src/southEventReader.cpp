@@ -0,0 +1,237 @@
+/*
+ * Extraction of the south_event of a tracked asset from a reading
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstring>
+
+#include <rapidjson/document.h>
+
+#include "southEventReader.h"
+
+using namespace systemspr;
+
+namespace {
+
+/*
+ * Decision of a south_event from its statuses
+ */
+void decideStatus(EvalResult& result) {
+    if (result.connxStatus == ConnxStatus::NotConnected) {
+        result.decision = EvalDecision::FiredConnectionLost;
+    }
+    else if (result.giStatus == GiStatus::Finished) {
+        result.decision = EvalDecision::FiredGiFinished;
+    }
+    else {
+        result.decision = EvalDecision::NoStatusMatch;
+    }
+}
+
+/*
+ * Compare the raw content of a string of the reading to a name
+ */
+bool keyEquals(const char *key, size_t length, bool escaped, const char *name, size_t nameLength,
+               std::string& decoded) {
+    if (!escaped) {
+        return length == nameLength && memcmp(key, name, length) == 0;
+    }
+    return StructuralIndex::unescape(key, length, decoded) && decoded.size() == nameLength &&
+           memcmp(decoded.data(), name, nameLength) == 0;
+}
+};
+
+EvalResult SouthEventReader::readDom(const char *data, const std::vector<std::string>& trackedAssets) {
+    EvalResult result;
+    rapidjson::Document doc;
+    doc.Parse(data);
+    if (doc.HasParseError()) {
+        result.decision = EvalDecision::ParseError;
+        return result;
+    }
+    if (!doc.IsObject()) {
+        result.decision = EvalDecision::NotAnObject;
+        return result;
+    }
+
+    result.assetIndex = static_cast<uint32_t>(trackedAssets.size());
+    for (uint32_t i = 0; i < trackedAssets.size(); i++) {
+        if (doc.HasMember(trackedAssets[i].c_str())) {
+            result.assetIndex = i;
+            break;
+        }
+    }
+    if (result.assetIndex == trackedAssets.size()) {
+        result.decision = EvalDecision::WrongAsset;
+        return result;
+    }
+
+    const rapidjson::Value& reading = doc[trackedAssets[result.assetIndex].c_str()];
+    if (!reading.IsObject()) {
+        result.decision = EvalDecision::ReadingNotAnObject;
+        return result;
+    }
+    if (!reading.HasMember("south_event")) {
+        result.decision = EvalDecision::NoSouthEvent;
+        return result;
+    }
+    const rapidjson::Value& southEvent = reading["south_event"];
+    if (!southEvent.IsObject()) {
+        result.decision = EvalDecision::SouthEventNotAnObject;
+        return result;
+    }
+
+    if (southEvent.HasMember("connx_status") && southEvent["connx_status"].IsString()) {
+        const rapidjson::Value& value = southEvent["connx_status"];
+        result.connxStatus = SouthEvent::parseConnxStatus(value.GetString(), value.GetStringLength());
+    }
+    if (southEvent.HasMember("gi_status") && southEvent["gi_status"].IsString()) {
+        const rapidjson::Value& value = southEvent["gi_status"];
+        result.giStatus = SouthEvent::parseGiStatus(value.GetString(), value.GetStringLength());
+    }
+    decideStatus(result);
+    return result;
+}
+
+namespace {
+
+/*
+ * readOnDemand on the whole buffer, null characters included
+ */
+EvalResult readIndexed(StructuralIndex& index, const char *data, size_t length,
+                       const std::vector<std::string>& trackedAssets) {
+    EvalResult result;
+    if (!index.build(data, length) || !index.validate()) {
+        result.decision = EvalDecision::ParseError;
+        return result;
+    }
+    StructuralIndex::Value root = index.getRoot();
+    if (root.type == StructuralIndex::Type::Invalid) {
+        result.decision = EvalDecision::ParseError;
+        return result;
+    }
+    if (root.type != StructuralIndex::Type::Object) {
+        result.decision = EvalDecision::NotAnObject;
+        return result;
+    }
+
+    // The first tracked asset present in the reading, at its first occurrence
+    std::string decoded;
+    StructuralIndex::Value reading;
+    result.assetIndex = static_cast<uint32_t>(trackedAssets.size());
+    bool valid = index.forEachMember(root, [&](const char *key, size_t keyLength, bool escaped,
+                                               const StructuralIndex::Value& value) {
+        for (uint32_t i = 0; i < result.assetIndex; i++) {
+            if (keyEquals(key, keyLength, escaped, trackedAssets[i].data(), trackedAssets[i].size(), decoded)) {
+                result.assetIndex = i;
+                reading = value;
+                break;
+            }
+        }
+        return result.assetIndex > 0;
+    });
+    if (!valid) {
+        result.decision = EvalDecision::ParseError;
+        return result;
+    }
+    if (result.assetIndex == trackedAssets.size()) {
+        result.decision = EvalDecision::WrongAsset;
+        return result;
+    }
+    if (reading.type != StructuralIndex::Type::Object) {
+        result.decision = EvalDecision::ReadingNotAnObject;
+        return result;
+    }
+
+    static const char southEventKey[] = "south_event";
+    StructuralIndex::Value southEvent;
+    if (!index.forEachMember(reading, [&](const char *key, size_t keyLength, bool escaped,
+                                          const StructuralIndex::Value& value) {
+            if (keyEquals(key, keyLength, escaped, southEventKey, sizeof(southEventKey) - 1, decoded)) {
+                southEvent = value;
+                return false;
+            }
+            return true;
+        })) {
+        result.decision = EvalDecision::ParseError;
+        return result;
+    }
+    if (southEvent.type == StructuralIndex::Type::Invalid) {
+        result.decision = EvalDecision::NoSouthEvent;
+        return result;
+    }
+    if (southEvent.type != StructuralIndex::Type::Object) {
+        result.decision = EvalDecision::SouthEventNotAnObject;
+        return result;
+    }
+
+    static const char connxKey[] = "connx_status";
+    static const char giKey[] = "gi_status";
+    bool connxFound = false;
+    bool giFound = false;
+    bool statusValid = true;
+    if (!index.forEachMember(southEvent, [&](const char *key, size_t keyLength, bool escaped,
+                                             const StructuralIndex::Value& value) {
+            bool connx = !connxFound && keyEquals(key, keyLength, escaped, connxKey, sizeof(connxKey) - 1, decoded);
+            bool gi = !connx && !giFound && keyEquals(key, keyLength, escaped, giKey, sizeof(giKey) - 1, decoded);
+            if (!connx && !gi) {
+                return true;
+            }
+            (connx ? connxFound : giFound) = true;
+            const char *text;
+            size_t textLength;
+            bool textEscaped;
+            if (index.getString(value, text, textLength, textEscaped)) {
+                if (textEscaped) {
+                    statusValid = StructuralIndex::unescape(text, textLength, decoded);
+                    text = decoded.data();
+                    textLength = decoded.size();
+                }
+                if (connx) {
+                    result.connxStatus = SouthEvent::parseConnxStatus(text, textLength);
+                }
+                else {
+                    result.giStatus = SouthEvent::parseGiStatus(text, textLength);
+                }
+            }
+            return statusValid && !(connxFound && giFound);
+        }) || !statusValid) {
+        result.decision = EvalDecision::ParseError;
+        return result;
+    }
+    decideStatus(result);
+    return result;
+}
+};
+
+EvalResult SouthEventReader::readOnDemand(StructuralIndex& index, const char *data, size_t length,
+                                          const std::vector<std::string>& trackedAssets) {
+    EvalResult result = readIndexed(index, data, length, trackedAssets);
+    if (result.decision != EvalDecision::ParseError) {
+        return result;
+    }
+    // rapidjson reads the reading up to its first null character, the rest is not part of the document.
+    // The index rejects anything after the root value, so only the readings it fails to parse are checked.
+    size_t end = strnlen(data, length);
+    return end < length ? readIndexed(index, data, end, trackedAssets) : result;
+}
+
+/**
+ * Backend of a json_backend configuration value
+ *
+ * @return false if the name is unknown
+ */
+bool SouthEventReader::parseBackend(const std::string& name, JsonBackend& backend) {
+    if (name == "rapidjson") {
+        backend = JsonBackend::RapidJson;
+        return true;
+    }
+    if (name == "ondemand") {
+        backend = JsonBackend::OnDemand;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,634 @@
+/*
+ * Structural index of a JSON document, for on-demand navigation
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SYSTEMSPR_X86 1
+#endif
+
+#include "structuralIndex.h"
+
+using namespace systemspr;
+
+namespace {
+
+const size_t BlockSize = 64;
+
+/*
+ * Characters of a block of 64 bytes, one bit per byte
+ */
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;        // Brackets, colons and commas
+};
+
+BlockMasks classifyScalar(const char *block) {
+    BlockMasks masks = {0, 0, 0};
+    for (size_t i = 0; i < BlockSize; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (block[i]) {
+            case '"':  masks.quote |= bit; break;
+            case '\\': masks.backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                masks.op |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+    return masks;
+}
+
+#if defined(SYSTEMSPR_X86) && defined(__SSE2__)
+BlockMasks classifySse2(const char *block) {
+    BlockMasks masks = {0, 0, 0};
+    for (size_t i = 0; i < BlockSize; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('{')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('}'))),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('[')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(']'))),
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(',')))));
+        masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'))))) << i;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))))) << i;
+        masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << i;
+    }
+    return masks;
+}
+#endif
+
+#if defined(SYSTEMSPR_X86)
+__attribute__((target("avx2")))
+BlockMasks classifyAvx2(const char *block) {
+    BlockMasks masks = {0, 0, 0};
+    for (size_t i = 0; i < BlockSize; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('{')),
+                            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('[')),
+                                _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(']'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')),
+                                _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(',')))));
+        masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'))))) << i;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))))) << i;
+        masks.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << i;
+    }
+    return masks;
+}
+#endif
+
+/*
+ * Bytes escaped by a backslash. A backslash escaped by the previous one does not escape the next byte.
+ *
+ * carry : in, 1 if the first byte of the block is escaped, out, 1 if the first byte of the next block is
+ */
+uint64_t escapedBytes(uint64_t backslash, uint64_t& carry) {
+    uint64_t escaped = carry;
+    carry = 0;
+    while (backslash) {
+        uint32_t bit = static_cast<uint32_t>(__builtin_ctzll(backslash));
+        backslash &= backslash - 1;
+        if (escaped >> bit & 1) {
+            continue;
+        }
+        if (bit == 63) {
+            carry = 1;
+        }
+        else {
+            escaped |= 1ULL << (bit + 1);
+        }
+    }
+    return escaped;
+}
+
+/*
+ * Bit i is the parity of the bits 0 to i: set from an opening quote to the byte before the closing quote
+ */
+uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(const char *p, const char *end, uint32_t& value) {
+    if (end - p < 4) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hexValue(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = value << 4 | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+void appendUtf8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | codePoint >> 6);
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | codePoint >> 12);
+        out += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else {
+        out += static_cast<char>(0xF0 | codePoint >> 18);
+        out += static_cast<char>(0x80 | (codePoint >> 12 & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+};
+
+/**
+ * Fastest kernel supported by the processor
+ */
+StructuralIndex::Kernel StructuralIndex::getBestKernel() {
+    if (isSupported(Kernel::Avx2)) {
+        return Kernel::Avx2;
+    }
+    return isSupported(Kernel::Sse2) ? Kernel::Sse2 : Kernel::Scalar;
+}
+
+bool StructuralIndex::isSupported(Kernel kernel) {
+    switch (kernel) {
+#if defined(SYSTEMSPR_X86)
+        case Kernel::Avx2: {
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            return avx2;
+        }
+#endif
+#if defined(SYSTEMSPR_X86) && defined(__SSE2__)
+        case Kernel::Sse2:
+            return true;
+#endif
+        case Kernel::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char *StructuralIndex::getKernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Avx2: return "avx2";
+        case Kernel::Sse2: return "sse2";
+        default:           return "scalar";
+    }
+}
+
+/**
+ * Select the kernel classifying the blocks
+ *
+ * @return false if the processor does not support it, the current kernel is then kept
+ */
+bool StructuralIndex::setKernel(Kernel kernel) {
+    if (!isSupported(kernel)) {
+        return false;
+    }
+    m_kernel = kernel;
+    return true;
+}
+
+/**
+ * Build the index of a document. The document must outlive the index.
+ *
+ * @param data : JSON document, not necessarily null terminated
+ * @param length : size of the document
+ * @return false if a string is not closed or the brackets are not balanced
+ */
+bool StructuralIndex::build(const char *data, size_t length) {
+    m_data = data;
+    m_length = length;
+    m_positions.clear();
+    if (length >= UINT32_MAX) {
+        return false;
+    }
+    BlockMasks (*classify)(const char *) = classifyScalar;
+#if defined(SYSTEMSPR_X86) && defined(__SSE2__)
+    if (m_kernel == Kernel::Sse2) {
+        classify = classifySse2;
+    }
+#endif
+#if defined(SYSTEMSPR_X86)
+    if (m_kernel == Kernel::Avx2) {
+        classify = classifyAvx2;
+    }
+#endif
+
+    uint64_t escapeCarry = 0;
+    uint64_t inString = 0;
+    char tail[BlockSize];
+    for (size_t offset = 0; offset < length; offset += BlockSize) {
+        const char *block = data + offset;
+        if (length - offset < BlockSize) {
+            memset(tail, ' ', BlockSize);
+            memcpy(tail, block, length - offset);
+            block = tail;
+        }
+        BlockMasks masks = classify(block);
+        uint64_t quote = masks.quote;
+        if (masks.backslash | escapeCarry) {
+            quote &= ~escapedBytes(masks.backslash, escapeCarry);
+        }
+        uint64_t stringBytes = prefixXor(quote) ^ inString;
+        inString = static_cast<uint64_t>(static_cast<int64_t>(stringBytes) >> 63);
+        uint64_t structural = (masks.op & ~stringBytes) | quote;
+        while (structural) {
+            m_positions.push_back(static_cast<uint32_t>(offset) + static_cast<uint32_t>(__builtin_ctzll(structural)));
+            structural &= structural - 1;
+        }
+    }
+    if (inString) {
+        return false;
+    }
+
+    m_match.resize(m_positions.size());
+    m_stack.clear();
+    for (uint32_t i = 0; i < m_positions.size(); i++) {
+        char c = m_char(i);
+        if (c == '{' || c == '[') {
+            m_stack.push_back(i);
+        }
+        else if (c == '}' || c == ']') {
+            if (m_stack.empty() || (m_char(m_stack.back()) == '{') != (c == '}')) {
+                return false;
+            }
+            m_match[m_stack.back()] = i;
+            m_stack.pop_back();
+        }
+    }
+    return m_stack.empty();
+}
+
+/**
+ * Check the syntax of the document built, as a DOM parser would: the grammar of the structural
+ * characters, the scalars between them and the content of every string, read or not.
+ *
+ * @return false at the first syntax error
+ */
+bool StructuralIndex::validate() {
+    enum class Expect : uint8_t { Value, ValueOrClose, Key, KeyOrClose, Colon, CommaOrClose, End };
+
+    Expect expect = Expect::Value;
+    uint32_t gap = 0;
+    m_stack.clear();
+    for (uint32_t i = 0; i < m_positions.size(); i++) {
+        uint32_t position = m_positions[i];
+        const char *begin = m_data + gap;
+        const char *end = m_data + position;
+        const char *p = begin;
+        while (p < end && isWhitespace(*p)) {
+            p++;
+        }
+        if (p < end) {
+            if ((expect != Expect::Value && expect != Expect::ValueOrClose) || !m_validScalar(p, end)) {
+                return false;
+            }
+            expect = m_stack.empty() ? Expect::End : Expect::CommaOrClose;
+        }
+        char c = m_data[position];
+        switch (c) {
+            case '{':
+            case '[':
+                if (expect != Expect::Value && expect != Expect::ValueOrClose) {
+                    return false;
+                }
+                m_stack.push_back(i);
+                expect = c == '{' ? Expect::KeyOrClose : Expect::ValueOrClose;
+                break;
+            case '"': {
+                bool key = expect == Expect::Key || expect == Expect::KeyOrClose;
+                if (!key && expect != Expect::Value && expect != Expect::ValueOrClose) {
+                    return false;
+                }
+                uint32_t close = m_positions[++i];
+                if (!m_validString(m_data + position + 1, close - position - 1)) {
+                    return false;
+                }
+                position = close;
+                expect = key ? Expect::Colon : m_stack.empty() ? Expect::End : Expect::CommaOrClose;
+                break;
+            }
+            case ':':
+                if (expect != Expect::Colon) {
+                    return false;
+                }
+                expect = Expect::Value;
+                break;
+            case ',':
+                if (expect != Expect::CommaOrClose) {
+                    return false;
+                }
+                expect = m_char(m_stack.back()) == '{' ? Expect::Key : Expect::Value;
+                break;
+            default:
+                if (expect != Expect::CommaOrClose && expect != (c == '}' ? Expect::KeyOrClose : Expect::ValueOrClose)) {
+                    return false;
+                }
+                m_stack.pop_back();
+                expect = m_stack.empty() ? Expect::End : Expect::CommaOrClose;
+                break;
+        }
+        gap = position + 1;
+    }
+    const char *p = m_data + gap;
+    const char *end = m_data + m_length;
+    while (p < end && isWhitespace(*p)) {
+        p++;
+    }
+    if (p < end) {
+        return expect == Expect::Value && m_validScalar(p, end);
+    }
+    return expect == Expect::End;
+}
+
+/**
+ * Value starting at a position of the document
+ *
+ * @param index : first structural character at or after the position
+ * @param position : first byte of the value
+ */
+StructuralIndex::Value StructuralIndex::m_valueAt(uint32_t index, uint32_t position) const {
+    Value value;
+    if (position >= m_length) {
+        return value;
+    }
+    char c = m_data[position];
+    bool located = index < m_positions.size() && m_positions[index] == position;
+    switch (c) {
+        case '{':
+        case '[':
+            if (located) {
+                value.type = c == '{' ? Type::Object : Type::Array;
+                value.index = index;
+                value.next = m_match[index] + 1;
+            }
+            break;
+        case '"':
+            if (located) {
+                value.type = Type::String;
+                value.index = index;
+                value.next = index + 2;
+            }
+            break;
+        case '}':
+        case ']':
+        case ':':
+        case ',':
+            break;
+        default:
+            value.type = Type::Scalar;
+            value.index = index;
+            value.next = index;
+            break;
+    }
+    return value;
+}
+
+/**
+ * Value following a colon
+ */
+StructuralIndex::Value StructuralIndex::m_valueAfter(uint32_t index) const {
+    uint32_t position = m_positions[index] + 1;
+    while (position < m_length && isWhitespace(m_data[position])) {
+        position++;
+    }
+    return m_valueAt(index + 1, position);
+}
+
+/**
+ * Root value of the document
+ *
+ * @return Invalid if the document holds something else than a single value
+ */
+StructuralIndex::Value StructuralIndex::getRoot() const {
+    uint32_t position = 0;
+    while (position < m_length && isWhitespace(m_data[position])) {
+        position++;
+    }
+    Value root = m_valueAt(0, position);
+    if (root.type == Type::Scalar) {
+        return m_positions.empty() ? root : Value();
+    }
+    if (root.type == Type::Invalid || root.next != m_positions.size()) {
+        return Value();
+    }
+    for (size_t i = m_positions.back() + 1; i < m_length; i++) {
+        if (!isWhitespace(m_data[i])) {
+            return Value();
+        }
+    }
+    return root;
+}
+
+/**
+ * Raw content of a string value, between the quotes
+ *
+ * @param escaped : set if the content has escape sequences and must be decoded with unescape
+ * @return false if the value is not a string
+ */
+bool StructuralIndex::getString(const Value& value, const char *&begin, size_t& length, bool& escaped) const {
+    if (value.type != Type::String) {
+        return false;
+    }
+    begin = m_data + m_positions[value.index] + 1;
+    length = m_positions[value.index + 1] - m_positions[value.index] - 1;
+    escaped = m_hasEscape(begin, length);
+    return true;
+}
+
+bool StructuralIndex::m_hasEscape(const char *value, size_t length) {
+    return memchr(value, '\\', length) != nullptr;
+}
+
+/**
+ * Content of a string: no control character and valid escape sequences
+ */
+bool StructuralIndex::m_validString(const char *begin, size_t length) {
+    const char *end = begin + length;
+    for (const char *p = begin; p < end; p++) {
+        if (static_cast<unsigned char>(*p) < 0x20) {
+            return false;
+        }
+        if (*p != '\\') {
+            continue;
+        }
+        if (++p == end) {
+            return false;
+        }
+        if (*p == 'u') {
+            uint32_t codePoint;
+            if (!readHex4(p + 1, end, codePoint)) {
+                return false;
+            }
+            p += 4;
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                uint32_t low;
+                if (end - p < 3 || p[1] != '\\' || p[2] != 'u' || !readHex4(p + 3, end, low) ||
+                    low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                p += 6;
+            }
+        }
+        else if (memchr("\"\\/bfnrt", *p, 8) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Scalar between two structural characters: true, false, null or a number, then only whitespace
+ *
+ * @param begin : first byte of the scalar
+ * @param end : next structural character
+ */
+bool StructuralIndex::m_validScalar(const char *begin, const char *end) {
+    const char *p = begin;
+    static const char *const literals[] = {"true", "false", "null"};
+    bool literal = false;
+    for (const char *word : literals) {
+        size_t length = strlen(word);
+        if (static_cast<size_t>(end - p) >= length && memcmp(p, word, length) == 0) {
+            p += length;
+            literal = true;
+            break;
+        }
+    }
+    if (!literal) {
+        if (p < end && *p == '-') {
+            p++;
+        }
+        const char *digits = p;
+        if (p == end || *p < '0' || *p > '9') {
+            return false;
+        }
+        if (*p == '0') {
+            p++;
+        }
+        else {
+            while (p < end && *p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+        // Only a long integer part or an exponent may overflow a double
+        bool large = p - digits > 308;
+        if (p < end && *p == '.') {
+            if (++p == end || *p < '0' || *p > '9') {
+                return false;
+            }
+            while (p < end && *p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            if (++p < end && (*p == '+' || *p == '-')) {
+                p++;
+            }
+            if (p == end || *p < '0' || *p > '9') {
+                return false;
+            }
+            while (p < end && *p >= '0' && *p <= '9') {
+                p++;
+            }
+            large = true;
+        }
+        if (large && std::isinf(strtod(std::string(begin, p).c_str(), nullptr))) {
+            return false;
+        }
+    }
+    while (p < end && isWhitespace(*p)) {
+        p++;
+    }
+    return p == end;
+}
+
+/**
+ * Decode the escape sequences of the content of a string
+ *
+ * @return false if an escape sequence is invalid
+ */
+bool StructuralIndex::unescape(const char *begin, size_t length, std::string& out) {
+    out.clear();
+    const char *end = begin + length;
+    for (const char *p = begin; p < end; p++) {
+        if (*p != '\\') {
+            out += *p;
+            continue;
+        }
+        if (++p == end) {
+            return false;
+        }
+        switch (*p) {
+            case '"':  out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/'; break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                uint32_t codePoint;
+                if (!readHex4(p + 1, end, codePoint)) {
+                    return false;
+                }
+                p += 4;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 3 || p[1] != '\\' || p[2] != 'u' || !readHex4(p + 3, end, low) ||
+                        low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    p += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+/*
+ * Replacement of the global operator new and delete counting the allocations of each thread
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstdlib>
+#include <new>
+
+#include "allocationTracker.h"
+
+namespace {
+// Constant initialized, usable before any dynamic initialization
+thread_local AllocationTracker::Counts counts;
+
+void *allocate(std::size_t size) {
+    counts.allocations++;
+    counts.bytes += size;
+    void *pointer = std::malloc(size ? size : 1);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void release(void *pointer) {
+    if (pointer != nullptr) {
+        counts.deallocations++;
+        std::free(pointer);
+    }
+}
+};
+
+AllocationTracker::Counts AllocationTracker::get() {
+    return counts;
+}
+
+void *operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t&) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t&) noexcept {
+    release(pointer);
+}
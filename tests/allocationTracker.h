@@ -0,0 +1,54 @@
+#ifndef TESTS_ALLOCATION_TRACKER_H_
+#define TESTS_ALLOCATION_TRACKER_H_
+
+/*
+ * Count of the heap allocations of the unit tests
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counters of the global operator new and delete, replaced in the test binary, per thread so
+ * that the threads of the plugin and of gtest do not disturb a measure.
+ *
+ * Only operator new is seen: the memory taken by malloc directly, such as the allocator of
+ * the rapidjson documents, is not counted.
+ */
+namespace AllocationTracker {
+
+struct Counts {
+    uint64_t allocations{0};
+    uint64_t deallocations{0};
+    uint64_t bytes{0};
+};
+
+Counts get();
+
+/**
+ * Allocations of the calling thread since the construction of the scope
+ */
+class Scope {
+public:
+    Scope() : m_start(get()) {}
+
+    Counts delta() const {
+        Counts now = get();
+        Counts delta;
+        delta.allocations = now.allocations - m_start.allocations;
+        delta.deallocations = now.deallocations - m_start.deallocations;
+        delta.bytes = now.bytes - m_start.bytes;
+        return delta;
+    }
+    uint64_t allocations() const { return delta().allocations; }
+
+private:
+    Counts m_start;
+};
+};
+
+#endif  // TESTS_ALLOCATION_TRACKER_H_
@@ -0,0 +1,185 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "allocationTracker.h"
+#include "configPlugin.h"
+#include "ruleClock.h"
+#include "ruleSystemSp.h"
+#include "southEventReader.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    void plugin_reconfigure(PLUGIN_HANDLE *handle, const std::string& newConfig);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+static std::string makeExchangedData(uint32_t count) {
+    std::string json = "{\"exchanged_data\": {\"datapoints\": [";
+    for (uint32_t i = 0; i < count; i++) {
+        char datapoint[256];
+        snprintf(datapoint, sizeof(datapoint),
+                 "%s{\"label\": \"TS-%u\", \"pivot_id\": \"M_2367_3_15_%u\", \"pivot_type\": \"SpsTyp\", "
+                 "\"pivot_subtypes\": [\"prt.inf\"], \"protocols\": [{\"name\": \"IEC104\", "
+                 "\"typeid\": \"M_SP_NA_1\", \"address\": \"%u\"}]}",
+                 i ? ", " : "", i, i, 3271612 + i);
+        json += datapoint;
+    }
+    return json + "]}}";
+}
+
+class TestAllocations : public testing::TestWithParam<const char *>
+{
+protected:
+    RuleSystemSp *filter = nullptr;
+
+    void SetUp() override
+    {
+        PLUGIN_INFORMATION *info = plugin_info();
+        ConfigCategory config("systemsp", info->config);
+        config.setItemsValueFromDefault();
+        config.setValue("json_backend", GetParam());
+        filter = static_cast<RuleSystemSp *>(plugin_init(&config));
+        ASSERT_NE(filter, nullptr);
+    }
+
+    void TearDown() override
+    {
+        plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(filter));
+    }
+
+    uint64_t countEval(const std::string& reading) {
+        AllocationTracker::Scope scope;
+        filter->evalRule(reading);
+        return scope.allocations();
+    }
+
+    /**
+     * Reading never evaluated before, whatever the tests run in the process
+     */
+    static std::string uncached() {
+        static uint64_t sequence = 0;
+        return std::string(QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}, "n": ))
+               + std::to_string(++sequence) + "}";
+    }
+
+    uint64_t countReason() {
+        AllocationTracker::Scope scope;
+        std::string reason = filter->getReason();
+        return scope.allocations();
+    }
+};
+
+INSTANTIATE_TEST_CASE_P(Backends, TestAllocations, testing::Values("rapidjson", "ondemand"));
+
+TEST_P(TestAllocations, SteadyState)
+{
+    std::string lost = QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}});
+    std::string finished = QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "started", "gi_status": "finished"}}});
+    std::string other = QUOTE({"CONNECTION-2": {"south_event": {"connx_status": "not connected"}}});
+    std::string invalid = QUOTE({"CONNECTION-1": {"south_event": 42}});
+
+    // Warm up: buffers, caches, state entries and function statics reach their steady size
+    for (int i = 0; i < 3; i++) {
+        filter->evalRule(lost);
+        filter->getReason();
+        filter->evalRule(finished);
+        filter->getReason();
+        filter->evalRule(other);
+        filter->evalRule(invalid);
+        filter->evalRule(uncached());
+        filter->getTriggers();
+    }
+
+    ASSERT_EQ(countEval(lost), 0);
+    ASSERT_EQ(countEval(finished), 0);
+    ASSERT_EQ(countEval(other), 0);
+    ASSERT_EQ(countEval(invalid), 0);
+
+    // The reason returned is the only allocation
+    filter->evalRule(lost);
+    ASSERT_EQ(countReason(), 1);
+    AllocationTracker::Scope scope;
+    std::string triggers = filter->getTriggers();
+    ASSERT_EQ(scope.allocations(), 1);
+
+    // A reading missing from the evaluation cache allocates no more than its parsing
+    std::vector<std::string> trackedAssets = {"CONNECTION-1", "CONNECTION-2"};
+    for (int i = 0; i < 3; i++) {
+        std::string reading = uncached();
+        uint64_t parsing = 0;
+        if (std::string(GetParam()) == "rapidjson") {
+            AllocationTracker::Scope parsingScope;
+            SouthEventReader::readDom(reading.c_str(), trackedAssets);
+            parsing = parsingScope.allocations();
+        }
+        ASSERT_EQ(countEval(reading), parsing);
+    }
+}
+
+TEST_P(TestAllocations, AggregatedOutage)
+{
+    std::string config = QUOTE({
+        "asset": {"value": ""},
+        "aggregation_window": {"value": "100"},
+        "connections": {"value": {"connections": [
+            {"asset": "LINK-1", "protocol": "IEC104"},
+            {"asset": "LINK-2", "protocol": "IEC104"},
+            {"asset": "LINK-3", "protocol": "IEC104"}
+        ]}}
+    });
+    plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), config);
+    VirtualClock clock;
+    filter->setClock(&clock);
+    std::vector<std::string> lost;
+    std::vector<std::string> finished;
+    for (const char *asset : {"LINK-1", "LINK-2", "LINK-3"}) {
+        lost.push_back(std::string("{\"") + asset + "\": {\"south_event\": {\"connx_status\": \"not connected\"}}}");
+        finished.push_back(std::string("{\"") + asset + "\": {\"south_event\": {\"gi_status\": \"finished\"}}}");
+    }
+
+    // A window closed at its end, then a window closed by the loss of all the assets, both held and sent
+    auto outages = [&]() {
+        uint64_t allocations = countEval(lost[0]) + countEval(lost[1]);
+        clock.advanceMs(200);
+        allocations += countEval(finished[0]) + countEval(finished[2]) + countEval(finished[1]) + countEval(finished[0]);
+        allocations += countEval(lost[0]) + countEval(lost[1]) + countEval(lost[2]);
+        for (const std::string& reading : finished) {
+            allocations += countEval(reading);
+        }
+        return allocations;
+    };
+    outages();
+    outages();
+    ASSERT_EQ(outages(), 0);
+    filter->setClock(nullptr);
+}
+
+TEST(TestAllocationsImport, BytesPerDatapoint)
+{
+    // The import grows linearly with the number of datapoints
+    uint64_t bytesPerDatapoint[2] = {0, 0};
+    for (uint32_t count : {10, 100, 1000, 10000}) {
+        std::string json = makeExchangedData(count);
+        ConfigPlugin configPlugin;
+        AllocationTracker::Scope scope;
+        configPlugin.importExchangedData(json);
+        AllocationTracker::Counts delta = scope.delta();
+        printf("%u datapoints: %lu allocations, %lu bytes\n", count, (unsigned long)delta.allocations,
+               (unsigned long)delta.bytes);
+        ASSERT_EQ(configPlugin.getDatapoints().size(), count);
+        if (count == 100) {
+            bytesPerDatapoint[0] = delta.bytes / count;
+        }
+        if (count == 10000) {
+            bytesPerDatapoint[1] = delta.bytes / count;
+        }
+    }
+    ASSERT_LE(bytesPerDatapoint[1], 2 * bytesPerDatapoint[0]);
+}
@@ -0,0 +1,134 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <config_category.h>
+#include <plugin_api.h>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "captureFile.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    void plugin_reconfigure(PLUGIN_HANDLE *handle, const std::string& newConfig);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+class TestCaptureFile : public testing::Test
+{
+protected:
+    std::string path;
+
+    void SetUp() override
+    {
+        char dir[] = "/tmp/systemspr_captureXXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        path = std::string(dir) + "/capture.jsonl.gz";
+    }
+
+    void TearDown() override
+    {
+        unlink(path.c_str());
+        rmdir(path.substr(0, path.rfind('/')).c_str());
+    }
+};
+
+TEST_F(TestCaptureFile, WriteAndRead)
+{
+    std::vector<std::string> readings = {
+        QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}}),
+        std::string("{\"quote\\\"\": \"tab\t, newline\n, nul") + '\0' + "\"}",
+        "not json",
+    };
+    {
+        CaptureWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        ASSERT_TRUE(writer.isOpen());
+        for (uint64_t i = 0; i < readings.size(); i++) {
+            writer.append(1000 + i, readings[i]);
+        }
+    }
+    // A second opening appends to the file
+    {
+        CaptureWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        writer.append(2000, readings[0]);
+        writer.close();
+        ASSERT_FALSE(writer.isOpen());
+        ASSERT_EQ(writer.getDropped(), 0);
+    }
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureReader::Record record;
+    for (uint64_t i = 0; i < readings.size(); i++) {
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(record.timestampNs, 1000 + i);
+        ASSERT_EQ(record.reading, readings[i]);
+    }
+    ASSERT_TRUE(reader.next(record));
+    ASSERT_EQ(record.timestampNs, 2000);
+    ASSERT_FALSE(reader.next(record));
+    ASSERT_EQ(reader.getLineNumber(), 4);
+}
+
+TEST_F(TestCaptureFile, ReadPlainAndInvalidLines)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    std::string line;
+    CaptureWriter::formatLine(line, 5, "{}");
+    fprintf(file, "{\"ts\": 1}\ngarbage\n%s", line.c_str());
+    fclose(file);
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureReader::Record record;
+    ASSERT_TRUE(reader.next(record));
+    ASSERT_EQ(record.timestampNs, 5);
+    ASSERT_EQ(record.reading, "{}");
+    ASSERT_EQ(reader.getLineNumber(), 3);
+    ASSERT_FALSE(reader.next(record));
+    ASSERT_FALSE(reader.open(path + ".missing"));
+}
+
+TEST_F(TestCaptureFile, CaptureEvaluations)
+{
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    config.setValue("capture_file", path);
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    ASSERT_NE(handle, nullptr);
+
+    // Rejected and unparsable readings are captured too
+    std::vector<std::string> readings = {
+        QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}}),
+        QUOTE({"CONNECTION-2": {"south_event": {"gi_status": "started"}}}),
+        "{42}",
+    };
+    for (const std::string& reading : readings) {
+        plugin_eval(handle, reading);
+    }
+    // Disabling the capture writes the pending readings
+    plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(handle), QUOTE({"capture_file": {"value": ""}}));
+    ASSERT_TRUE(plugin_eval(handle, readings[0]));
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureReader::Record record;
+    uint64_t timestampNs = 0;
+    for (const std::string& reading : readings) {
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(record.reading, reading);
+        ASSERT_GE(record.timestampNs, timestampNs);
+        timestampNs = record.timestampNs;
+    }
+    ASSERT_FALSE(reader.next(record));
+    ASSERT_GT(timestampNs, 0);
+
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+}
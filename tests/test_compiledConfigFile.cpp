@@ -0,0 +1,167 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "compiledConfigFile.h"
+#include "configPlugin.h"
+#include "utilityHash.h"
+
+using namespace systemspr;
+
+static std::string exchangedData = QUOTE({
+    "exchanged_data": {
+        "datapoints" : [
+            {
+                "label":"TS-1",
+                "pivot_id":"ID-1",
+                "pivot_type":"SpsTyp",
+                "pivot_subtypes": ["prt.inf"],
+                "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1001"}]
+            },
+            {
+                "label":"TS-2",
+                "pivot_id":"ID-2",
+                "pivot_type":"DpsTyp",
+                "pivot_subtypes": ["prt.inf"],
+                "protocols":[
+                    {"name":"IEC104", "typeid":"M_DP_NA_1", "address":"2001"},
+                    {"name":"TASE2", "typeid":"Data_State", "address":"site_ts2"}
+                ]
+            },
+            {
+                "label":"TS-3",
+                "pivot_id":"ID-3",
+                "pivot_type":"SpsTyp",
+                "pivot_subtypes": ["acces"]
+            }
+        ]
+    }
+});
+
+class TestCompiledConfigFile : public testing::Test
+{
+protected:
+    std::string dir;
+
+    void SetUp() override
+    {
+        char path[] = "/tmp/systemspr_cacheXXXXXX";
+        ASSERT_NE(mkdtemp(path), nullptr);
+        dir = path;
+    }
+
+    void TearDown() override
+    {
+        DIR *directory = opendir(dir.c_str());
+        while (struct dirent *entry = directory ? readdir(directory) : nullptr) {
+            unlink((dir + "/" + entry->d_name).c_str());
+        }
+        if (directory) {
+            closedir(directory);
+        }
+        rmdir(dir.c_str());
+    }
+
+    void importFromCache(ConfigPlugin& config) {
+        config.setCompiledCacheDir(dir);
+        config.importExchangedData(exchangedData);
+        config.importConnections(QUOTE({"connections": [{"asset": "LINK-1", "protocol": "IEC104"}]}));
+    }
+};
+
+TEST_F(TestCompiledConfigFile, LoadWithoutParsing)
+{
+    // The instance which parsed the exchanged_data is released, otherwise its table is shared
+    ConfigPlugin::Compiled expected;
+    uint64_t fingerprint = 0;
+    std::vector<uint32_t> connectionDatapoints;
+    {
+        ConfigPlugin parsed;
+        importFromCache(parsed);
+        ASSERT_FALSE(parsed.isLoadedFromCache());
+        expected = *parsed.getCompiled();
+        fingerprint = parsed.getFingerprint();
+        connectionDatapoints = parsed.getConnectionDatapoints(*parsed.findConnection("LINK-1"));
+    }
+    std::string path = CompiledConfigFile::getPath(dir, UtilityHash::fnv1a64(exchangedData));
+    ASSERT_EQ(access(path.c_str(), F_OK), 0);
+
+    ConfigPlugin loaded;
+    importFromCache(loaded);
+    ASSERT_TRUE(loaded.isLoadedFromCache());
+    ASSERT_TRUE(loaded.hasConnectionLossTracking());
+    ASSERT_EQ(loaded.getLastDelta().added, 3);
+    ASSERT_EQ(loaded.getFingerprint(), fingerprint);
+    ASSERT_EQ(loaded.getProtocols(), expected.protocols);
+    ASSERT_EQ(loaded.getDatapoints().size(), expected.datapoints.size());
+    for (size_t i = 0; i < expected.datapoints.size(); i++) {
+        ASSERT_EQ(loaded.getDatapoints()[i].pivotId, expected.datapoints[i].pivotId);
+        ASSERT_EQ(loaded.getDatapoints()[i].label, expected.datapoints[i].label);
+        ASSERT_EQ(loaded.getDatapoints()[i].contentHash, expected.datapoints[i].contentHash);
+        ASSERT_EQ(loaded.getDatapoints()[i].prtInf, expected.datapoints[i].prtInf);
+        ASSERT_EQ(loaded.getDatapoints()[i].subtypeMask, expected.datapoints[i].subtypeMask);
+    }
+    ASSERT_EQ(loaded.getSubtypes(), expected.subtypes);
+    ASSERT_EQ(loaded.getCompiled()->subtypeIndex, expected.subtypeIndex);
+    ASSERT_EQ(loaded.getSubtypeDatapoints("acces"), std::vector<uint32_t>({loaded.findDatapoint("ID-3")}));
+    ASSERT_EQ(loaded.getPrtInfIndex().size(), 3);
+    ASSERT_EQ(loaded.getConnectionDatapoints(*loaded.findConnection("LINK-1")), connectionDatapoints);
+
+    // Incremental reconfiguration from the loaded table
+    loaded.importExchangedData(QUOTE({"exchanged_data": {"datapoints": []}}));
+    ASSERT_EQ(loaded.getLastDelta().removed, 3);
+    ASSERT_FALSE(loaded.hasConnectionLossTracking());
+}
+
+TEST_F(TestCompiledConfigFile, RebuildCorruptedFile)
+{
+    {
+        ConfigPlugin parsed;
+        importFromCache(parsed);
+    }
+    std::string path = CompiledConfigFile::getPath(dir, UtilityHash::fnv1a64(exchangedData));
+
+    // A file of another exchanged_data is not loaded
+    ConfigPlugin::Compiled other;
+    ASSERT_FALSE(CompiledConfigFile::read(path, 42, other));
+
+    FILE *file = fopen(path.c_str(), "r+");
+    ASSERT_NE(file, nullptr);
+    fseek(file, -3, SEEK_END);
+    fputc('#', file);
+    fclose(file);
+
+    {
+        ConfigPlugin corrupted;
+        importFromCache(corrupted);
+        ASSERT_FALSE(corrupted.isLoadedFromCache());
+        ASSERT_EQ(corrupted.getDatapointCount(), 3);
+    }
+
+    ConfigPlugin rebuilt;
+    importFromCache(rebuilt);
+    ASSERT_TRUE(rebuilt.isLoadedFromCache());
+
+    ASSERT_EQ(truncate(path.c_str(), 10), 0);
+    ASSERT_FALSE(CompiledConfigFile::read(path, UtilityHash::fnv1a64(exchangedData), other));
+}
+
+TEST_F(TestCompiledConfigFile, PruneOldFiles)
+{
+    for (uint64_t key = 0; key < CompiledConfigFile::MaxFiles + 3; key++) {
+        ConfigPlugin::Compiled compiled;
+        ASSERT_TRUE(CompiledConfigFile::write(CompiledConfigFile::getPath(dir, key), key, compiled));
+    }
+    CompiledConfigFile::prune(dir);
+    size_t count = 0;
+    DIR *directory = opendir(dir.c_str());
+    while (struct dirent *entry = readdir(directory)) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(directory);
+    ASSERT_EQ(count, CompiledConfigFile::MaxFiles);
+}
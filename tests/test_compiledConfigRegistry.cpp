@@ -0,0 +1,76 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+
+#include "compiledConfigRegistry.h"
+#include "configPlugin.h"
+#include "utilityHash.h"
+
+using namespace systemspr;
+
+// Exchanged data unique to each repetition of the tests, so it is never already registered
+static std::string uniqueExchangedData(const std::string& secondLabel) {
+    static int run = 0;
+    run++;
+    return R"({"exchanged_data": {"datapoints": [
+        {"label": "TS-1", "pivot_id": "ID-RUN-)" + std::to_string(run) + R"(", "pivot_type": "SpsTyp",
+         "pivot_subtypes": ["prt.inf"], "protocols": [{"name": "IEC104", "typeid": "M_SP_NA_1", "address": "1001"}]},
+        {"label": ")" + secondLabel + R"(", "pivot_id": "ID-2", "pivot_type": "SpsTyp", "pivot_subtypes": ["acces"]}
+    ]}})";
+}
+
+TEST(TestCompiledConfigRegistry, ShareBetweenInstances)
+{
+    std::string exchangedData = uniqueExchangedData("TS-2");
+    CompiledConfigRegistry& registry = CompiledConfigRegistry::getInstance();
+    uint64_t key = UtilityHash::fnv1a64(exchangedData);
+    ASSERT_EQ(registry.find(key), nullptr);
+
+    ConfigPlugin first;
+    first.importExchangedData(exchangedData);
+    ConfigPlugin second;
+    second.importExchangedData(exchangedData);
+    ASSERT_EQ(first.getCompiled().get(), second.getCompiled().get());
+    ASSERT_EQ(registry.find(key).get(), first.getCompiled().get());
+    ASSERT_EQ(second.getLastDelta().added, 2);
+    ASSERT_TRUE(second.hasConnectionLossTracking());
+    ASSERT_EQ(second.getFingerprint(), first.getFingerprint());
+
+    // Reconfiguring one instance does not modify the table used by the other
+    const ConfigPlugin::Compiled *shared = first.getCompiled().get();
+    second.importExchangedData(uniqueExchangedData("TS-2 modified"));
+    ASSERT_NE(second.getCompiled().get(), shared);
+    ASSERT_EQ(second.getLastDelta().added, 1);
+    ASSERT_EQ(second.getLastDelta().removed, 1);
+    ASSERT_EQ(second.getLastDelta().changed, 1);
+    ASSERT_EQ(first.getCompiled().get(), shared);
+    ASSERT_EQ(first.getDatapointCount(), 2);
+    ASSERT_EQ(first.getDatapoints()[first.findDatapoint("ID-2")].label, "TS-2");
+    ASSERT_EQ(second.getDatapoints()[second.findDatapoint("ID-2")].label, "TS-2 modified");
+
+    // Going back to the shared exchanged_data reuses the registered table
+    second.importExchangedData(exchangedData);
+    ASSERT_EQ(second.getCompiled().get(), shared);
+    ASSERT_EQ(second.getLastDelta().changed, 1);
+}
+
+TEST(TestCompiledConfigRegistry, ReleaseUnused)
+{
+    std::string exchangedData = uniqueExchangedData("TS-2");
+    CompiledConfigRegistry& registry = CompiledConfigRegistry::getInstance();
+    uint64_t key = UtilityHash::fnv1a64(exchangedData);
+    {
+        ConfigPlugin config;
+        config.importExchangedData(exchangedData);
+        ASSERT_NE(registry.find(key), nullptr);
+    }
+    ASSERT_EQ(registry.find(key), nullptr);
+
+    // A table published concurrently for the same key is replaced by the registered one
+    auto first = std::make_shared<ConfigPlugin::Compiled>();
+    first->key = key;
+    auto second = std::make_shared<ConfigPlugin::Compiled>();
+    second->key = key;
+    ASSERT_EQ(registry.publish(first).get(), first.get());
+    ASSERT_EQ(registry.publish(second).get(), first.get());
+}
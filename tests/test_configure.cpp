@@ -444,4 +444,289 @@ TEST_F(TestPluginConfigure, ConfigureOKDps)
 {
 	configPlugin->importExchangedData(configureOKDps);
     ASSERT_TRUE(configPlugin->hasConnectionLossTracking());
-}
\ No newline at end of file
+}
+static std::string configureMultiLink = QUOTE({
+    "exchanged_data": {
+        "datapoints" : [
+            {
+                "label":"TS-1",
+                "pivot_id":"ID-1",
+                "pivot_type":"SpsTyp",
+                "pivot_subtypes": ["prt.inf"],
+                "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1001"}]
+            },
+            {
+                "label":"TS-2",
+                "pivot_id":"ID-2",
+                "pivot_type":"SpsTyp",
+                "pivot_subtypes": ["prt.inf"],
+                "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"2001"}]
+            },
+            {
+                "label":"TS-3",
+                "pivot_id":"ID-3",
+                "pivot_type":"DpsTyp",
+                "pivot_subtypes": ["prt.inf"],
+                "protocols":[
+                    {"name":"IEC104", "typeid":"M_DP_NA_1", "address":"1002"},
+                    {"name":"TASE2", "typeid":"Data_State", "address":"site_ts3"}
+                ]
+            },
+            {
+                "label":"TS-4",
+                "pivot_id":"ID-4",
+                "pivot_type":"SpsTyp",
+                "pivot_subtypes": ["acces"],
+                "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1003"}]
+            }
+        ]
+    }
+});
+
+static std::vector<std::string> connectionPivotIds(const ConfigPlugin& configPlugin, const std::string& asset) {
+    std::vector<std::string> pivotIds;
+    const ConfigPlugin::Connection *connection = configPlugin.findConnection(asset);
+    if (connection) {
+        for (uint32_t datapoint : configPlugin.getConnectionDatapoints(*connection)) {
+            pivotIds.push_back(configPlugin.getDatapoints()[datapoint].pivotId);
+        }
+    }
+    return pivotIds;
+}
+
+TEST_F(TestPluginConfigure, ConfigureConnections)
+{
+    configPlugin->importExchangedData(configureMultiLink);
+    ASSERT_TRUE(configPlugin->hasConnectionLossTracking());
+    ASSERT_EQ(configPlugin->getDatapoints().size(), 4);
+    ASSERT_EQ(configPlugin->getPrtInfIndex().size(), 4);
+
+    configPlugin->importConnections(QUOTE({
+        "connections": [
+            {"asset": "LINK-1", "protocol": "IEC104", "address_ranges": [{"from": 1000, "to": 1999}]},
+            {"asset": "LINK-2", "protocol": "IEC104", "address_ranges": [{"from": 2000, "to": 2999}, {"from": 1002, "to": 1002}]},
+            {"asset": "LINK-3", "protocol": "TASE2"},
+            {"asset": "LINK-4", "protocol": "IEC61850"},
+            {"asset": "LINK-1", "protocol": "IEC104"},
+            {"asset": "LINK-5"}
+        ]
+    }));
+    ASSERT_EQ(configPlugin->getConnections().size(), 4);
+    ASSERT_EQ(connectionPivotIds(*configPlugin, "LINK-1"), std::vector<std::string>({"ID-1", "ID-3"}));
+    ASSERT_EQ(connectionPivotIds(*configPlugin, "LINK-2"), std::vector<std::string>({"ID-2", "ID-3"}));
+    ASSERT_EQ(connectionPivotIds(*configPlugin, "LINK-3"), std::vector<std::string>({"ID-3"}));
+    ASSERT_TRUE(connectionPivotIds(*configPlugin, "LINK-4").empty());
+    ASSERT_EQ(configPlugin->findConnection("LINK-5"), nullptr);
+    ASSERT_EQ(configPlugin->findConnection("LINK-1")->ranges.size(), 1);
+
+    // Tracked asset first, then the connection assets
+    configPlugin->importAsset("LINK-2");
+    ASSERT_EQ(configPlugin->getTrackedAssets(), std::vector<std::string>({"LINK-2", "LINK-1", "LINK-3", "LINK-4"}));
+    uint64_t fingerprint = configPlugin->getFingerprint();
+
+    // Connections are resolved again against a new exchanged_data
+    configPlugin->importExchangedData(configureOKSps);
+    ASSERT_TRUE(connectionPivotIds(*configPlugin, "LINK-1").empty());
+    ASSERT_EQ(configPlugin->getFingerprint(), fingerprint);
+
+    configPlugin->importConnections(QUOTE({"connections": 42}));
+    ASSERT_TRUE(configPlugin->getConnections().empty());
+    ASSERT_EQ(configPlugin->getTrackedAssets(), std::vector<std::string>({"LINK-2"}));
+    ASSERT_NE(configPlugin->getFingerprint(), fingerprint);
+}
+
+TEST_F(TestPluginConfigure, ConfigureIncremental)
+{
+    configPlugin->importExchangedData(configureMultiLink);
+    configPlugin->importConnections(QUOTE({
+        "connections": [{"asset": "LINK-1", "protocol": "IEC104", "address_ranges": [{"from": 1000, "to": 1999}]}]
+    }));
+    ASSERT_EQ(configPlugin->getLastDelta().added, 4);
+    uint32_t id1 = configPlugin->findDatapoint("ID-1");
+    uint32_t id4 = configPlugin->findDatapoint("ID-4");
+    ASSERT_NE(id1, ConfigPlugin::NoDatapoint);
+
+    // Same configuration: nothing to do
+    configPlugin->importExchangedData(configureMultiLink);
+    ASSERT_EQ(configPlugin->getLastDelta().unchanged, 4);
+    ASSERT_EQ(configPlugin->getLastDelta().added + configPlugin->getLastDelta().changed +
+              configPlugin->getLastDelta().removed, 0);
+
+    // ID-1 reordered, ID-2 removed, ID-3 moved to another address, ID-5 added
+    configPlugin->importExchangedData(QUOTE({
+        "exchanged_data": {
+            "datapoints" : [
+                {
+                    "pivot_id":"ID-1",
+                    "label":"TS-1",
+                    "protocols":[{"address":"1001", "typeid":"M_SP_NA_1", "name":"IEC104"}],
+                    "pivot_type":"SpsTyp",
+                    "pivot_subtypes": ["prt.inf"]
+                },
+                {
+                    "label":"TS-3",
+                    "pivot_id":"ID-3",
+                    "pivot_type":"DpsTyp",
+                    "pivot_subtypes": ["prt.inf"],
+                    "protocols":[{"name":"IEC104", "typeid":"M_DP_NA_1", "address":"2002"}]
+                },
+                {
+                    "label":"TS-4",
+                    "pivot_id":"ID-4",
+                    "pivot_type":"SpsTyp",
+                    "pivot_subtypes": ["acces"],
+                    "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1003"}]
+                },
+                {
+                    "label":"TS-5",
+                    "pivot_id":"ID-5",
+                    "pivot_type":"SpsTyp",
+                    "pivot_subtypes": ["prt.inf"],
+                    "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1500"}]
+                },
+                {
+                    "label":"TS-5 again",
+                    "pivot_id":"ID-5",
+                    "pivot_type":"SpsTyp",
+                    "pivot_subtypes": ["prt.inf"],
+                    "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1600"}]
+                }
+            ]
+        }
+    }));
+    const ConfigPlugin::Delta& delta = configPlugin->getLastDelta();
+    ASSERT_EQ(delta.added, 1);
+    ASSERT_EQ(delta.removed, 1);
+    ASSERT_EQ(delta.changed, 1);
+    ASSERT_EQ(delta.unchanged, 2);
+    ASSERT_EQ(configPlugin->getDatapointCount(), 4);
+    ASSERT_EQ(configPlugin->findDatapoint("ID-1"), id1);
+    ASSERT_EQ(configPlugin->findDatapoint("ID-4"), id4);
+    ASSERT_EQ(configPlugin->findDatapoint("ID-2"), ConfigPlugin::NoDatapoint);
+    ASSERT_TRUE(configPlugin->hasConnectionLossTracking());
+
+    // The index and the connections follow the changes
+    ASSERT_EQ(configPlugin->getPrtInfIndex().size(), 3);
+    ASSERT_TRUE(std::is_sorted(configPlugin->getPrtInfIndex().begin(), configPlugin->getPrtInfIndex().end(),
+        [](const ConfigPlugin::ProtocolPoint& a, const ConfigPlugin::ProtocolPoint& b) {
+            return a.protocol != b.protocol ? a.protocol < b.protocol : a.address < b.address;
+        }));
+    ASSERT_EQ(connectionPivotIds(*configPlugin, "LINK-1"), std::vector<std::string>({"ID-1", "ID-5"}));
+
+    // Removing every prt.inf stops the tracking
+    configPlugin->importExchangedData(QUOTE({"exchanged_data": {"datapoints": []}}));
+    ASSERT_EQ(configPlugin->getLastDelta().removed, 4);
+    ASSERT_FALSE(configPlugin->hasConnectionLossTracking());
+    ASSERT_TRUE(configPlugin->getPrtInfIndex().empty());
+}
+
+// Names of the descendants of a tracked asset in the topology
+static std::vector<std::string> descendantNames(const ConfigPlugin& config, const std::string& asset) {
+    std::vector<std::string> names;
+    const std::vector<std::string>& trackedAssets = config.getTrackedAssets();
+    for (uint32_t i = 0; i < trackedAssets.size(); i++) {
+        if (trackedAssets[i] != asset) {
+            continue;
+        }
+        ConfigPlugin::IndexRange range = config.getDescendantRange(i);
+        for (uint32_t j = range.begin; j < range.end; j++) {
+            names.push_back(trackedAssets[config.getDescendants()[j]]);
+        }
+    }
+    return names;
+}
+
+TEST_F(TestPluginConfigure, ConfigureTopology)
+{
+    configPlugin->importExchangedData(configureMultiLink);
+    configPlugin->importAsset("GW-1");
+    configPlugin->importConnections(QUOTE({
+        "connections": [
+            {"asset": "GW-2", "protocol": "IEC104"},
+            {"asset": "LINK-1", "protocol": "IEC104"},
+            {"asset": "LINK-2", "protocol": "IEC104"},
+            {"asset": "LINK-3", "protocol": "TASE2"}
+        ]
+    }));
+    // GW-1 reaches LINK-2 through two paths, UNKNOWN is not tracked
+    configPlugin->importTopology(QUOTE({
+        "topology": [
+            {"parent": "GW-1", "children": ["GW-2", "LINK-1", "UNKNOWN"]},
+            {"parent": "GW-2", "children": ["LINK-2", "LINK-3"]},
+            {"parent": "LINK-1", "children": ["LINK-2"]},
+            {"children": ["LINK-1"]}
+        ]
+    }));
+    ASSERT_EQ(descendantNames(*configPlugin, "GW-1"), std::vector<std::string>({"GW-2", "LINK-1", "LINK-2", "LINK-3"}));
+    ASSERT_EQ(descendantNames(*configPlugin, "GW-2"), std::vector<std::string>({"LINK-2", "LINK-3"}));
+    ASSERT_EQ(descendantNames(*configPlugin, "LINK-1"), std::vector<std::string>({"LINK-2"}));
+    ASSERT_TRUE(descendantNames(*configPlugin, "LINK-3").empty());
+
+    // The topology is compiled again when the tracked assets change
+    configPlugin->importAsset("");
+    ASSERT_TRUE(descendantNames(*configPlugin, "GW-1").empty());
+    ASSERT_EQ(descendantNames(*configPlugin, "GW-2"), std::vector<std::string>({"LINK-2", "LINK-3"}));
+
+    // A cycle drops the whole topology
+    configPlugin->importTopology(QUOTE({
+        "topology": [
+            {"parent": "GW-2", "children": ["LINK-1"]},
+            {"parent": "LINK-1", "children": ["LINK-2"]},
+            {"parent": "LINK-2", "children": ["GW-2"]}
+        ]
+    }));
+    ASSERT_TRUE(configPlugin->getDescendants().empty());
+    ASSERT_TRUE(descendantNames(*configPlugin, "GW-2").empty());
+}
+
+// pivot_ids of the datapoints having a subtype
+static std::vector<std::string> subtypePivotIds(const ConfigPlugin& config, const std::string& subtype) {
+    std::vector<std::string> pivotIds;
+    for (uint32_t id : config.getSubtypeDatapoints(subtype)) {
+        pivotIds.push_back(config.getDatapoints()[id].pivotId);
+    }
+    return pivotIds;
+}
+
+TEST_F(TestPluginConfigure, ConfigureSubtypeIndex)
+{
+    configPlugin->importExchangedData(R"({
+        "exchanged_data": {
+            "datapoints" : [
+                {"label":"TS-1", "pivot_id":"ID-1", "pivot_type":"SpsTyp", "pivot_subtypes": ["prt.inf", "acces"]},
+                {"label":"TS-2", "pivot_id":"ID-2", "pivot_type":"SpsTyp", "pivot_subtypes": ["acces", "acces"]},
+                {"label":"TS-3", "pivot_id":"ID-3", "pivot_type":"DpsTyp", "pivot_subtypes": ["prt.inf", "cycle"]},
+                {"label":"MV-1", "pivot_id":"ID-4", "pivot_type":"MvTyp", "pivot_subtypes": ["other"]}
+            ]
+        }
+    })");
+    ASSERT_EQ(configPlugin->getSubtypes(), std::vector<std::string>({"prt.inf", "acces", "cycle"}));
+    ASSERT_EQ(subtypePivotIds(*configPlugin, "prt.inf"), std::vector<std::string>({"ID-1", "ID-3"}));
+    ASSERT_EQ(subtypePivotIds(*configPlugin, "acces"), std::vector<std::string>({"ID-1", "ID-2"}));
+    ASSERT_EQ(subtypePivotIds(*configPlugin, "cycle"), std::vector<std::string>({"ID-3"}));
+    ASSERT_TRUE(configPlugin->getSubtypeDatapoints("other").empty());
+    ASSERT_EQ(configPlugin->findSubtype("other"), ConfigPlugin::NoSubtype);
+
+    uint32_t acces = configPlugin->findSubtype("acces");
+    ASSERT_TRUE(configPlugin->hasSubtype(configPlugin->findDatapoint("ID-2"), acces));
+    ASSERT_FALSE(configPlugin->hasSubtype(configPlugin->findDatapoint("ID-3"), acces));
+    ASSERT_TRUE(configPlugin->getDatapoints()[configPlugin->findDatapoint("ID-1")].prtInf);
+    ASSERT_FALSE(configPlugin->getDatapoints()[configPlugin->findDatapoint("ID-2")].prtInf);
+
+    // ID-1 loses acces, ID-2 is removed and ID-5 takes its slot
+    configPlugin->importExchangedData(R"({
+        "exchanged_data": {
+            "datapoints" : [
+                {"label":"TS-1", "pivot_id":"ID-1", "pivot_type":"SpsTyp", "pivot_subtypes": ["prt.inf"]},
+                {"label":"TS-3", "pivot_id":"ID-3", "pivot_type":"DpsTyp", "pivot_subtypes": ["prt.inf", "cycle"]},
+                {"label":"TS-5", "pivot_id":"ID-5", "pivot_type":"SpsTyp", "pivot_subtypes": ["cycle", "acces"]}
+            ]
+        }
+    })");
+    ASSERT_EQ(configPlugin->getLastDelta().unchanged, 1);
+    ASSERT_EQ(subtypePivotIds(*configPlugin, "prt.inf"), std::vector<std::string>({"ID-1", "ID-3"}));
+    ASSERT_EQ(subtypePivotIds(*configPlugin, "acces"), std::vector<std::string>({"ID-5"}));
+    const std::vector<uint32_t>& cycle = configPlugin->getSubtypeDatapoints("cycle");
+    ASSERT_EQ(cycle.size(), 2);
+    ASSERT_TRUE(std::is_sorted(cycle.begin(), cycle.end()));
+}
@@ -0,0 +1,223 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "connectionStateStore.h"
+#include "ruleClock.h"
+#include "ruleSystemSp.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    void plugin_reconfigure(PLUGIN_HANDLE *handle, const std::string& newConfig);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+class TestConnectionStateStore : public testing::Test
+{
+protected:
+    std::string path;
+
+    void SetUp() override
+    {
+        char dir[] = "/tmp/systemspr_stateXXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        path = std::string(dir) + "/connection_state.bin";
+    }
+
+    void TearDown() override
+    {
+        unlink(path.c_str());
+        rmdir(path.substr(0, path.rfind('/')).c_str());
+    }
+};
+
+TEST_F(TestConnectionStateStore, PersistAcrossReopen)
+{
+    {
+        ConnectionStateStore store;
+        ASSERT_TRUE(store.open(path));
+        ConnectionStateStore::Entry *entry = store.acquire("CONNECTION-1");
+        ASSERT_NE(entry, nullptr);
+        ASSERT_EQ(entry->getLinkState(), LinkState::Unknown);
+
+        ASSERT_EQ(store.update(entry, ConnxStatus::NotConnected, GiStatus::None, 42), LinkState::Unknown);
+        ASSERT_EQ(entry->getLinkState(), LinkState::NotConnected);
+        ASSERT_EQ(store.acquire("CONNECTION-1"), entry);
+        ASSERT_NE(store.acquire("CONNECTION-2"), nullptr);
+        ASSERT_EQ(store.size(), 2);
+    }
+
+    ConnectionStateStore store;
+    ASSERT_TRUE(store.open(path));
+    ASSERT_EQ(store.size(), 2);
+    const ConnectionStateStore::Entry *entry = store.find("CONNECTION-1");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->getLinkState(), LinkState::NotConnected);
+    ASSERT_EQ(entry->lossCount.load(), 1);
+    ASSERT_EQ(entry->updatedNs.load(), 42);
+    ASSERT_EQ(static_cast<ConnxStatus>(entry->connxStatus.load()), ConnxStatus::NotConnected);
+    ASSERT_EQ(store.find("CONNECTION-3"), nullptr);
+}
+
+TEST_F(TestConnectionStateStore, LinkStateTransitions)
+{
+    ConnectionStateStore store;
+    ASSERT_TRUE(store.open(path));
+    ConnectionStateStore::Entry *entry = store.acquire("CONNECTION-1");
+    ASSERT_NE(entry, nullptr);
+
+    // GI completed: link recovered
+    store.update(entry, ConnxStatus::None, GiStatus::Finished, 1);
+    ASSERT_EQ(entry->getLinkState(), LinkState::Connected);
+
+    // Irrelevant statuses do not change the link state
+    store.update(entry, ConnxStatus::Started, GiStatus::InProgress, 2);
+    ASSERT_EQ(entry->getLinkState(), LinkState::Connected);
+    ASSERT_EQ(entry->updatedNs.load(), 1);
+
+    // Connection loss has priority over GI completed
+    ASSERT_EQ(store.update(entry, ConnxStatus::NotConnected, GiStatus::Finished, 3), LinkState::Connected);
+    ASSERT_EQ(entry->getLinkState(), LinkState::NotConnected);
+    ASSERT_EQ(entry->lossCount.load(), 1);
+
+    // The loss stays notified until the link state changes
+    ASSERT_FALSE(entry->isLossNotified());
+    store.setLossNotified(entry);
+    store.update(entry, ConnxStatus::NotConnected, GiStatus::None, 4);
+    ASSERT_TRUE(entry->isLossNotified());
+    store.update(entry, ConnxStatus::None, GiStatus::Finished, 5);
+    ASSERT_FALSE(entry->isLossNotified());
+}
+
+TEST_F(TestConnectionStateStore, ResetOnUnknownLayout)
+{
+    {
+        ConnectionStateStore store;
+        ASSERT_TRUE(store.open(path));
+        store.update(store.acquire("CONNECTION-1"), ConnxStatus::NotConnected, GiStatus::None, 1);
+    }
+
+    // Corrupt the magic number
+    FILE *file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    uint32_t badMagic = 0;
+    fwrite(&badMagic, sizeof(badMagic), 1, file);
+    fclose(file);
+
+    ConnectionStateStore store;
+    ASSERT_TRUE(store.open(path));
+    ASSERT_EQ(store.size(), 0);
+    ASSERT_EQ(store.find("CONNECTION-1"), nullptr);
+}
+
+TEST_F(TestConnectionStateStore, ClosedStore)
+{
+    ConnectionStateStore store;
+    ASSERT_FALSE(store.isOpen());
+    ASSERT_EQ(store.acquire("CONNECTION-1"), nullptr);
+    ASSERT_EQ(store.find("CONNECTION-1"), nullptr);
+    ASSERT_FALSE(store.open("/nonexistent/dir/connection_state.bin"));
+}
+
+TEST_F(TestConnectionStateStore, ConcurrentUpdates)
+{
+    ConnectionStateStore store;
+    ASSERT_TRUE(store.open(path));
+    ConnectionStateStore::Entry *entry = store.acquire("CONNECTION-1");
+    ASSERT_NE(entry, nullptr);
+
+    // Each loss counted must be a transition seen by exactly one update
+    std::atomic<uint32_t> transitions{0};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4; t++) {
+        threads.emplace_back([&store, entry, &transitions, t]() {
+            for (uint32_t i = 0; i < 20000; i++) {
+                if ((i + t) % 2 == 0) {
+                    if (store.update(entry, ConnxStatus::NotConnected, GiStatus::None, i) != LinkState::NotConnected) {
+                        transitions++;
+                    }
+                }
+                else {
+                    store.update(entry, ConnxStatus::None, GiStatus::Finished, i);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ASSERT_GT(transitions.load(), 0);
+    ASSERT_EQ(entry->lossCount.load(), transitions.load());
+}
+
+class TestConnectionStateRestart : public TestConnectionStateStore
+{
+protected:
+    void TearDown() override
+    {
+        // The store shared by the instances is left closed for the next tests
+        ConnectionStateStore::getInstance().close();
+        TestConnectionStateStore::TearDown();
+    }
+};
+
+TEST_F(TestConnectionStateRestart, RestartOverExistingState)
+{
+    // State left by the previous run: the loss of CONNECTION-1 is notified, the one of CONNECTION-2 is held
+    ConnectionStateStore& store = ConnectionStateStore::getInstance();
+    store.close();
+    ASSERT_TRUE(store.open(path));
+    ConnectionStateStore::Entry *entry1 = store.acquire("CONNECTION-1");
+    ConnectionStateStore::Entry *entry2 = store.acquire("CONNECTION-2");
+    ASSERT_NE(entry1, nullptr);
+    ASSERT_NE(entry2, nullptr);
+    store.update(entry1, ConnxStatus::NotConnected, GiStatus::None, 1);
+    store.setLossNotified(entry1);
+    store.update(entry2, ConnxStatus::NotConnected, GiStatus::None, 2);
+    store.close();
+    ASSERT_TRUE(store.open(path));
+    entry1 = store.acquire("CONNECTION-1");
+    entry2 = store.acquire("CONNECTION-2");
+
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    config.setValue("aggregation_window", "60000");
+    config.setValue("connections", QUOTE({"connections": [{"asset": "CONNECTION-2", "protocol": "IEC104"}]}));
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    ASSERT_NE(handle, nullptr);
+    RuleSystemSp *rule = static_cast<RuleSystemSp *>(handle);
+    ASSERT_EQ(rule->getLinkState("CONNECTION-1"), LinkState::NotConnected);
+    VirtualClock clock;
+    rule->setClock(&clock);
+
+    // The loss reported again by the restarted south service is not notified twice
+    std::string assetConnectionLoss1 = QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}});
+    std::string assetGIStarted1 = QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "started"}}});
+    std::string assetGIFinished1 = QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "finished"}}});
+    ASSERT_FALSE(plugin_eval(handle, assetConnectionLoss1));
+
+    // The loss held at shutdown is notified at the end of a new window
+    ASSERT_FALSE(entry2->isLossNotified());
+    clock.advanceMs(60000);
+    ASSERT_TRUE(plugin_eval(handle, assetGIStarted1));
+    ASSERT_THAT(rule->getReason(), testing::HasSubstr("CONNECTION-2"));
+    ASSERT_TRUE(entry2->isLossNotified());
+
+    // The recovery of the loss notified before the restart is notified
+    ASSERT_TRUE(plugin_eval(handle, assetGIFinished1));
+    ASSERT_EQ(rule->getLinkState("CONNECTION-1"), LinkState::Connected);
+
+    rule->setClock(nullptr);
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+}
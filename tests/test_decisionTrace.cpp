@@ -0,0 +1,166 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "decisionTrace.h"
+#include "ruleSystemSp.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+// Decisions recorded by the calling thread with a timestamp in [since, until)
+static std::vector<DecisionTrace::Event> threadEvents(uint64_t since, uint64_t until) {
+    uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    std::vector<DecisionTrace::Event> events;
+    for (const DecisionTrace::Event& event : DecisionTrace::snapshot()) {
+        if (event.threadId == tid && event.timestampNs >= since && event.timestampNs < until) {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+TEST(TestDecisionTrace, RecordAndSnapshot)
+{
+    // Timestamps unique to each repetition of the test
+    static uint64_t since = 1ULL << 62;
+    since += 100;
+    DecisionTrace::record(EvalDecision::WrongAsset, 10, since + 1);
+    DecisionTrace::record(EvalDecision::FiredGiFinished, 20, since + 2);
+
+    std::vector<DecisionTrace::Event> events = threadEvents(since, since + 100);
+    ASSERT_EQ(events.size(), 2);
+    ASSERT_EQ(events[0].decision, EvalDecision::WrongAsset);
+    ASSERT_EQ(events[0].payloadSize, 10);
+    ASSERT_EQ(events[1].decision, EvalDecision::FiredGiFinished);
+    ASSERT_EQ(events[1].payloadSize, 20);
+}
+
+TEST(TestDecisionTrace, RingKeepsLastDecisions)
+{
+    static uint64_t since = 1ULL << 61;
+    since += 10 * DecisionTrace::RingSize;
+    std::thread writer([]() {
+        for (uint32_t i = 0; i < DecisionTrace::RingSize + 10; i++) {
+            DecisionTrace::record(EvalDecision::NoStatusMatch, i, since + i);
+        }
+    });
+    writer.join();
+
+    // The ring of the exited thread is kept and only holds the last RingSize decisions
+    size_t count = 0;
+    uint32_t minPayload = UINT32_MAX;
+    for (const DecisionTrace::Event& event : DecisionTrace::snapshot()) {
+        if (event.timestampNs >= since && event.timestampNs < since + DecisionTrace::RingSize + 10) {
+            count++;
+            minPayload = std::min(minPayload, event.payloadSize);
+        }
+    }
+    ASSERT_EQ(count, DecisionTrace::RingSize);
+    ASSERT_EQ(minPayload, 10);
+}
+
+TEST(TestDecisionTrace, DumpOnSignal)
+{
+    char dataDir[] = "/tmp/systemspr_dataXXXXXX";
+    ASSERT_NE(mkdtemp(dataDir), nullptr);
+    setenv("FLEDGE_DATA", dataDir, 1);
+    std::string dumpPath = DecisionTrace::getDefaultDumpPath();
+    DecisionTrace::record(EvalDecision::WrongAsset, 7, 1ULL << 59);
+
+    struct sigaction previous = {};
+    previous.sa_handler = SIG_IGN;
+    sigemptyset(&previous.sa_mask);
+    ASSERT_EQ(sigaction(SIGUSR2, &previous, nullptr), 0);
+    {
+        DecisionTrace::SignalDump dump;
+        DecisionTrace::SignalDump other;
+        ASSERT_TRUE(dump.set(SIGUSR2));
+        // A single signal per process
+        ASSERT_FALSE(other.set(SIGUSR1));
+        ASSERT_EQ(other.getSignal(), 0);
+        ASSERT_TRUE(other.set(SIGUSR2));
+
+        // Written by the dump thread
+        raise(SIGUSR2);
+        for (int i = 0; i < 1000 && access(dumpPath.c_str(), F_OK) != 0; i++) {
+            usleep(1000);
+        }
+        ASSERT_EQ(access(dumpPath.c_str(), F_OK), 0);
+        ASSERT_TRUE(dump.set(0));
+    }
+    // The previous action is restored with the last subscription
+    struct sigaction current = {};
+    ASSERT_EQ(sigaction(SIGUSR2, nullptr, &current), 0);
+    ASSERT_EQ(current.sa_handler, SIG_IGN);
+    signal(SIGUSR2, SIG_DFL);
+    unsetenv("FLEDGE_DATA");
+    std::ifstream dump(dumpPath);
+    std::string dumped((std::istreambuf_iterator<char>(dump)), std::istreambuf_iterator<char>());
+    unlink(dumpPath.c_str());
+    rmdir(dumpPath.substr(0, dumpPath.rfind('/')).c_str());
+    rmdir(dataDir);
+    ASSERT_NE(dumped.find("\twrong_asset\t7\n"), std::string::npos);
+
+    char path[] = "/tmp/systemspr_traceXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    DecisionTrace::record(EvalDecision::ParseError, 5, 1ULL << 60);
+    ASSERT_TRUE(DecisionTrace::dumpToFile(path));
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    unlink(path);
+    ASSERT_NE(content.find("\tparse_error\t5\n"), std::string::npos);
+    ASSERT_NE(content.find("# parse_error: "), std::string::npos);
+    ASSERT_FALSE(DecisionTrace::dumpToFile("/nonexistent/dir/trace.log"));
+}
+
+TEST(TestDecisionTrace, EvalDecisions)
+{
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    ASSERT_NE(handle, nullptr);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    uint64_t since = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+
+    std::vector<std::pair<std::string, EvalDecision>> cases = {
+        {QUOTE({42}), EvalDecision::ParseError},
+        {QUOTE([42]), EvalDecision::NotAnObject},
+        {QUOTE({"something": "something"}), EvalDecision::WrongAsset},
+        {QUOTE({"CONNECTION-1": 42}), EvalDecision::ReadingNotAnObject},
+        {QUOTE({"CONNECTION-1": {"something": "something"}}), EvalDecision::NoSouthEvent},
+        {QUOTE({"CONNECTION-1": {"south_event": 42}}), EvalDecision::SouthEventNotAnObject},
+        {QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "failed"}}}), EvalDecision::NoStatusMatch},
+        {QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}}), EvalDecision::FiredConnectionLost},
+        {QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "finished"}}}), EvalDecision::FiredGiFinished},
+    };
+    for (const auto& testCase : cases) {
+        plugin_eval(handle, testCase.first);
+    }
+
+    std::vector<DecisionTrace::Event> events = threadEvents(since, since + 3600000000000ULL);
+    ASSERT_GE(events.size(), cases.size());
+    events.erase(events.begin(), events.end() - cases.size());
+    for (size_t i = 0; i < cases.size(); i++) {
+        ASSERT_EQ(events[i].decision, cases[i].second) << "Unexpected decision for " << cases[i].first;
+        ASSERT_EQ(events[i].payloadSize, cases[i].first.size());
+    }
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+}
@@ -0,0 +1,89 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+
+#include "evaluationCache.h"
+#include "ruleSystemSp.h"
+#include "utilityHash.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    std::string plugin_reason(PLUGIN_HANDLE handle);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+TEST(TestEvaluationCache, LookupAndStore)
+{
+    EvaluationCache cache;
+    EvalResult result;
+    ASSERT_FALSE(cache.lookup(1, 10, 100, result));
+
+    EvalResult stored;
+    stored.decision = EvalDecision::FiredConnectionLost;
+    stored.connxStatus = ConnxStatus::NotConnected;
+    cache.store(1, 10, 100, stored);
+    ASSERT_TRUE(cache.lookup(1, 10, 100, result));
+    ASSERT_EQ(result.decision, EvalDecision::FiredConnectionLost);
+    ASSERT_EQ(result.connxStatus, ConnxStatus::NotConnected);
+
+    // Another size or configuration is another evaluation
+    ASSERT_FALSE(cache.lookup(1, 11, 100, result));
+    ASSERT_FALSE(cache.lookup(1, 10, 101, result));
+    ASSERT_EQ(cache.getHits(), 1);
+    ASSERT_EQ(cache.getMisses(), 3);
+
+    cache.clear();
+    ASSERT_FALSE(cache.lookup(1, 10, 100, result));
+}
+
+TEST(TestEvaluationCache, PayloadHash)
+{
+    // Reference values of XXH64 with seed 0, through the tail and the 32 bytes stripes
+    ASSERT_EQ(UtilityHash::xxh64(""), 0xEF46DB3751D8E999ULL);
+    ASSERT_EQ(UtilityHash::xxh64("abc"), 0x44BC2CF5AD770999ULL);
+    ASSERT_EQ(UtilityHash::xxh64("Nobody inspects the spammish repetition"), 0xFBCEA83C8A378BF1ULL);
+}
+
+TEST(TestEvaluationCache, SharedBetweenInstances)
+{
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    PLUGIN_HANDLE first = plugin_init(&config);
+    PLUGIN_HANDLE second = plugin_init(&config);
+    config.setValue("eval_cache", "false");
+    PLUGIN_HANDLE uncached = plugin_init(&config);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    ASSERT_NE(uncached, nullptr);
+
+    // Reading unique to each repetition of the test
+    static int repetition = 0;
+    std::string reading = std::string(QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}, "repetition":)) +
+                          std::to_string(++repetition) + "}}";
+
+    ASSERT_TRUE(plugin_eval(first, reading));
+    ASSERT_TRUE(plugin_eval(second, reading));
+    ASSERT_TRUE(plugin_eval(uncached, reading));
+    ASSERT_EQ(plugin_reason(second), plugin_reason(first));
+
+    ASSERT_EQ(static_cast<RuleSystemSp *>(first)->getMetrics().getCacheHits(), 0);
+    ASSERT_EQ(static_cast<RuleSystemSp *>(second)->getMetrics().getCacheHits(), 1);
+    ASSERT_EQ(static_cast<RuleSystemSp *>(uncached)->getMetrics().getCacheHits(), 0);
+
+    // The configuration is part of the key
+    config.setValue("eval_cache", "true");
+    config.setValue("asset", "CONNECTION-2");
+    PLUGIN_HANDLE other = plugin_init(&config);
+    ASSERT_FALSE(plugin_eval(other, reading));
+    ASSERT_EQ(static_cast<RuleSystemSp *>(other)->getMetrics().getCacheHits(), 0);
+
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(first));
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(second));
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(uncached));
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(other));
+}
@@ -0,0 +1,162 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+#include "exchangedDataWatcher.h"
+#include "ruleSystemSp.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+static const char *withoutPrtInf = QUOTE({"exchanged_data": {"datapoints": [
+    {"label": "TS-1", "pivot_id": "ID-1", "pivot_type": "SpsTyp", "pivot_subtypes": ["acces"]}
+]}});
+
+static const char *withPrtInf = QUOTE({"exchanged_data": {"datapoints": [
+    {"label": "TS-1", "pivot_id": "ID-1", "pivot_type": "SpsTyp", "pivot_subtypes": ["prt.inf"]}
+]}});
+
+// Replace the content of a file the way an editor does, through a rename
+static void replaceFile(const std::string& path, const std::string& content) {
+    std::string temporaryPath = path + ".tmp";
+    FILE *file = fopen(temporaryPath.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    fputs(content.c_str(), file);
+    fclose(file);
+    ASSERT_EQ(rename(temporaryPath.c_str(), path.c_str()), 0);
+}
+
+template <typename Predicate>
+static bool waitFor(Predicate predicate) {
+    for (int i = 0; i < 500 && !predicate(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return predicate();
+}
+
+class TestExchangedDataWatcher : public testing::Test
+{
+protected:
+    std::string dir;
+    std::string path;
+
+    void SetUp() override
+    {
+        char name[] = "/tmp/systemspr_watchXXXXXX";
+        ASSERT_NE(mkdtemp(name), nullptr);
+        dir = name;
+        path = dir + "/exchanged_data.json";
+    }
+
+    void TearDown() override
+    {
+        unlink(path.c_str());
+        unlink((dir + "/other.json").c_str());
+        rmdir(dir.c_str());
+    }
+};
+
+TEST_F(TestExchangedDataWatcher, Debounce)
+{
+    std::atomic<int> changes{0};
+    ExchangedDataWatcher watcher;
+    ASSERT_FALSE(watcher.start("/nonexistent/dir/file.json", 10, []() {}));
+    ASSERT_TRUE(watcher.start(path, 100, [&changes]() { changes++; }));
+    ASSERT_TRUE(watcher.isRunning());
+
+    // Several writes within the debounce delay are reported once
+    for (int i = 0; i < 5; i++) {
+        FILE *file = fopen(path.c_str(), "a");
+        ASSERT_NE(file, nullptr);
+        fputs("{}", file);
+        fclose(file);
+    }
+    ASSERT_TRUE(waitFor([&changes]() { return changes.load() > 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(changes.load(), 1);
+
+    // Other files of the directory are ignored
+    replaceFile(dir + "/other.json", "{}");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(changes.load(), 1);
+
+    replaceFile(path, "{}");
+    ASSERT_TRUE(waitFor([&changes]() { return changes.load() == 2; }));
+    watcher.stop();
+    ASSERT_FALSE(watcher.isRunning());
+}
+
+TEST_F(TestExchangedDataWatcher, RuleReload)
+{
+    replaceFile(path, withoutPrtInf);
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    config.setValue("exchanged_data_file", path);
+    config.setValue("config_cache", "false");
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    ASSERT_NE(handle, nullptr);
+
+    // The exchanged_data of the file replaces the one of the configuration category
+    std::string lost = QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}});
+    ASSERT_FALSE(plugin_eval(handle, lost));
+
+    replaceFile(path, withPrtInf);
+    ASSERT_TRUE(waitFor([handle, &lost]() { return plugin_eval(handle, lost); }));
+    RuleSystemSp *rule = static_cast<RuleSystemSp *>(handle);
+    ASSERT_GE(rule->getMetrics().reconfigureStall().count(), 2);
+
+    // An unreadable file keeps the current exchanged_data
+    unlink(path.c_str());
+    replaceFile(path, "");
+    std::this_thread::sleep_for(std::chrono::milliseconds(ExchangedDataWatcher::DefaultDebounceMs + 200));
+    ASSERT_TRUE(plugin_eval(handle, lost));
+
+    // So do a malformed file and a file written halfway
+    replaceFile(path, QUOTE({"exchanged_data": {"datapoints": {}}}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(ExchangedDataWatcher::DefaultDebounceMs + 200));
+    ASSERT_TRUE(plugin_eval(handle, lost));
+    replaceFile(path, "{\"exchanged_data\": {\"datapoints\": [");
+    std::this_thread::sleep_for(std::chrono::milliseconds(ExchangedDataWatcher::DefaultDebounceMs + 200));
+    ASSERT_TRUE(plugin_eval(handle, lost));
+
+    // The watcher still reloads the next valid file
+    replaceFile(path, withoutPrtInf);
+    ASSERT_TRUE(waitFor([handle, &lost]() { return !plugin_eval(handle, lost); }));
+
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+}
+
+TEST_F(TestExchangedDataWatcher, InvalidFile)
+{
+    ConfigPlugin configPlugin;
+    replaceFile(path, withPrtInf);
+    ASSERT_TRUE(configPlugin.importExchangedDataFile(path));
+    ASSERT_TRUE(configPlugin.hasConnectionLossTracking());
+
+    for (const char *content : {"{\"exchanged_data\": {\"datapoints\": [", "{\"exchanged_data\": {\"datapoints\": [{\"label\"",
+                                "{]", "[]", "{}", QUOTE({"exchanged_data": []}), QUOTE({"exchanged_data": {}}),
+                                QUOTE({"exchanged_data": {"datapoints": 1}})}) {
+        replaceFile(path, content);
+        ASSERT_FALSE(configPlugin.importExchangedDataFile(path)) << content;
+        ASSERT_TRUE(configPlugin.hasConnectionLossTracking()) << content;
+        ASSERT_EQ(configPlugin.getDatapoints().size(), 1) << content;
+        ASSERT_EQ(configPlugin.getLastDelta().removed, 0) << content;
+    }
+
+    // The exchanged_data of the configuration category is still cleared when it is not valid
+    ASSERT_FALSE(configPlugin.importExchangedData("{\"exchanged_data\": {\"datapoints\": ["));
+    ASSERT_FALSE(configPlugin.hasConnectionLossTracking());
+}
@@ -0,0 +1,244 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "connectionStateStore.h"
+#include "constantsSystem.h"
+#include "notificationJournal.h"
+#include "ruleClock.h"
+#include "ruleSystemSp.h"
+#include "utilityHash.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    void plugin_reconfigure(PLUGIN_HANDLE *handle, const std::string& newConfig);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+class TestNotificationJournal : public testing::Test
+{
+protected:
+    std::string path;
+
+    void SetUp() override
+    {
+        char dir[] = "/tmp/systemspr_journalXXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        path = std::string(dir) + "/journal.bin";
+    }
+
+    void TearDown() override
+    {
+        unlink(path.c_str());
+        rmdir(path.substr(0, path.rfind('/')).c_str());
+    }
+};
+
+TEST_F(TestNotificationJournal, AppendAndRead)
+{
+    NotificationJournal journal;
+    ASSERT_TRUE(journal.open(path, 4));
+    uint32_t asset1 = journal.registerAsset("CONNECTION-1");
+    uint32_t asset2 = journal.registerAsset("CONNECTION-2");
+    ASSERT_EQ(asset1, 0);
+    ASSERT_EQ(asset2, 1);
+    ASSERT_EQ(journal.registerAsset("CONNECTION-1"), asset1);
+
+    journal.append(asset1, true, ConnxStatus::NotConnected, GiStatus::None, 0x1234, 100, 10);
+    journal.append(asset2, false, ConnxStatus::Started, GiStatus::InProgress, 0x5678, 200, 20);
+
+    NotificationJournal::Event event;
+    ASSERT_TRUE(journal.readEvent(0, event));
+    ASSERT_EQ(event.assetId, asset1);
+    ASSERT_TRUE(event.verdict);
+    ASSERT_EQ(event.connxStatus, ConnxStatus::NotConnected);
+    ASSERT_EQ(event.giStatus, GiStatus::None);
+    ASSERT_EQ(event.payloadHash, 0x1234);
+    ASSERT_EQ(event.payloadSize, 100);
+    ASSERT_EQ(event.timestampNs, 10);
+
+    ASSERT_TRUE(journal.readEvent(1, event));
+    ASSERT_EQ(event.assetId, asset2);
+    ASSERT_FALSE(event.verdict);
+    ASSERT_EQ(event.giStatus, GiStatus::InProgress);
+    ASSERT_FALSE(journal.readEvent(2, event));
+}
+
+TEST_F(TestNotificationJournal, RingWrapAndReopen)
+{
+    {
+        NotificationJournal journal;
+        ASSERT_TRUE(journal.open(path, 4));
+        uint32_t asset = journal.registerAsset("CONNECTION-1");
+        for (uint64_t i = 0; i < 6; i++) {
+            journal.append(asset, false, ConnxStatus::None, GiStatus::Finished, i, 0, i);
+        }
+        NotificationJournal::Event event;
+        ASSERT_FALSE(journal.readEvent(1, event));
+        ASSERT_TRUE(journal.readEvent(5, event));
+        ASSERT_EQ(event.payloadHash, 5);
+    }
+
+    // Records of the previous run are kept
+    NotificationJournal reader;
+    ASSERT_TRUE(reader.open(path, 0, true));
+    ASSERT_EQ(reader.getHeader()->writeIndex.load(), 6);
+    ASSERT_EQ(reader.getHeader()->assetCount, 1);
+    ASSERT_STREQ(reader.getAssets()[0].name, "CONNECTION-1");
+    NotificationJournal::Event event;
+    ASSERT_TRUE(reader.readEvent(2, event));
+    ASSERT_EQ(event.payloadHash, 2);
+    reader.close();
+
+    // A different capacity resets the journal
+    NotificationJournal journal;
+    ASSERT_TRUE(journal.open(path, 8));
+    ASSERT_EQ(journal.getHeader()->writeIndex.load(), 0);
+    ASSERT_EQ(journal.getHeader()->assetCount, 0);
+}
+
+TEST_F(TestNotificationJournal, ReadOnlyInvalidFile)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fputs("not a journal", file);
+    fclose(file);
+
+    NotificationJournal journal;
+    ASSERT_FALSE(journal.open(path, 0, true));
+    ASSERT_FALSE(journal.isOpen());
+    ASSERT_FALSE(journal.open(path, 0));
+}
+
+class TestNotificationJournalRule : public testing::Test
+{
+protected:
+    std::string dataDir;
+
+    void SetUp() override
+    {
+        char dir[] = "/tmp/systemspr_dataXXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        dataDir = dir;
+    }
+
+    void TearDown() override
+    {
+        // The journal shared by the instances is reopened in the data directory of the next run
+        NotificationJournal::getInstance().close();
+        ConnectionStateStore::getInstance().close();
+        std::string pluginDir = dataDir + "/" + FILTER_NAME;
+        removeDir(pluginDir + "/cache");
+        removeDir(pluginDir);
+        removeDir(dataDir);
+    }
+
+    static void removeDir(const std::string& path)
+    {
+        DIR *directory = opendir(path.c_str());
+        while (struct dirent *entry = directory ? readdir(directory) : nullptr) {
+            unlink((path + "/" + entry->d_name).c_str());
+        }
+        if (directory) {
+            closedir(directory);
+        }
+        rmdir(path.c_str());
+    }
+};
+
+TEST_F(TestNotificationJournalRule, JournalEvaluations)
+{
+    setenv("FLEDGE_DATA", dataDir.c_str(), 1);
+
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    config.setValue("journal", "true");
+    config.setValue("journal_size", "128");
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    unsetenv("FLEDGE_DATA");
+    ASSERT_NE(handle, nullptr);
+
+    NotificationJournal& journal = NotificationJournal::getInstance();
+    ASSERT_TRUE(journal.isOpen());
+    uint32_t capacity = journal.getHeader()->capacity;
+
+    // The journal is shared, the size of another instance is ignored
+    ConfigCategory otherConfig("systemsp_other", info->config);
+    otherConfig.setItemsValueFromDefault();
+    otherConfig.setValue("journal", "true");
+    otherConfig.setValue("journal_size", std::to_string(capacity + 1));
+    PLUGIN_HANDLE other = plugin_init(&otherConfig);
+    ASSERT_NE(other, nullptr);
+    ASSERT_EQ(journal.getHeader()->capacity, capacity);
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(other));
+    uint64_t start = journal.getHeader()->writeIndex.load();
+
+    std::string reconfigure = QUOTE({
+        "exchanged_data": {
+            "value": {
+                "exchanged_data": {
+                    "datapoints": [
+                        {
+                            "label":"TS-1",
+                            "pivot_id":"M_2367_3_15_4",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"]
+                        }
+                    ]
+                }
+            }
+        }
+    });
+    plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(handle), reconfigure);
+
+    std::string assetConnectionLoss = QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}});
+    std::string assetGIStarted = QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "started"}}});
+    std::string assetOther = QUOTE({"CONNECTION-2": {"south_event": {"gi_status": "started"}}});
+    ASSERT_TRUE(plugin_eval(handle, assetConnectionLoss));
+    ASSERT_FALSE(plugin_eval(handle, assetGIStarted));
+    ASSERT_FALSE(plugin_eval(handle, assetOther));
+
+    // Only the south_event of the tracked asset are journaled
+    ASSERT_EQ(journal.getHeader()->writeIndex.load(), start + 2);
+    NotificationJournal::Event event;
+    ASSERT_TRUE(journal.readEvent(start, event));
+    ASSERT_TRUE(event.verdict);
+    ASSERT_EQ(event.connxStatus, ConnxStatus::NotConnected);
+    ASSERT_EQ(event.payloadSize, assetConnectionLoss.size());
+    ASSERT_EQ(event.payloadHash, UtilityHash::xxh64(assetConnectionLoss));
+    ASSERT_STREQ(journal.getAssets()[event.assetId].name, "CONNECTION-1");
+    ASSERT_TRUE(journal.readEvent(start + 1, event));
+    ASSERT_FALSE(event.verdict);
+    ASSERT_EQ(event.giStatus, GiStatus::Started);
+
+    // A loss held by the aggregation is journaled with its own reading
+    plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(handle), QUOTE({
+        "aggregation_window": {"value": "3600000"},
+        "connections": {"value": {"connections": [{"asset": "CONNECTION-2", "protocol": "IEC104"}]}}
+    }));
+    VirtualClock clock;
+    static_cast<RuleSystemSp *>(handle)->setClock(&clock);
+    std::string assetGIFinished = QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "finished"}}});
+    ASSERT_TRUE(plugin_eval(handle, assetGIFinished));
+    ASSERT_FALSE(plugin_eval(handle, assetConnectionLoss));
+    clock.advanceMs(3600000);
+    ASSERT_TRUE(plugin_eval(handle, assetGIStarted));
+    ASSERT_EQ(journal.getHeader()->writeIndex.load(), start + 5);
+    ASSERT_TRUE(journal.readEvent(start + 3, event));
+    ASSERT_TRUE(event.verdict);
+    ASSERT_EQ(event.connxStatus, ConnxStatus::NotConnected);
+    ASSERT_TRUE(journal.readEvent(start + 4, event));
+    ASSERT_FALSE(event.verdict);
+    ASSERT_EQ(event.giStatus, GiStatus::Started);
+    static_cast<RuleSystemSp *>(handle)->setClock(nullptr);
+
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+}
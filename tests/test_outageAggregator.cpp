@@ -0,0 +1,40 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "outageAggregator.h"
+
+using namespace systemspr;
+
+TEST(TestOutageAggregator, Window)
+{
+    OutageAggregator aggregator;
+    ASSERT_FALSE(aggregator.isEnabled());
+    aggregator.configure(4, 100);
+    ASSERT_TRUE(aggregator.isEnabled());
+    ASSERT_FALSE(aggregator.isDue(1000));
+
+    ASSERT_TRUE(aggregator.add(2, 1000));
+    ASSERT_FALSE(aggregator.add(2, 1010));
+    ASSERT_TRUE(aggregator.add(0, 1050));
+    ASSERT_FALSE(aggregator.add(4, 1050));
+    ASSERT_TRUE(aggregator.isPending(0));
+    ASSERT_FALSE(aggregator.isDue(1099));
+    ASSERT_TRUE(aggregator.isDue(1100));
+
+    ASSERT_TRUE(aggregator.add(3, 1060));
+    ASSERT_TRUE(aggregator.remove(3));
+    ASSERT_FALSE(aggregator.remove(3));
+
+    std::vector<uint32_t> assets;
+    aggregator.take(assets);
+    ASSERT_EQ(assets, std::vector<uint32_t>({2, 0}));
+    ASSERT_EQ(aggregator.getPendingCount(), 0);
+    ASSERT_FALSE(aggregator.isPending(2));
+    ASSERT_FALSE(aggregator.isDue(5000));
+
+    // The next loss opens a new window
+    ASSERT_TRUE(aggregator.add(2, 6000));
+    ASSERT_FALSE(aggregator.isDue(6050));
+    aggregator.configure(4, 100);
+    ASSERT_EQ(aggregator.getPendingCount(), 0);
+}
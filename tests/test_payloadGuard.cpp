@@ -0,0 +1,44 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "payloadGuard.h"
+
+using namespace systemspr;
+
+static PayloadGuard::Verdict check(const PayloadGuard& guard, const std::string& json) {
+    return guard.check(json.data(), json.size());
+}
+
+TEST(TestPayloadGuard, NoLimit)
+{
+    PayloadGuard guard;
+    ASSERT_EQ(check(guard, std::string(100000, '[')), PayloadGuard::Verdict::Accepted);
+    ASSERT_EQ(guard.checkSize(SIZE_MAX), PayloadGuard::Verdict::Accepted);
+}
+
+TEST(TestPayloadGuard, Limits)
+{
+    PayloadGuard guard;
+    PayloadGuard::Limits limits;
+    limits.maxSize = 64;
+    limits.maxDepth = 3;
+    limits.maxMembers = 5;
+    uint64_t key = guard.getKey();
+    guard.configure(limits);
+    ASSERT_NE(guard.getKey(), key);
+
+    ASSERT_EQ(check(guard, R"({"a": {"b": [1, 2]}, "c": {}})"), PayloadGuard::Verdict::Accepted);
+    ASSERT_EQ(check(guard, R"({"a": {"b": [[1]]}})"), PayloadGuard::Verdict::TooDeep);
+    ASSERT_EQ(check(guard, R"({"a": [1, 2, 3, 4, 5]})"), PayloadGuard::Verdict::TooManyMembers);
+    ASSERT_EQ(check(guard, R"({"a": [1, 2, 3], "b": 1, "c": 2})"), PayloadGuard::Verdict::TooManyMembers);
+    ASSERT_EQ(check(guard, std::string(65, ' ')), PayloadGuard::Verdict::TooLarge);
+
+    // Brackets and commas in strings are not counted
+    ASSERT_EQ(check(guard, R"({"[[[[": ",,,,", "\"{{{{": "\\"})"), PayloadGuard::Verdict::Accepted);
+
+    // The scan stops at the first limit crossed, the rest is not read
+    limits.maxSize = 0;
+    guard.configure(limits);
+    ASSERT_EQ(check(guard, "[[[[" + std::string(1000000, '"')), PayloadGuard::Verdict::TooDeep);
+}
@@ -1,6 +1,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <plugin_api.h>
+#include <rapidjson/document.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 #include "ruleSystemSp.h"
 
@@ -53,4 +61,62 @@ TEST_F(TestPluginReconfigure, Reconfigure)
 {
 	plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), reconfigure);
     ASSERT_EQ(filter->isEnabled(), false);
-}
\ No newline at end of file
+}
+
+TEST_F(TestPluginReconfigure, ConcurrentEvalAndReconfigure)
+{
+    // One thread switches between the exchanged_data file and the category, the other between two
+    // sets of connections, while readings are evaluated. Each reason must match its notification.
+    std::string path = std::string(P_tmpdir) + "/systemspr_reconfigure_" + std::to_string(getpid()) + ".json";
+    std::ofstream(path) << QUOTE({"exchanged_data": {"datapoints": []}});
+    std::string withFile = "{\"exchanged_data_file\": {\"value\": \"" + path + "\"}}";
+    std::string withoutFile = QUOTE({"exchanged_data_file": {"value": ""}});
+    std::string withLink = QUOTE({"connections": {"value": {"connections": [{"asset": "LINK-1", "protocol": "IEC104"}]}}});
+    std::string withoutLink = QUOTE({"connections": {"value": {"connections": []}}});
+    std::vector<std::string> readings = {
+        QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}}),
+        QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "started", "gi_status": "finished"}}}),
+        QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}}),
+        QUOTE({"LINK-1": {"south_event": {"connx_status": "started", "gi_status": "finished"}}}),
+    };
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> errors{0};
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < 4; i++) {
+        threads.emplace_back([this, i, &readings, &stop, &errors]() {
+            for (uint32_t n = i; !stop.load(); n++) {
+                const std::string& reading = readings[n % readings.size()];
+                if (!filter->evalRule(reading)) {
+                    continue;
+                }
+                std::string reason = filter->getReason();
+                rapidjson::Document document;
+                // Another evaluation may have reset the reason since
+                if (!reason.empty() && (document.Parse(reason.c_str()).HasParseError() ||
+                    !document.IsObject() || !document.HasMember("reason"))) {
+                    errors.fetch_add(1);
+                }
+            }
+        });
+    }
+    auto reconfigureLoop = [this](const std::string& first, const std::string& second) {
+        for (uint32_t n = 0; n < 50; n++) {
+            plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), n % 2 ? second : first);
+        }
+    };
+    std::thread fileThread(reconfigureLoop, withFile, withoutFile);
+    std::thread linkThread(reconfigureLoop, withLink, withoutLink);
+    fileThread.join();
+    linkThread.join();
+    stop.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    unlink(path.c_str());
+    ASSERT_EQ(errors.load(), 0);
+
+    // The connections left are the last ones applied
+    ASSERT_EQ(filter->getTriggers().find("LINK-1"), std::string::npos);
+    ASSERT_FALSE(filter->evalRule(readings[2]));
+}
@@ -0,0 +1,52 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "reasonTemplate.h"
+
+using namespace systemspr;
+
+// Render a template with the name of each slot as value
+static std::string renderNames(const ReasonTemplate& reasonTemplate) {
+    std::string out;
+    reasonTemplate.render(out, [](std::string& reason, ReasonTemplate::Slot slot) {
+        reason += '#';
+        reason += ReasonTemplate::slotName(slot);
+    });
+    return out;
+}
+
+TEST(TestReasonTemplate, Default)
+{
+    ReasonTemplate reasonTemplate;
+    ASSERT_EQ(reasonTemplate.getText(), ReasonTemplate::Default);
+    ASSERT_TRUE(reasonTemplate.uses(ReasonTemplate::Slot::Details));
+    ASSERT_FALSE(reasonTemplate.uses(ReasonTemplate::Slot::PivotIds));
+    ASSERT_EQ(renderNames(reasonTemplate), "{ \"asset\": \"#asset\", \"reason\": \"#reason\"#details }");
+}
+
+TEST(TestReasonTemplate, Segments)
+{
+    ReasonTemplate reasonTemplate;
+    ASSERT_TRUE(reasonTemplate.compile(R"({"a<b": "<fired_asset>", "ids": <pivot_ids>, "<x": <site_down>})"));
+    const std::vector<ReasonTemplate::Segment>& segments = reasonTemplate.getSegments();
+    ASSERT_EQ(segments.size(), 7);
+    ASSERT_EQ(segments[0].slot, ReasonTemplate::Slot::Literal);
+    ASSERT_EQ(segments[1].slot, ReasonTemplate::Slot::FiredAsset);
+    ASSERT_EQ(segments[3].slot, ReasonTemplate::Slot::PivotIds);
+    ASSERT_EQ(segments[5].slot, ReasonTemplate::Slot::SiteDown);
+    ASSERT_EQ(renderNames(reasonTemplate),
+              R"({"a<b": "#fired_asset", "ids": #pivot_ids, "<x": #site_down})");
+}
+
+TEST(TestReasonTemplate, Invalid)
+{
+    ReasonTemplate reasonTemplate;
+    ASSERT_TRUE(reasonTemplate.compile(R"({"asset": "<asset>"})"));
+
+    // Unknown placeholder, not an object, not JSON: the current template is kept
+    ASSERT_FALSE(reasonTemplate.compile(R"({"asset": "<site_id>"})"));
+    ASSERT_FALSE(reasonTemplate.compile(R"(["<asset>"])"));
+    ASSERT_FALSE(reasonTemplate.compile(R"({"status": <asset>})"));
+    ASSERT_EQ(reasonTemplate.getText(), R"({"asset": "<asset>"})");
+    ASSERT_EQ(renderNames(reasonTemplate), R"({"asset": "#asset"})");
+}
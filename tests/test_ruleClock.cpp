@@ -0,0 +1,44 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <ctime>
+
+#include "ruleClock.h"
+
+using namespace systemspr;
+
+TEST(TestRuleClock, CoarseClock)
+{
+    const RuleClock& clock = CoarseClock::getInstance();
+    RuleClock::Time first = clock.now();
+    RuleClock::Time second = clock.now();
+    ASSERT_GT(first.monotonicNs, 0);
+    ASSERT_GE(second.monotonicNs, first.monotonicNs);
+
+    // The realtime is the one of the system, within the resolution of the coarse clock
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t nowNs = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+    ASSERT_LE(second.realtimeNs, nowNs);
+    ASSERT_LT(nowNs - second.realtimeNs, 1000000000ULL);
+}
+
+TEST(TestRuleClock, VirtualClock)
+{
+    VirtualClock clock;
+    RuleClock::Time time = clock.now();
+    ASSERT_EQ(time.monotonicNs, 0);
+    ASSERT_EQ(time.realtimeNs, VirtualClock::DefaultRealtimeNs);
+    ASSERT_EQ(clock.now().monotonicNs, 0);
+
+    // Both clocks move together, and only when advanced
+    clock.advance(500);
+    clock.advanceMs(2);
+    time = clock.now();
+    ASSERT_EQ(time.monotonicNs, 2000500);
+    ASSERT_EQ(time.realtimeNs, VirtualClock::DefaultRealtimeNs + 2000500);
+
+    VirtualClock other(1000);
+    other.advanceMs(1);
+    ASSERT_EQ(other.now().realtimeNs, 1001000);
+}
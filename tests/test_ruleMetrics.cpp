@@ -0,0 +1,165 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "connectionStateStore.h"
+#include "ruleMetrics.h"
+#include "ruleSystemSp.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    std::string plugin_reason(PLUGIN_HANDLE handle);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+TEST(TestRuleMetrics, HistogramBuckets)
+{
+    for (uint64_t value : {0ULL, 1ULL, 15ULL, 16ULL, 17ULL, 100ULL, 1000ULL, 123456789ULL, 1ULL << 39}) {
+        uint32_t index = LatencyHistogram::bucketIndex(value);
+        ASSERT_LT(index, LatencyHistogram::BucketCount);
+        ASSERT_GE(LatencyHistogram::bucketUpperBound(index), value);
+        if (index > 0) {
+            ASSERT_LT(LatencyHistogram::bucketUpperBound(index - 1), value);
+        }
+    }
+    ASSERT_EQ(LatencyHistogram::bucketIndex(UINT64_MAX), LatencyHistogram::BucketCount - 1);
+}
+
+TEST(TestRuleMetrics, HistogramPercentiles)
+{
+    LatencyHistogram histogram;
+    ASSERT_EQ(histogram.percentile(50), 0);
+    for (uint64_t value = 1; value <= 1000; value++) {
+        histogram.record(value * 1000);
+    }
+    ASSERT_EQ(histogram.count(), 1000);
+    ASSERT_EQ(histogram.max(), 1000000);
+    ASSERT_EQ(histogram.sum(), 500500000);
+    // Relative error bounded by the width of the sub-buckets
+    ASSERT_NEAR(histogram.percentile(50), 500000, 500000 / LatencyHistogram::SubBuckets);
+    ASSERT_NEAR(histogram.percentile(99), 990000, 990000 / LatencyHistogram::SubBuckets);
+    ASSERT_EQ(histogram.percentile(100), 1000000);
+}
+
+TEST(TestRuleMetrics, Formats)
+{
+    RuleMetrics metrics;
+    metrics.countDecision(EvalDecision::Disabled);
+    metrics.countDecision(EvalDecision::NoTracking);
+    metrics.countDecision(EvalDecision::FiredGiFinished);
+    metrics.evalLatency().record(2000);
+    ASSERT_EQ(metrics.getEvaluations(), 3);
+    ASSERT_EQ(metrics.getPrefiltered(), 2);
+
+    std::string json = metrics.toJson("rule");
+    ASSERT_NE(json.find("\"evaluations\":3"), std::string::npos);
+    ASSERT_NE(json.find("\"fired_gi_finished\":1"), std::string::npos);
+    ASSERT_NE(json.find("\"eval\":{\"count\":1,\"mean\":2000"), std::string::npos);
+
+    std::string prometheus = metrics.toPrometheus("rule");
+    ASSERT_NE(prometheus.find("systemspr_evaluations_total{instance=\"rule\",decision=\"disabled\"} 1\n"),
+              std::string::npos);
+    ASSERT_NE(prometheus.find("systemspr_prefiltered_total{instance=\"rule\"} 2\n"), std::string::npos);
+    ASSERT_NE(prometheus.find("systemspr_eval_latency_seconds_count{instance=\"rule\"} 1\n"), std::string::npos);
+}
+
+class TestRuleMetricsExport : public testing::Test
+{
+protected:
+    std::string dir;
+
+    void SetUp() override
+    {
+        char path[] = "/tmp/systemspr_metricsXXXXXX";
+        ASSERT_NE(mkdtemp(path), nullptr);
+        dir = path;
+    }
+
+    void TearDown() override
+    {
+        // The state store shared by the instances may be opened in the data directory of the test
+        ConnectionStateStore::getInstance().close();
+        removeDir(dir + "/systemspr/cache");
+        removeDir(dir + "/systemspr");
+        removeDir(dir);
+    }
+
+    static void removeDir(const std::string& path)
+    {
+        DIR *directory = opendir(path.c_str());
+        while (struct dirent *entry = directory ? readdir(directory) : nullptr) {
+            unlink((path + "/" + entry->d_name).c_str());
+        }
+        if (directory) {
+            closedir(directory);
+        }
+        rmdir(path.c_str());
+    }
+};
+
+TEST_F(TestRuleMetricsExport, ExportInterval)
+{
+    std::string path = dir + "/metrics.prom";
+
+    RuleMetrics metrics;
+    metrics.evalLatency().record(1000);
+    // Written by the export thread without any evaluation
+    metrics.setExport("rule", path, RuleMetrics::Format::Prometheus, 1000000);
+    for (int i = 0; i < 1000 && access(path.c_str(), F_OK) != 0; i++) {
+        usleep(1000);
+    }
+    ASSERT_EQ(access(path.c_str(), F_OK), 0);
+
+    // Written a last time when the export stops
+    metrics.evalLatency().record(2000);
+    metrics.stopExport();
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(content, metrics.toPrometheus("rule"));
+
+    metrics.setExport("rule", "/nonexistent/dir/metrics.json", RuleMetrics::Format::Json, 0);
+    ASSERT_FALSE(metrics.exportToFile("rule"));
+}
+
+TEST_F(TestRuleMetricsExport, RuleInstrumentation)
+{
+    setenv("FLEDGE_DATA", dir.c_str(), 1);
+
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    config.setValue("metrics_file", "metrics.json");
+    config.setValue("metrics_interval", "0");
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    unsetenv("FLEDGE_DATA");
+    ASSERT_NE(handle, nullptr);
+    RuleSystemSp *rule = static_cast<RuleSystemSp *>(handle);
+
+    plugin_eval(handle, QUOTE({42}));
+    plugin_eval(handle, QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "finished"}}}));
+    plugin_reason(handle);
+
+    const RuleMetrics& metrics = rule->getMetrics();
+    ASSERT_EQ(metrics.getEvaluations(), 2);
+    ASSERT_EQ(metrics.getDecisionCount(EvalDecision::ParseError), 1);
+    ASSERT_EQ(metrics.getDecisionCount(EvalDecision::FiredGiFinished), 1);
+    ASSERT_EQ(metrics.evalLatency().count(), 2);
+    ASSERT_EQ(metrics.reasonLatency().count(), 1);
+    ASSERT_EQ(metrics.reconfigureLatency().count(), 1);
+    ASSERT_EQ(metrics.reconfigureStall().count(), 1);
+
+    // The only export of an interval of 0 is written by the shutdown
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+    std::string path = dir + "/systemspr/metrics.json";
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_NE(content.find("\"instance\":\"systemsp\",\"evaluations\":2"), std::string::npos);
+}
@@ -0,0 +1,170 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "sharedStateTable.h"
+#include "ruleSystemSp.h"
+
+using namespace systemspr;
+
+extern "C" {
+	PLUGIN_INFORMATION *plugin_info();
+	PLUGIN_HANDLE plugin_init(ConfigCategory *config);
+    bool plugin_eval(PLUGIN_HANDLE handle, const std::string& assetValues);
+    void plugin_shutdown(PLUGIN_HANDLE *handle);
+};
+
+TEST(TestSharedStateTable, PublishAndRead)
+{
+    std::string name = "/systemspr_test_" + std::to_string(getpid());
+    SharedStateTable writer;
+    ASSERT_TRUE(writer.open(name));
+    SharedStateTable reader;
+    ASSERT_TRUE(reader.open(name, true));
+    ASSERT_EQ(reader.find("LINK-1"), nullptr);
+
+    SharedStateTable::Entry *entry = writer.acquire("LINK-1");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(writer.acquire("LINK-1"), entry);
+    ASSERT_EQ(reader.getHeader()->count.load(), 1);
+
+    uint32_t changes = reader.getChanges();
+    ASSERT_FALSE(reader.waitForChange(changes, 10));
+    bool changed = false;
+    std::thread waiter([&reader, &changed, changes]() { changed = reader.waitForChange(changes, 5000); });
+    ASSERT_TRUE(writer.update(entry, ConnxStatus::NotConnected, GiStatus::None, 1000));
+    waiter.join();
+    ASSERT_TRUE(changed);
+    ASSERT_EQ(reader.getHeader()->waiters.load(), 0);
+
+    const SharedStateTable::Entry *found = reader.find("LINK-1");
+    ASSERT_NE(found, nullptr);
+    SharedStateTable::State state;
+    ASSERT_TRUE(SharedStateTable::read(*found, state));
+    ASSERT_EQ(state.asset, "LINK-1");
+    ASSERT_EQ(state.linkState, LinkState::NotConnected);
+    ASSERT_EQ(state.connxStatus, ConnxStatus::NotConnected);
+    ASSERT_EQ(state.lossCount, 1);
+    ASSERT_EQ(state.updatedNs, 1000);
+
+    // The same statuses again do not wake up the readers
+    changes = reader.getChanges();
+    ASSERT_FALSE(writer.update(entry, ConnxStatus::NotConnected, GiStatus::None, 2000));
+    ASSERT_EQ(reader.getChanges(), changes);
+
+    ASSERT_TRUE(writer.update(entry, ConnxStatus::Started, GiStatus::Finished, 3000));
+    ASSERT_TRUE(SharedStateTable::read(*found, state));
+    ASSERT_EQ(state.linkState, LinkState::Connected);
+    ASSERT_EQ(state.giStatus, GiStatus::Finished);
+    ASSERT_EQ(state.lossCount, 1);
+    ASSERT_EQ(state.updatedNs, 3000);
+
+    reader.close();
+    writer.close();
+    ASSERT_TRUE(SharedStateTable::unlink(name));
+    ASSERT_FALSE(reader.open(name, true));
+}
+
+TEST(TestSharedStateTable, ConcurrentWriters)
+{
+    std::string name = "/systemspr_test_writers_" + std::to_string(getpid());
+    SharedStateTable writer;
+    ASSERT_TRUE(writer.open(name));
+    SharedStateTable::Entry *entry = writer.acquire("LINK-1");
+    ASSERT_NE(entry, nullptr);
+
+    // Each writer publishes entries whose loss count is their time, a torn entry mixes two of them
+    const uint32_t updates = 20000;
+    ASSERT_TRUE(writer.publish(entry, LinkState::Connected, ConnxStatus::Started, GiStatus::None, 0, 0));
+    std::atomic<bool> done{false};
+    uint32_t torn = 0;
+    std::thread reader([&]() {
+        SharedStateTable::State state;
+        while (!done.load()) {
+            // A reader may give up while the writers keep the entry locked, never with a torn copy
+            if (SharedStateTable::read(*entry, state)) {
+                torn += state.lossCount != state.updatedNs ||
+                        (state.lossCount % 2 == 0) != (state.linkState == LinkState::Connected);
+            }
+        }
+    });
+    std::vector<std::thread> writers;
+    for (uint32_t w = 0; w < 4; w++) {
+        writers.emplace_back([&writer, entry, w, updates]() {
+            for (uint32_t i = 0; i < updates; i++) {
+                uint32_t value = i * 4 + w;
+                bool connected = value % 2 == 0;
+                writer.publish(entry, connected ? LinkState::Connected : LinkState::NotConnected,
+                               connected ? ConnxStatus::Started : ConnxStatus::NotConnected, GiStatus::None, value, value);
+            }
+        });
+    }
+    for (std::thread& thread : writers) {
+        thread.join();
+    }
+    done = true;
+    reader.join();
+    ASSERT_EQ(torn, 0);
+    ASSERT_EQ(entry->sequence.load() % 2, 0);
+
+    writer.close();
+    ASSERT_TRUE(SharedStateTable::unlink(name));
+}
+
+TEST(TestSharedStateTable, InterruptedWriter)
+{
+    std::string name = "/systemspr_test_interrupted_" + std::to_string(getpid());
+    SharedStateTable writer;
+    ASSERT_TRUE(writer.open(name));
+    SharedStateTable::Entry *entry = writer.acquire("LINK-1");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_TRUE(writer.publish(entry, LinkState::NotConnected, ConnxStatus::NotConnected, GiStatus::None, 1, 1000));
+
+    // A writer killed during an update leaves the sequence odd
+    entry->sequence.fetch_add(1);
+    SharedStateTable reader;
+    ASSERT_TRUE(reader.open(name, true));
+    SharedStateTable::State state;
+    ASSERT_FALSE(SharedStateTable::read(*reader.find("LINK-1"), state));
+
+    // The restarted writer releases it
+    writer.close();
+    ASSERT_TRUE(writer.open(name));
+    entry = writer.acquire("LINK-1");
+    ASSERT_EQ(entry->sequence.load() % 2, 0);
+    ASSERT_TRUE(SharedStateTable::read(*reader.find("LINK-1"), state));
+    ASSERT_EQ(state.lossCount, 1);
+    ASSERT_FALSE(writer.publish(entry, LinkState::NotConnected, ConnxStatus::NotConnected, GiStatus::None, 1, 1000));
+    ASSERT_TRUE(writer.update(entry, ConnxStatus::Started, GiStatus::Finished, 2000));
+
+    reader.close();
+    writer.close();
+    ASSERT_TRUE(SharedStateTable::unlink(name));
+}
+
+TEST(TestSharedStateTable, RulePublishes)
+{
+    std::string name = "/systemspr_test_rule_" + std::to_string(getpid());
+    PLUGIN_INFORMATION *info = plugin_info();
+    ConfigCategory config("systemsp", info->config);
+    config.setItemsValueFromDefault();
+    config.setValue("shared_state_name", name.substr(1));
+    PLUGIN_HANDLE handle = plugin_init(&config);
+    ASSERT_NE(handle, nullptr);
+
+    SharedStateTable reader;
+    ASSERT_TRUE(reader.open(SharedStateTable::getInstance().getName(), true));
+    plugin_eval(handle, QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}}));
+    SharedStateTable::State state;
+    ASSERT_NE(reader.find("CONNECTION-1"), nullptr);
+    ASSERT_TRUE(SharedStateTable::read(*reader.find("CONNECTION-1"), state));
+    ASSERT_EQ(state.linkState, LinkState::NotConnected);
+
+    plugin_eval(handle, QUOTE({"CONNECTION-1": {"south_event": {"gi_status": "finished"}}}));
+    ASSERT_TRUE(SharedStateTable::read(*reader.find("CONNECTION-1"), state));
+    ASSERT_EQ(state.linkState, LinkState::Connected);
+    plugin_shutdown(reinterpret_cast<PLUGIN_HANDLE*>(handle));
+}
@@ -0,0 +1,198 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "southEventReader.h"
+#include "structuralIndex.h"
+
+using namespace systemspr;
+
+static const StructuralIndex::Kernel allKernels[] = {
+    StructuralIndex::Kernel::Scalar, StructuralIndex::Kernel::Sse2, StructuralIndex::Kernel::Avx2
+};
+
+// Structural characters found byte by byte
+static std::vector<uint32_t> referencePositions(const std::string& json) {
+    std::vector<uint32_t> positions;
+    bool inString = false;
+    for (uint32_t i = 0; i < json.size(); i++) {
+        char c = json[i];
+        if (inString) {
+            if (c == '\\') {
+                i++;
+            }
+            else if (c == '"') {
+                positions.push_back(i);
+                inString = false;
+            }
+        }
+        else if (c == '"') {
+            positions.push_back(i);
+            inString = true;
+        }
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') {
+            positions.push_back(i);
+        }
+    }
+    return positions;
+}
+
+static std::vector<uint32_t> indexPositions(const StructuralIndex& index) {
+    std::vector<uint32_t> positions;
+    for (uint32_t i = 0; i < index.size(); i++) {
+        positions.push_back(index.getPosition(i));
+    }
+    return positions;
+}
+
+TEST(TestStructuralIndex, KernelsMatchReference)
+{
+    // Escaped quotes and backslash runs at every offset of the 64 bytes blocks
+    std::vector<std::string> documents;
+    for (size_t padding = 0; padding < 70; padding++) {
+        std::string filler(padding, 'x');
+        documents.push_back("{\"" + filler + "\": [\"a\\\"{b\", \"c\\\\\", {\"d\": \"\\\\\\\"\"}], \"e\": 1}");
+        documents.push_back("[\"" + filler + "\\\\\\\\\", \":,{}[]\", true, null]");
+    }
+    for (const std::string& json : documents) {
+        std::vector<uint32_t> expected = referencePositions(json);
+        for (StructuralIndex::Kernel kernel : allKernels) {
+            StructuralIndex index;
+            if (!index.setKernel(kernel)) {
+                continue;
+            }
+            ASSERT_TRUE(index.build(json.data(), json.size())) << json;
+            ASSERT_EQ(indexPositions(index), expected) << StructuralIndex::getKernelName(kernel) << ": " << json;
+        }
+    }
+}
+
+TEST(TestStructuralIndex, Invalid)
+{
+    StructuralIndex index;
+    for (const std::string& json : {"{\"a\": \"b}", "{\"a\": [1}", "{\"a\": 1}}", "[\"a\\\"]"}) {
+        ASSERT_FALSE(index.build(json.data(), json.size())) << json;
+    }
+    for (const std::string& json : {"{\"a\": 1} {}", "{\"a\" 1}", "{\"a\": 1,}", ""}) {
+        ASSERT_TRUE(index.build(json.data(), json.size()));
+        StructuralIndex::Value root = index.getRoot();
+        bool valid = root.type == StructuralIndex::Type::Object &&
+                     index.forEachMember(root, [](const char *, size_t, bool, const StructuralIndex::Value&) {
+                         return true;
+                     });
+        ASSERT_FALSE(valid) << json;
+    }
+}
+
+TEST(TestStructuralIndex, Validate)
+{
+    StructuralIndex index;
+    for (const std::string& json : {"{}", " [ ] ", "-0", " true ", "\"a\"", "{\"a\": [1.5E-3, {}, [null]], \"b\": \"\\ud83d\\ude00\"}"}) {
+        ASSERT_TRUE(index.build(json.data(), json.size())) << json;
+        ASSERT_TRUE(index.validate()) << json;
+    }
+    for (const std::string& json : {"{\"a\": 1} {}", "{\"a\" 1}", "{\"a\": 1,}", "", "1 2", "[1 true]", "{1: 2}", "[,]",
+                                    "[1.]", "[-]", "[1e]", "[nul]", "[\"\\ud83d\"]", "{\"a\": 1]", "[] ]"}) {
+        if (index.build(json.data(), json.size())) {
+            ASSERT_FALSE(index.validate()) << json;
+        }
+    }
+}
+
+TEST(TestStructuralIndex, Navigate)
+{
+    std::string json = R"( {"skip": {"x": [1, {"y": "}"}]}, "kéy": "v\"alé", "n": -1.5e3 } )";
+    StructuralIndex index;
+    ASSERT_TRUE(index.build(json.data(), json.size()));
+    StructuralIndex::Value root = index.getRoot();
+    ASSERT_EQ(root.type, StructuralIndex::Type::Object);
+
+    std::vector<std::string> keys;
+    std::vector<StructuralIndex::Type> types;
+    std::string value;
+    ASSERT_TRUE(index.forEachMember(root, [&](const char *key, size_t length, bool escaped,
+                                              const StructuralIndex::Value& member) {
+        std::string name;
+        if (escaped) {
+            EXPECT_TRUE(StructuralIndex::unescape(key, length, name));
+        }
+        else {
+            name.assign(key, length);
+        }
+        keys.push_back(name);
+        types.push_back(member.type);
+        const char *text;
+        size_t textLength;
+        bool textEscaped;
+        if (index.getString(member, text, textLength, textEscaped)) {
+            EXPECT_TRUE(textEscaped);
+            EXPECT_TRUE(StructuralIndex::unescape(text, textLength, value));
+        }
+        return true;
+    }));
+    ASSERT_EQ(keys, std::vector<std::string>({"skip", "k\xc3\xa9y", "n"}));
+    ASSERT_EQ(types, std::vector<StructuralIndex::Type>({StructuralIndex::Type::Object,
+                                                         StructuralIndex::Type::String,
+                                                         StructuralIndex::Type::Scalar}));
+    ASSERT_EQ(value, "v\"al\xc3\xa9");
+
+    std::string decoded;
+    ASSERT_TRUE(StructuralIndex::unescape("\\ud83d\\ude00", 12, decoded));
+    ASSERT_EQ(decoded, "\xf0\x9f\x98\x80");
+    ASSERT_FALSE(StructuralIndex::unescape("\\ud83d", 6, decoded));
+    ASSERT_FALSE(StructuralIndex::unescape("\\x", 2, decoded));
+}
+
+TEST(TestStructuralIndex, SameResultAsDom)
+{
+    std::string pivot = R"("PIVOT": {"GTIS": {"Cause": {"stVal": 3}, "SpsTyp": {"q": {"Validity": "good"}, "stVal": true}}})";
+    std::vector<std::string> readings = {
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}})",
+        R"({"LINK-2": {)" + pivot + R"(, "south_event": {"gi_status": "finished", "connx_status": "started"}}})",
+        R"({"OTHER": {"south_event": {}}, "LINK-2": {"south_event": {"gi_status": "finished"}}, "LINK-1": {"south_event": {"gi_status": "idle"}}})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "LINK-1": {"south_event": {}}})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected", "connx_status": "started"}}})",
+        R"({"LINK-1": {"south_event": {"gi_status": 5, "connx_status": ["not connected"]}}})",
+        R"({"LINK-1": {"south_event": "connx_status"}})",
+        R"({"LINK-1": {"data": {"south_event": {}}}})",
+        R"({"LINK-1": [{"south_event": {}}]})",
+        R"({"OTHER": {"south_event": {"connx_status": "not connected"}}})",
+        R"(["LINK-1"])",
+        R"("LINK-1")",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}} trailing)",
+        R"({"LINK-1": {"south_event": {"connx_status: "not connected"}}})",
+        "",
+        // Syntax errors in the values which are not read
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "x": tru})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "q": [1,,2]})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "a" 1})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "a": "\x"})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "a": [01, 1e999]})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "a": {"b": 1 2}})",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "a": ["x":1]})",
+        "{\"LINK-1\": {\"south_event\": {\"connx_status\": \"not connected\"}}, \"a\": \"\t\"}",
+        R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}, "a": [-0.5e+3, true, false, null, "\u00e9"]})",
+        // rapidjson stops at the first null character
+        std::string(R"({"LINK-1": {"south_event": {"connx_status": "not connected"}}})") + '\0' + "{",
+        std::string(1, '\0') + R"({"LINK-1": {}})",
+    };
+    std::vector<std::string> trackedAssets = {"LINK-1", "LINK-2"};
+    for (StructuralIndex::Kernel kernel : allKernels) {
+        StructuralIndex index;
+        if (!index.setKernel(kernel)) {
+            continue;
+        }
+        for (const std::string& reading : readings) {
+            EvalResult dom = SouthEventReader::readDom(reading.c_str(), trackedAssets);
+            EvalResult onDemand = SouthEventReader::readOnDemand(index, reading.data(), reading.size(), trackedAssets);
+            ASSERT_EQ(onDemand.decision, dom.decision) << StructuralIndex::getKernelName(kernel) << ": " << reading;
+            ASSERT_EQ(onDemand.connxStatus, dom.connxStatus) << reading;
+            ASSERT_EQ(onDemand.giStatus, dom.giStatus) << reading;
+            if (dom.decision > EvalDecision::WrongAsset) {
+                ASSERT_EQ(onDemand.assetIndex, dom.assetIndex) << reading;
+            }
+        }
+    }
+}
@@ -91,6 +91,7 @@ extern "C" {
 class TestSystemSp : public testing::Test
 {
 protected:
+    VirtualClock clock;              // Clock of the tests using time, outlives filter
     RuleSystemSp *filter = nullptr;  // Object on which we call for tests
 
     // Setup is ran for every tests, so each variable are reinitialised
@@ -463,3 +464,511 @@ TEST_F(TestSystemSp, AssetTrigger)
     ASSERT_FALSE(plugin_eval(filter, assetNewName));
     ASSERT_STREQ(plugin_reason(filter).c_str(), "");
 }
+
+TEST_F(TestSystemSp, ConnectionPointSets)
+{
+    std::string customConfig = QUOTE({
+        "asset": {
+            "value": "CONNECTION-1"
+        },
+        "exchanged_data": {
+            "value": {
+                "exchanged_data": {
+                    "datapoints": [
+                        {
+                            "label":"TS-1",
+                            "pivot_id":"ID-1",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1001"}]
+                        },
+                        {
+                            "label":"TS-2",
+                            "pivot_id":"ID-2",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"2001"}]
+                        },
+                        {
+                            "label":"TS-3",
+                            "pivot_id":"ID-3",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"2002"}]
+                        }
+                    ]
+                }
+            }
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "LINK-1", "protocol": "IEC104", "address_ranges": [{"from": 1000, "to": 1999}]},
+                    {"asset": "LINK-2", "protocol": "IEC104", "address_ranges": [{"from": 2000, "to": 2999}]}
+                ]
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+
+    std::string expectedTrigger = QUOTE({
+        "triggers": [
+            {
+                "asset": "CONNECTION-1"
+            },
+            {
+                "asset": "LINK-1"
+            },
+            {
+                "asset": "LINK-2"
+            }
+        ]
+    });
+    ASSERT_STREQ(plugin_triggers(filter).c_str(), expectedTrigger.c_str());
+
+    // Loss of a connection only covers the datapoints reachable through it
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-2": {"south_event": {"connx_status": "not connected"}}})));
+    std::string jsonNotification = plugin_reason(filter);
+    validateNotification(jsonNotification, {
+        {"asset", "connx_status"},
+        {"reason", "not connected"}
+    });
+    if(HasFatalFailure()) return;
+    rapidjson::Document d;
+    d.Parse(jsonNotification.c_str());
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-2");
+    ASSERT_EQ(d["pivot_ids"].GetArray().Size(), 2);
+    ASSERT_STREQ(d["pivot_ids"][0].GetString(), "ID-2");
+    ASSERT_STREQ(d["pivot_ids"][1].GetString(), "ID-3");
+
+    // The tracked asset without connection mapping still covers all prt.inf
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}})));
+    jsonNotification = plugin_reason(filter);
+    d.Parse(jsonNotification.c_str());
+    ASSERT_FALSE(d.HasParseError());
+    ASSERT_FALSE(d.HasMember("connection"));
+    ASSERT_FALSE(d.HasMember("pivot_ids"));
+}
+
+TEST_F(TestSystemSp, AggregatedOutage)
+{
+    std::string customConfig = QUOTE({
+        "asset": {
+            "value": "CONNECTION-1"
+        },
+        "aggregation_window": {
+            "value": "50"
+        },
+        "site_down_threshold": {
+            "value": "50"
+        },
+        "exchanged_data": {
+            "value": {
+                "exchanged_data": {
+                    "datapoints": [
+                        {
+                            "label":"TS-1",
+                            "pivot_id":"ID-1",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1001"}]
+                        },
+                        {
+                            "label":"TS-2",
+                            "pivot_id":"ID-2",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"2001"}]
+                        }
+                    ]
+                }
+            }
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "LINK-1", "protocol": "IEC104", "address_ranges": [{"from": 1000, "to": 1999}]},
+                    {"asset": "LINK-2", "protocol": "IEC104", "address_ranges": [{"from": 2000, "to": 2999}]},
+                    {"asset": "LINK-3", "protocol": "IEC104", "address_ranges": [{"from": 3000, "to": 3999}]}
+                ]
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+    filter->setClock(&clock);
+
+    // The losses are held until the end of the window
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}})));
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-2": {"south_event": {"connx_status": "not connected"}}})));
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-3": {"south_event": {"connx_status": "not connected"}}})));
+    // A connection recovering within the window is not notified
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-3": {"south_event": {"gi_status": "finished"}}})));
+    ASSERT_STREQ(plugin_reason(filter).c_str(), "");
+    clock.advanceMs(60);
+
+    // The first evaluation after the window sends a single notification for all the losses
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-3": {"south_event": {"gi_status": "started"}}})));
+    std::string jsonNotification = plugin_reason(filter);
+    validateNotification(jsonNotification, {
+        {"asset", "connx_status"},
+        {"reason", "not connected"}
+    });
+    if(HasFatalFailure()) return;
+    rapidjson::Document d;
+    d.Parse(jsonNotification.c_str());
+    ASSERT_EQ(d["assets"].GetArray().Size(), 2);
+    ASSERT_STREQ(d["assets"][0].GetString(), "LINK-1");
+    ASSERT_STREQ(d["assets"][1].GetString(), "LINK-2");
+    ASSERT_EQ(d["pivot_ids"].GetArray().Size(), 2);
+    ASSERT_STREQ(d["pivot_ids"][0].GetString(), "ID-1");
+    ASSERT_STREQ(d["pivot_ids"][1].GetString(), "ID-2");
+    // 2 of the 4 tracked assets
+    ASSERT_TRUE(d["site_down"].GetBool());
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-3": {"south_event": {"gi_status": "started"}}})));
+
+    // A single loss gives the same notification as without aggregation
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}})));
+    clock.advanceMs(60);
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"gi_status": "started"}}})));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_FALSE(d.HasMember("assets"));
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-1");
+
+    // Recoveries of the connections which are not pending are notified immediately
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-2": {"south_event": {"gi_status": "finished"}}})));
+    validateNotification(plugin_reason(filter), {
+        {"asset", "gi_status"},
+        {"reason", "finished"}
+    });
+}
+
+TEST_F(TestSystemSp, AggregationOverHours)
+{
+    std::string customConfig = QUOTE({
+        "asset": {
+            "value": ""
+        },
+        "aggregation_window": {
+            "value": "3600000"
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "LINK-1", "protocol": "IEC104"},
+                    {"asset": "LINK-2", "protocol": "IEC104"}
+                ]
+            }
+        },
+        "reason_template": {
+            "value": "{\"asset\": \"<asset>\", \"reason\": \"<reason>\", \"at\": \"<timestamp>\"}"
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+    filter->setClock(&clock);
+    std::string lost = QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}});
+    std::string recovered = QUOTE({"LINK-1": {"south_event": {"gi_status": "finished"}}});
+    std::string other = QUOTE({"LINK-2": {"south_event": {"gi_status": "started"}}});
+
+    // A day of losses of LINK-1, each recovered within the window of an hour, is never notified
+    for (uint32_t hour = 0; hour < 24; hour++) {
+        ASSERT_FALSE(plugin_eval(filter, lost));
+        clock.advanceMs(59 * 60 * 1000);
+        ASSERT_FALSE(plugin_eval(filter, other));
+        ASSERT_FALSE(plugin_eval(filter, recovered));
+        clock.advanceMs(60 * 1000);
+    }
+
+    // A loss which lasts the whole window is notified by the first evaluation after it
+    ASSERT_FALSE(plugin_eval(filter, lost));
+    clock.advanceMs(60 * 60 * 1000 - 1);
+    ASSERT_FALSE(plugin_eval(filter, other));
+    clock.advanceMs(1);
+    ASSERT_TRUE(plugin_eval(filter, other));
+    rapidjson::Document d;
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_FALSE(d.HasParseError());
+    ASSERT_STREQ(d["reason"].GetString(), "not connected");
+    // 25 hours after the start of the virtual clock
+    ASSERT_STREQ(d["at"].GetString(), "2020-01-02 01:00:00.000000+00:00");
+}
+
+TEST_F(TestSystemSp, AggregationWindowExpired)
+{
+    std::string customConfig = QUOTE({
+        "asset": {
+            "value": ""
+        },
+        "aggregation_window": {
+            "value": "500"
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "LINK-1", "protocol": "IEC104"},
+                    {"asset": "LINK-2", "protocol": "IEC104"}
+                ]
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+    filter->setClock(&clock);
+    std::string lost = QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}});
+    std::string recovered = QUOTE({"LINK-1": {"south_event": {"gi_status": "finished"}}});
+    std::string otherRecovered = QUOTE({"LINK-2": {"south_event": {"gi_status": "finished"}}});
+    std::string other = QUOTE({"LINK-2": {"south_event": {"gi_status": "started"}}});
+    rapidjson::Document d;
+
+    // A recovery after the end of the window no longer cancels the loss, both are notified in order
+    ASSERT_FALSE(plugin_eval(filter, lost));
+    clock.advanceMs(10 * 60 * 1000);
+    ASSERT_TRUE(plugin_eval(filter, recovered));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_STREQ(d["reason"].GetString(), "not connected");
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-1");
+    ASSERT_TRUE(plugin_eval(filter, other));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_STREQ(d["reason"].GetString(), "finished");
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-1");
+    ASSERT_FALSE(plugin_eval(filter, other));
+    ASSERT_STREQ(plugin_reason(filter).c_str(), "");
+
+    // The losses of a window which is due are notified before a notification of another asset
+    ASSERT_FALSE(plugin_eval(filter, lost));
+    clock.advanceMs(600);
+    ASSERT_TRUE(plugin_eval(filter, otherRecovered));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_STREQ(d["reason"].GetString(), "not connected");
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-1");
+    ASSERT_TRUE(plugin_eval(filter, other));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_STREQ(d["reason"].GetString(), "finished");
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-2");
+    ASSERT_FALSE(plugin_eval(filter, other));
+
+    // A recovery within the window still cancels the loss
+    ASSERT_FALSE(plugin_eval(filter, lost));
+    clock.advanceMs(400);
+    ASSERT_FALSE(plugin_eval(filter, recovered));
+    clock.advanceMs(200);
+    ASSERT_FALSE(plugin_eval(filter, other));
+}
+
+TEST_F(TestSystemSp, AggregatedSiteOutage)
+{
+    std::string customConfig = QUOTE({
+        "asset": {
+            "value": ""
+        },
+        "aggregation_window": {
+            "value": "3600000"
+        },
+        "site_down_threshold": {
+            "value": "100"
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "LINK-1", "protocol": "IEC104"},
+                    {"asset": "LINK-2", "protocol": "IEC104"},
+                    {"asset": "LINK-3", "protocol": "IEC104"}
+                ]
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+    filter->setClock(&clock);
+
+    // The loss of the last tracked asset closes the window, no other reading is needed
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}})));
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-3": {"south_event": {"connx_status": "not connected"}}})));
+    clock.advanceMs(1000);
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-2": {"south_event": {"connx_status": "not connected"}}})));
+    rapidjson::Document d;
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_FALSE(d.HasParseError());
+    ASSERT_EQ(d["assets"].GetArray().Size(), 3);
+    ASSERT_STREQ(d["assets"][2].GetString(), "LINK-2");
+    ASSERT_TRUE(d["site_down"].GetBool());
+
+    // The recoveries are notified by their own readings
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"gi_status": "finished"}}})));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_STREQ(d["reason"].GetString(), "finished");
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-1");
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"gi_status": "started"}}})));
+}
+
+TEST_F(TestSystemSp, TopologyPropagation)
+{
+    std::string customConfig = QUOTE({
+        "asset": {
+            "value": "CONNECTION-1"
+        },
+        "exchanged_data": {
+            "value": {
+                "exchanged_data": {
+                    "datapoints": [
+                        {
+                            "label":"TS-1",
+                            "pivot_id":"ID-1",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1001"}]
+                        },
+                        {
+                            "label":"TS-2",
+                            "pivot_id":"ID-2",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"2001"}]
+                        }
+                    ]
+                }
+            }
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "GATEWAY", "protocol": "IEC104", "address_ranges": [{"from": 9000, "to": 9999}]},
+                    {"asset": "LINK-1", "protocol": "IEC104", "address_ranges": [{"from": 1000, "to": 1999}]},
+                    {"asset": "LINK-2", "protocol": "IEC104", "address_ranges": [{"from": 2000, "to": 2999}]}
+                ]
+            }
+        },
+        "topology": {
+            "value": {
+                "topology": [
+                    {"parent": "GATEWAY", "children": ["LINK-1", "LINK-2"]}
+                ]
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+
+    // The loss of the parent covers the datapoints of its children
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"GATEWAY": {"south_event": {"connx_status": "not connected"}}})));
+    std::string jsonNotification = plugin_reason(filter);
+    validateNotification(jsonNotification, {
+        {"asset", "connx_status"},
+        {"reason", "not connected"}
+    });
+    if(HasFatalFailure()) return;
+    rapidjson::Document d;
+    d.Parse(jsonNotification.c_str());
+    ASSERT_STREQ(d["connection"].GetString(), "GATEWAY");
+    ASSERT_EQ(d["implied_assets"].GetArray().Size(), 2);
+    ASSERT_STREQ(d["implied_assets"][0].GetString(), "LINK-1");
+    ASSERT_STREQ(d["implied_assets"][1].GetString(), "LINK-2");
+    ASSERT_EQ(d["pivot_ids"].GetArray().Size(), 2);
+    RuleSystemSp *rule = static_cast<RuleSystemSp *>(filter);
+    if (rule->getLinkState("LINK-1") != LinkState::Unknown) {
+        ASSERT_EQ(rule->getLinkState("LINK-1"), LinkState::NotConnected);
+    }
+
+    // The losses reported afterwards by the children are not notified again
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}})));
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"LINK-2": {"south_event": {"connx_status": "not connected"}}})));
+
+    // Until they recover
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"gi_status": "finished"}}})));
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"LINK-1": {"south_event": {"connx_status": "not connected"}}})));
+    d.Parse(plugin_reason(filter).c_str());
+    ASSERT_STREQ(d["connection"].GetString(), "LINK-1");
+    ASSERT_FALSE(d.HasMember("implied_assets"));
+}
+
+TEST_F(TestSystemSp, ReasonTemplate)
+{
+    std::string customConfig = R"({
+        "asset": {
+            "value": ""
+        },
+        "exchanged_data": {
+            "value": {
+                "exchanged_data": {
+                    "datapoints": [
+                        {
+                            "label":"TS-1",
+                            "pivot_id":"ID-\"1\"",
+                            "pivot_type":"SpsTyp",
+                            "pivot_subtypes": ["prt.inf"],
+                            "protocols":[{"name":"IEC104", "typeid":"M_SP_NA_1", "address":"1001"}]
+                        }
+                    ]
+                }
+            }
+        },
+        "connections": {
+            "value": {
+                "connections": [
+                    {"asset": "LINK \"A\"", "protocol": "IEC104"}
+                ]
+            }
+        },
+        "reason_template": {
+            "value": "{\"site\": \"SITE-1\", \"status\": \"<asset>\", \"link\": \"<fired_asset>\", \"at\": \"<timestamp>\", \"ids\": <pivot_ids>, \"site_down\": <site_down>}"
+        }
+    })";
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), customConfig));
+
+    ASSERT_TRUE(plugin_eval(filter, R"({"LINK \"A\"": {"south_event": {"connx_status": "not connected"}}})"));
+    std::string jsonNotification = plugin_reason(filter);
+    rapidjson::Document d;
+    d.Parse(jsonNotification.c_str());
+    ASSERT_FALSE(d.HasParseError()) << "JSON parse error in: " << jsonNotification;
+    ASSERT_FALSE(d.HasMember("reason"));
+    ASSERT_STREQ(d["site"].GetString(), "SITE-1");
+    ASSERT_STREQ(d["status"].GetString(), "connx_status");
+    ASSERT_STREQ(d["link"].GetString(), "LINK \"A\"");
+    ASSERT_EQ(strlen(d["at"].GetString()), strlen("2020-01-01 00:00:00.000000+00:00"));
+    ASSERT_EQ(d["ids"].GetArray().Size(), 1);
+    ASSERT_STREQ(d["ids"][0].GetString(), "ID-\"1\"");
+    ASSERT_FALSE(d["site_down"].GetBool());
+
+    // An empty template gives the default reason
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter),
+                                       R"({"reason_template": {"value": ""}})"));
+    ASSERT_TRUE(plugin_eval(filter, R"({"LINK \"A\"": {"south_event": {"gi_status": "finished"}}})"));
+    jsonNotification = plugin_reason(filter);
+    validateNotification(jsonNotification, {
+        {"asset", "gi_status"},
+        {"reason", "finished"}
+    });
+}
+
+TEST_F(TestSystemSp, OnDemandBackend)
+{
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter),
+                                       QUOTE({"json_backend": {"value": "ondemand"}, "eval_cache": {"value": "false"}})));
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"CONNECTION-1": {"data": [{"x": "}"}], "south_event": {"connx_status": "not connected"}}})));
+    validateNotification(plugin_reason(filter), {
+        {"asset", "connx_status"},
+        {"reason", "not connected"}
+    });
+    if(HasFatalFailure()) return;
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "started"}}})));
+    ASSERT_FALSE(plugin_eval(filter, "{\"CONNECTION-1\": {\"south_event\": {\"connx_status\": \"not connected\"}}"));
+    ASSERT_EQ(filter->getMetrics().getDecisionCount(EvalDecision::ParseError), 1);
+}
+
+TEST_F(TestSystemSp, PayloadLimits)
+{
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), QUOTE({
+        "max_payload_size": {"value": "200"}, "max_depth": {"value": "3"}, "max_members": {"value": "10"}
+    })));
+    ASSERT_TRUE(plugin_eval(filter, QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}}})));
+
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"CONNECTION-1": {"south_event": {"connx_status": ["not connected"]}}})));
+    std::string large = "{\"CONNECTION-1\": {\"south_event\": {\"connx_status\": \"not connected\"}}, \"padding\": \"" +
+                        std::string(200, 'x') + "\"}";
+    ASSERT_FALSE(plugin_eval(filter, large));
+    ASSERT_FALSE(plugin_eval(filter, QUOTE({"CONNECTION-1": {"south_event": {"connx_status": "not connected"}},
+                                            "other": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10]})));
+    ASSERT_EQ(filter->getMetrics().getDecisionCount(EvalDecision::PayloadRejected), 3);
+
+    // Limits removed
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), QUOTE({
+        "max_payload_size": {"value": "0"}, "max_depth": {"value": "0"}, "max_members": {"value": "0"}
+    })));
+    ASSERT_TRUE(plugin_eval(filter, large));
+}
@@ -0,0 +1,88 @@
+/*
+ * Dump the notification journal written by the systemspr rule
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Usage: systemspr_journal_dump [--fired] [--last N] [journal file]
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "notificationJournal.h"
+#include "toolsFormat.h"
+#include "utilityPivot.h"
+
+using namespace systemspr;
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--fired] [--last N] [journal file]\n", name);
+    fprintf(stderr, "  --fired   only print the evaluations that fired a notification\n");
+    fprintf(stderr, "  --last N  only print the N most recent records\n");
+    fprintf(stderr, "Default journal file: $FLEDGE_DATA/systemspr/journal.bin\n");
+}
+
+static const char *orDash(const char *value) {
+    return *value ? value : "-";
+}
+
+int main(int argc, char **argv) {
+    bool firedOnly = false;
+    uint64_t last = 0;
+    std::string path = UtilityPivot::getDataDir() + "/" + FILTER_NAME + "/journal.bin";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fired") == 0) {
+            firedOnly = true;
+        }
+        else if (strcmp(argv[i], "--last") == 0 && i + 1 < argc) {
+            last = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        }
+        else {
+            path = argv[i];
+        }
+    }
+
+    NotificationJournal journal;
+    if (!journal.open(path, 0, true)) {
+        fprintf(stderr, "Unable to read journal %s\n", path.c_str());
+        return 1;
+    }
+    const NotificationJournal::Header *header = journal.getHeader();
+    const NotificationJournal::AssetName *assets = journal.getAssets();
+    uint64_t end = header->writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > header->capacity ? end - header->capacity : 0;
+    if (last > 0 && end - begin > last) {
+        begin = end - last;
+    }
+
+    printf("# journal %s: %u records capacity, %" PRIu64 " records written\n", path.c_str(), header->capacity, end);
+    printf("# index\ttimestamp\tasset\tverdict\tconnx_status\tgi_status\tpayload_hash\tpayload_size\n");
+    uint64_t skipped = 0;
+    for (uint64_t index = begin; index < end; index++) {
+        NotificationJournal::Event event;
+        if (!journal.readEvent(index, event)) {
+            skipped++;
+            continue;
+        }
+        if (firedOnly && !event.verdict) {
+            continue;
+        }
+        const char *asset = event.assetId < header->assetCount ? assets[event.assetId].name : "?";
+        printf("%" PRIu64 "\t%s\t%s\t%s\t%s\t%s\t%016" PRIx64 "\t%u\n", event.index,
+               formatTimestamp(event.timestampNs).c_str(), asset, event.verdict ? "fired" : "ignored",
+               orDash(SouthEvent::toString(event.connxStatus)), orDash(SouthEvent::toString(event.giStatus)),
+               event.payloadHash, event.payloadSize);
+    }
+    if (skipped > 0) {
+        printf("# %" PRIu64 " records overwritten while reading\n", skipped);
+    }
+    return 0;
+}
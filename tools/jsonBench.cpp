@@ -0,0 +1,145 @@
+/*
+ * Benchmark of the JSON backends reading the south_event of a reading
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Usage: systemspr_json_bench [--size KB] [--iterations N] [--perf]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "payloadGuard.h"
+#include "perfCounters.h"
+#include "southEventReader.h"
+#include "structuralIndex.h"
+
+using namespace systemspr;
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--size KB] [--iterations N] [--perf]\n", name);
+    fprintf(stderr, "  --size KB        size of the generated reading (default 256)\n");
+    fprintf(stderr, "  --iterations N   readings evaluated by each backend (default 2000)\n");
+    fprintf(stderr, "  --perf           print the performance counters of each backend per reading\n");
+}
+
+/*
+ * Reading of a tracked asset with PIVOT datapoints before its south_event
+ */
+static std::string makeReading(size_t sizeKb) {
+    std::string reading = "{\"LINK-1\": {\"PIVOT\": [";
+    for (uint32_t i = 0; reading.size() < sizeKb * 1024; i++) {
+        char datapoint[512];
+        snprintf(datapoint, sizeof(datapoint),
+                 "%s{\"GTIS\": {\"Identifier\": \"M_2367_3_15_%u\", \"Cause\": {\"stVal\": 3}, "
+                 "\"SpsTyp\": {\"q\": {\"Validity\": \"good\", \"Source\": \"process\"}, \"stVal\": %s, "
+                 "\"t\": {\"SecondSinceEpoch\": %u, \"FractionOfSecond\": 9529458}}, "
+                 "\"Label\": \"TS \\\"%u\\\"\", \"ComingFrom\": \"iec104\"}}",
+                 i ? ", " : "", i, i % 2 ? "true" : "false", 1669714185 + i, i);
+        reading += datapoint;
+    }
+    reading += "], \"south_event\": {\"connx_status\": \"not connected\", \"gi_status\": \"idle\"}}}";
+    return reading;
+}
+
+template <typename ReadFn>
+static void run(const char *name, const std::string& reading, uint32_t iterations, const PerfCounters& counters,
+                PerfStats& stats, ReadFn read) {
+    EvalResult result = read();
+    if (result.decision != EvalDecision::FiredConnectionLost) {
+        fprintf(stderr, "%s: unexpected decision %s\n", name, EvalDecisionName::toString(result.decision));
+        exit(1);
+    }
+    auto start = std::chrono::steady_clock::now();
+    measure(counters, stats, [&]() {
+        for (uint32_t i = 0; i < iterations; i++) {
+            result = read();
+        }
+    });
+    if (stats.count > 0) {
+        stats.count = iterations;
+    }
+    double elapsedNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    double perReadingNs = elapsedNs / iterations;
+    printf("%-20s %12.0f ns/reading %10.1f MB/s\n", name, perReadingNs,
+           static_cast<double>(reading.size()) / perReadingNs * 1e3);
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizeKb = 256;
+    uint32_t iterations = 2000;
+    bool perf = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            sizeKb = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--perf") == 0) {
+            perf = true;
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (sizeKb == 0 || iterations == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::string reading = makeReading(sizeKb);
+    std::vector<std::string> trackedAssets = {"LINK-1"};
+    printf("Reading of %zu bytes, %u iterations\n", reading.size(), iterations);
+
+    // The counters are read around all the iterations of a backend, then divided by their number
+    PerfCounters counters;
+    if (perf) {
+        counters.open();
+    }
+    std::vector<std::pair<std::string, PerfStats>> stats;
+
+    // Default limits of the plugin configuration
+    PayloadGuard guard;
+    PayloadGuard::Limits limits;
+    limits.maxDepth = 64;
+    limits.maxMembers = 1000000;
+    guard.configure(limits);
+    stats.emplace_back("guard", PerfStats());
+    run("guard", reading, iterations, counters, stats.back().second, [&]() {
+        EvalResult result;
+        result.decision = guard.check(reading.data(), reading.size()) == PayloadGuard::Verdict::Accepted ?
+                          EvalDecision::FiredConnectionLost : EvalDecision::PayloadRejected;
+        return result;
+    });
+    stats.emplace_back("rapidjson", PerfStats());
+    run("rapidjson", reading, iterations, counters, stats.back().second, [&]() {
+        return SouthEventReader::readDom(reading.c_str(), trackedAssets);
+    });
+    for (StructuralIndex::Kernel kernel : {StructuralIndex::Kernel::Scalar, StructuralIndex::Kernel::Sse2,
+                                           StructuralIndex::Kernel::Avx2}) {
+        StructuralIndex index;
+        if (!index.setKernel(kernel)) {
+            continue;
+        }
+        std::string name = std::string("ondemand/") + StructuralIndex::getKernelName(kernel);
+        stats.emplace_back(name, PerfStats());
+        run(name.c_str(), reading, iterations, counters, stats.back().second, [&]() {
+            return SouthEventReader::readOnDemand(index, reading.data(), reading.size(), trackedAssets);
+        });
+    }
+    if (perf) {
+        printPerfHeader(counters);
+        for (const std::pair<std::string, PerfStats>& backend : stats) {
+            printPerfStats(backend.first.c_str(), counters, backend.second);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,237 @@
+#ifndef TOOLS_PERF_COUNTERS_H_
+#define TOOLS_PERF_COUNTERS_H_
+
+/*
+ * Performance counters of the calling thread for the tools
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/*
+ * Group of the counters of the calling thread, read with a single system call.
+ *
+ * The hardware counters only count user space. The software ones, such as the page faults and
+ * context switches which happen in the kernel, also count the kernel when perf_event_paranoid
+ * allows it.
+ *
+ * The counters which cannot be opened, such as the hardware ones in most virtual machines or
+ * with a restrictive perf_event_paranoid, are left out of the group and reported unavailable.
+ */
+class PerfCounters {
+public:
+    enum Event {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1dMisses,
+        LlcMisses,
+        TaskClock,          // ns
+        PageFaults,
+        ContextSwitches,
+        EventCount
+    };
+
+    struct Sample {
+        uint64_t values[EventCount];
+        uint64_t timeRunningNs;
+    };
+
+    ~PerfCounters() { close(); }
+
+    /*
+     * Open the counters of the calling thread
+     *
+     * @return false if none of them can be opened, getError tells why
+     */
+    bool open() {
+        close();
+        static const struct {
+            uint32_t type;
+            uint64_t config;
+        } events[EventCount] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        };
+        for (int event = 0; event < EventCount; event++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[event].type;
+            attr.config = events[event].config;
+            attr.exclude_kernel = attr.type == PERF_TYPE_SOFTWARE ? 0 : 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, 0));
+            if (fd < 0 && !attr.exclude_kernel) {
+                attr.exclude_kernel = 1;
+                fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, 0));
+            }
+            if (fd < 0) {
+                if (m_error.empty()) {
+                    m_error = std::string(getName(static_cast<Event>(event))) + ": " + strerror(errno);
+                }
+                continue;
+            }
+            if (m_leader < 0) {
+                m_leader = fd;
+            }
+            m_fds[event] = fd;
+            m_positions[event] = m_count++;
+        }
+        return m_leader >= 0;
+    }
+
+    void close() {
+        for (int event = 0; event < EventCount; event++) {
+            if (m_fds[event] >= 0) {
+                ::close(m_fds[event]);
+            }
+            m_fds[event] = -1;
+            m_positions[event] = -1;
+        }
+        m_leader = -1;
+        m_count = 0;
+        m_error.clear();
+    }
+
+    bool isOpen() const { return m_leader >= 0; }
+    bool has(Event event) const { return m_positions[event] >= 0; }
+    const std::string& getError() const { return m_error; }
+
+    bool read(Sample& sample) const {
+        // nr, time_running, then the values in the order the counters joined the group
+        uint64_t buffer[2 + EventCount];
+        ssize_t size = ::read(m_leader, buffer, sizeof(buffer));
+        if (size < static_cast<ssize_t>((2 + m_count) * sizeof(uint64_t))) {
+            return false;
+        }
+        sample.timeRunningNs = buffer[1];
+        for (int event = 0; event < EventCount; event++) {
+            sample.values[event] = m_positions[event] >= 0 ? buffer[2 + m_positions[event]] : 0;
+        }
+        return true;
+    }
+
+    static const char *getName(Event event) {
+        static const char *names[EventCount] = {
+            "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses", "task-clock-ns", "page-faults",
+            "ctx-switches"
+        };
+        return names[event];
+    }
+
+private:
+    int         m_fds[EventCount]{-1, -1, -1, -1, -1, -1, -1, -1};
+    int         m_positions[EventCount]{-1, -1, -1, -1, -1, -1, -1, -1};
+    int         m_leader{-1};
+    int         m_count{0};
+    std::string m_error;    // First counter which could not be opened
+};
+
+/*
+ * Counters accumulated over the calls of an operation
+ */
+struct PerfStats {
+    uint64_t count{0};
+    uint64_t unscheduled{0};    // Calls during which the group was not on the processor
+    uint64_t totals[PerfCounters::EventCount]{};
+
+    void add(const PerfCounters::Sample& before, const PerfCounters::Sample& after) {
+        if (after.timeRunningNs == before.timeRunningNs) {
+            unscheduled++;
+            return;
+        }
+        count++;
+        for (int event = 0; event < PerfCounters::EventCount; event++) {
+            totals[event] += after.values[event] - before.values[event];
+        }
+    }
+
+    void merge(const PerfStats& other) {
+        count += other.count;
+        unscheduled += other.unscheduled;
+        for (int event = 0; event < PerfCounters::EventCount; event++) {
+            totals[event] += other.totals[event];
+        }
+    }
+};
+
+/*
+ * Call a function between two readings of the counters, if they are open
+ */
+template <typename Fn>
+static void measure(const PerfCounters& counters, PerfStats& stats, Fn fn) {
+    PerfCounters::Sample before;
+    PerfCounters::Sample after;
+    if (!counters.isOpen() || !counters.read(before)) {
+        fn();
+        return;
+    }
+    fn();
+    if (counters.read(after)) {
+        stats.add(before, after);
+    }
+}
+
+static void printPerfHeader(const PerfCounters& counters) {
+    if (!counters.isOpen()) {
+        printf("Performance counters unavailable, %s\n", counters.getError().c_str());
+        return;
+    }
+    if (!counters.getError().empty()) {
+        printf("Some performance counters unavailable, %s\n", counters.getError().c_str());
+    }
+    printf("%-16s %10s", "per operation", "count");
+    for (int event = 0; event < PerfCounters::EventCount; event++) {
+        printf(" %13s", PerfCounters::getName(static_cast<PerfCounters::Event>(event)));
+    }
+    printf(" %6s\n", "IPC");
+}
+
+static void printPerfStats(const char *operation, const PerfCounters& counters, const PerfStats& stats) {
+    if (!counters.isOpen()) {
+        return;
+    }
+    printf("%-16s %10llu", operation, static_cast<unsigned long long>(stats.count));
+    for (int event = 0; event < PerfCounters::EventCount; event++) {
+        if (!counters.has(static_cast<PerfCounters::Event>(event)) || stats.count == 0) {
+            printf(" %13s", "n/a");
+        }
+        else {
+            printf(" %13.2f", static_cast<double>(stats.totals[event]) / static_cast<double>(stats.count));
+        }
+    }
+    if (counters.has(PerfCounters::Cycles) && counters.has(PerfCounters::Instructions) &&
+        stats.totals[PerfCounters::Cycles] > 0) {
+        printf(" %6.2f\n", static_cast<double>(stats.totals[PerfCounters::Instructions]) /
+                           static_cast<double>(stats.totals[PerfCounters::Cycles]));
+    }
+    else {
+        printf(" %6s\n", "n/a");
+    }
+    if (stats.unscheduled > 0) {
+        printf("%-16s %10llu calls not counted, the counters were multiplexed\n", "",
+               static_cast<unsigned long long>(stats.unscheduled));
+    }
+}
+
+#endif  // TOOLS_PERF_COUNTERS_H_
@@ -0,0 +1,263 @@
+/*
+ * Stand-in of the notification service driving the systemspr plugin through its exported entry points
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Usage: systemspr_harness [--threads N] [--rate N] [--duration S] [--asset NAME] [--readings FILE]
+ *                          [--config FILE] [--perf] <plugin library>
+ */
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perfCounters.h"
+#include "rulePlugin.h"
+
+struct Options {
+    uint32_t threads{1};
+    uint32_t rate{0};           // Evaluations per second of each thread, 0 as fast as possible
+    uint32_t durationS{10};
+    std::string asset{"CONNECTION-1"};
+    std::string readingsFile;
+    std::string configFile;
+    std::string library;
+    bool perf{false};
+};
+
+struct WorkerResult {
+    std::vector<uint64_t> latenciesNs;
+    uint64_t fired{0};
+    uint64_t reasonBytes{0};
+    PerfStats evalStats;
+    PerfStats reasonStats;
+};
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--threads N] [--rate N] [--duration S] [--asset NAME] [--readings FILE]\n"
+                    "       [--config FILE] [--perf] <plugin library>\n", name);
+    fprintf(stderr, "  --threads N      threads, each one driving its own rule instance (default 1)\n");
+    fprintf(stderr, "  --rate N         evaluations per second of each thread, 0 as fast as possible (default 0)\n");
+    fprintf(stderr, "  --duration S     duration of the run in seconds (default 10)\n");
+    fprintf(stderr, "  --asset NAME     asset of the generated readings (default CONNECTION-1)\n");
+    fprintf(stderr, "  --readings FILE  readings to evaluate in turn, one JSON document per line, instead of\n"
+                    "                   the generated ones\n");
+    fprintf(stderr, "  --config FILE    JSON of the configuration items given to plugin_reconfigure after\n"
+                    "                   plugin_init, as {\"item\": {\"value\": ...}}\n");
+    fprintf(stderr, "  --perf           read the performance counters around each call, which adds their reading\n"
+                    "                   to the latencies\n");
+}
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+}
+
+/*
+ * Cycle of south_events of the asset: connection lost, connection started, general interrogation finished
+ */
+static std::vector<std::string> makeReadings(const std::string& asset) {
+    static const char *southEvents[] = {
+        "{\"connx_status\": \"not connected\"}",
+        "{\"connx_status\": \"started\", \"gi_status\": \"idle\"}",
+        "{\"connx_status\": \"started\", \"gi_status\": \"finished\"}",
+    };
+    std::vector<std::string> readings;
+    for (const char *southEvent : southEvents) {
+        readings.push_back("{\"" + asset + "\": {\"south_event\": " + southEvent + "}}");
+    }
+    return readings;
+}
+
+/*
+ * Evaluations of a rule instance until the deadline, followed by the reason when the rule fires, as the
+ * notification service does. With a rate, the latency is measured from the scheduled time of the
+ * evaluation, so that a slow evaluation also accounts for the delay of the next ones.
+ */
+static void runWorker(const RulePlugin& plugin, PLUGIN_HANDLE handle, const std::vector<std::string>& readings,
+                      uint32_t rate, bool perf, std::chrono::steady_clock::time_point deadline, WorkerResult& result) {
+    // The counters only count the thread which opened them
+    PerfCounters counters;
+    if (perf) {
+        counters.open();
+    }
+    std::chrono::nanoseconds period(rate > 0 ? 1000000000ULL / rate : 0);
+    auto scheduled = std::chrono::steady_clock::now();
+    for (size_t i = 0;; i++) {
+        if (rate > 0) {
+            std::this_thread::sleep_until(scheduled);
+        }
+        auto start = rate > 0 ? scheduled : std::chrono::steady_clock::now();
+        if (start >= deadline) {
+            break;
+        }
+        bool fired = false;
+        measure(counters, result.evalStats, [&]() { fired = plugin.eval(handle, readings[i % readings.size()]); });
+        if (fired) {
+            result.fired++;
+            measure(counters, result.reasonStats, [&]() { result.reasonBytes += plugin.reason(handle).size(); });
+        }
+        result.latenciesNs.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+        scheduled += period;
+    }
+}
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+static bool parseArguments(int argc, char **argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && hasValue) {
+            options.rate = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+            options.durationS = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--asset") == 0 && hasValue) {
+            options.asset = argv[++i];
+        }
+        else if (strcmp(argv[i], "--readings") == 0 && hasValue) {
+            options.readingsFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--config") == 0 && hasValue) {
+            options.configFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--perf") == 0) {
+            options.perf = true;
+        }
+        else if (argv[i][0] != '-' && options.library.empty()) {
+            options.library = argv[i];
+        }
+        else {
+            return false;
+        }
+    }
+    return !options.library.empty() && options.threads > 0 && options.durationS > 0;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> readings;
+    if (options.readingsFile.empty()) {
+        readings = makeReadings(options.asset);
+    }
+    else {
+        std::ifstream file(options.readingsFile);
+        if (!file) {
+            fprintf(stderr, "Cannot open %s\n", options.readingsFile.c_str());
+            return 1;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) {
+                readings.push_back(line);
+            }
+        }
+        if (readings.empty()) {
+            fprintf(stderr, "No reading in %s\n", options.readingsFile.c_str());
+            return 1;
+        }
+    }
+    std::string newConfig;
+    if (!options.configFile.empty() && !readFile(options.configFile, newConfig)) {
+        return 1;
+    }
+
+    RulePlugin plugin;
+    if (!plugin.load(options.library)) {
+        return 1;
+    }
+    PLUGIN_INFORMATION *info = plugin.info();
+    printf("Plugin %s %s, %zu readings, %u threads, %s\n", info->name, info->version, readings.size(),
+           options.threads, options.rate > 0 ? (std::to_string(options.rate) + " evaluations/s each").c_str()
+                                             : "unpaced");
+
+    // One rule instance per thread, as for the notifications of a service
+    PerfCounters counters;
+    if (options.perf) {
+        counters.open();
+    }
+    PerfStats configStats;
+    std::vector<PLUGIN_HANDLE> handles;
+    for (uint32_t i = 0; i < options.threads; i++) {
+        measure(counters, configStats, [&]() { handles.push_back(plugin.createInstance(newConfig)); });
+    }
+
+    std::vector<WorkerResult> results(options.threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(options.durationS);
+    for (uint32_t i = 0; i < options.threads; i++) {
+        results[i].latenciesNs.reserve(options.rate > 0 ? static_cast<size_t>(options.rate) * options.durationS
+                                                        : 1 << 20);
+        workers.emplace_back(runWorker, std::cref(plugin), handles[i], std::cref(readings), options.rate,
+                             options.perf, deadline, std::ref(results[i]));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (PLUGIN_HANDLE handle : handles) {
+        plugin.shutdown(handle);
+    }
+    plugin.unload();
+
+    std::vector<uint64_t> latenciesNs;
+    uint64_t fired = 0;
+    uint64_t reasonBytes = 0;
+    PerfStats evalStats;
+    PerfStats reasonStats;
+    for (WorkerResult& result : results) {
+        evalStats.merge(result.evalStats);
+        reasonStats.merge(result.reasonStats);
+        latenciesNs.insert(latenciesNs.end(), result.latenciesNs.begin(), result.latenciesNs.end());
+        fired += result.fired;
+        reasonBytes += result.reasonBytes;
+    }
+    std::sort(latenciesNs.begin(), latenciesNs.end());
+    printf("Evaluations  %zu in %.2f s, %.0f/s\n", latenciesNs.size(), elapsedS,
+           static_cast<double>(latenciesNs.size()) / elapsedS);
+    printf("Fired        %" PRIu64 ", %" PRIu64 " bytes of reason\n", fired, reasonBytes);
+    printf("Latency (ns) p50 %" PRIu64 "  p99 %" PRIu64 "  p999 %" PRIu64 "  max %" PRIu64 "\n",
+           percentile(latenciesNs, 0.50), percentile(latenciesNs, 0.99), percentile(latenciesNs, 0.999),
+           latenciesNs.empty() ? 0 : latenciesNs.back());
+    if (options.perf) {
+        printPerfHeader(counters);
+        printPerfStats("config", counters, configStats);
+        printPerfStats("eval", counters, evalStats);
+        printPerfStats("reason", counters, reasonStats);
+    }
+    return 0;
+}
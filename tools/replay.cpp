@@ -0,0 +1,382 @@
+/*
+ * Replay of captured readings through one or two builds or configurations of the systemspr plugin
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Usage: systemspr_replay [--paced] [--speed X] [--config FILE] [--against LIB] [--against-config FILE]
+ *                         [--max-diffs N] [--perf] <plugin library> <capture>
+ *        systemspr_replay --generate flap|outage [--assets N] [--events N] [--interval MS] <capture>
+ *
+ * The replayed instances are given the time of the capture, so that the aggregation window and the timestamp
+ * of the reasons do not depend on the pace of the replay. A build of the plugin without plugin_set_clock keeps
+ * the clock of the system, and is only replayed with time-based options at the pace of the capture.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "captureFile.h"
+#include "perfCounters.h"
+#include "ruleClock.h"
+#include "rulePlugin.h"
+
+using namespace systemspr;
+
+struct Options {
+    bool paced{false};
+    double speed{1.0};
+    std::string configFile;
+    std::string againstLibrary;
+    std::string againstConfigFile;
+    uint32_t maxDiffs{10};
+    std::string generate;
+    uint32_t assets{10};
+    uint32_t events{1000};
+    uint32_t intervalMs{10};
+    bool perf{false};
+    std::vector<std::string> arguments;
+};
+
+/*
+ * Rule instance of one side of the replay
+ */
+struct Side {
+    std::string label;
+    RulePlugin plugin;
+    PLUGIN_HANDLE handle{nullptr};
+    std::vector<uint64_t> latenciesNs;
+    uint64_t fired{0};
+    bool lastFired{false};
+    std::string lastReason;
+    PerfStats configStats;
+    PerfStats evalStats;
+    PerfStats reasonStats;
+};
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--paced] [--speed X] [--config FILE] [--against LIB] [--against-config FILE]\n"
+                    "       [--max-diffs N] [--perf] <plugin library> <capture>\n", name);
+    fprintf(stderr, "       %s --generate flap|outage [--assets N] [--events N] [--interval MS] <capture>\n", name);
+    fprintf(stderr, "  --paced               replay at the pace of the capture instead of as fast as possible, the\n"
+                    "                        evaluations are given the time of the capture either way\n");
+    fprintf(stderr, "  --speed X             with --paced, replay X times faster than the capture (default 1)\n");
+    fprintf(stderr, "  --config FILE         configuration items given to plugin_reconfigure, as {\"item\": {\"value\": ...}}\n");
+    fprintf(stderr, "  --against LIB         plugin library compared with the first one (default the same library)\n");
+    fprintf(stderr, "  --against-config FILE configuration items of the compared instance (default --config)\n");
+    fprintf(stderr, "  --max-diffs N         verdict differences printed (default 10)\n");
+    fprintf(stderr, "  --perf                read the performance counters around each call, which adds their\n"
+                    "                        reading to the evaluation times\n");
+    fprintf(stderr, "  --generate TYPE       write a synthetic capture: flap, the assets in turn lose and recover their\n"
+                    "                        connection, or outage, all the assets lose their connection then recover\n");
+    fprintf(stderr, "  --assets N            assets CONNECTION-1 to CONNECTION-N of the generated capture (default 10)\n");
+    fprintf(stderr, "  --events N            flaps or outages generated (default 1000)\n");
+    fprintf(stderr, "  --interval MS         delay between two generated readings (default 10)\n");
+}
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+}
+
+static bool parseArguments(int argc, char **argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--paced") == 0) {
+            options.paced = true;
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && hasValue) {
+            options.speed = strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(argv[i], "--config") == 0 && hasValue) {
+            options.configFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--against") == 0 && hasValue) {
+            options.againstLibrary = argv[++i];
+        }
+        else if (strcmp(argv[i], "--against-config") == 0 && hasValue) {
+            options.againstConfigFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-diffs") == 0 && hasValue) {
+            options.maxDiffs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--perf") == 0) {
+            options.perf = true;
+        }
+        else if (strcmp(argv[i], "--generate") == 0 && hasValue) {
+            options.generate = argv[++i];
+        }
+        else if (strcmp(argv[i], "--assets") == 0 && hasValue) {
+            options.assets = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--events") == 0 && hasValue) {
+            options.events = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--interval") == 0 && hasValue) {
+            options.intervalMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argv[i][0] != '-') {
+            options.arguments.push_back(argv[i]);
+        }
+        else {
+            return false;
+        }
+    }
+    if (!options.generate.empty()) {
+        return options.arguments.size() == 1 && options.assets > 0 &&
+               (options.generate == "flap" || options.generate == "outage");
+    }
+    return options.arguments.size() == 2 && options.speed > 0;
+}
+
+/*
+ * Whether the configuration items enable an option depending on the time of the evaluations: the aggregation
+ * window, or the timestamp in the reason template
+ */
+static bool usesTime(const std::string& config) {
+    rapidjson::Document doc;
+    doc.Parse(config.c_str());
+    if (config.empty() || doc.HasParseError() || !doc.IsObject()) {
+        return false;
+    }
+    auto item = [&doc](const char *name) -> std::string {
+        auto member = doc.FindMember(name);
+        if (member == doc.MemberEnd() || !member->value.IsObject()) {
+            return "";
+        }
+        auto value = member->value.FindMember("value");
+        return value != member->value.MemberEnd() && value->value.IsString() ? value->value.GetString() : "";
+    };
+    std::string window = item("aggregation_window");
+    return (!window.empty() && strtoul(window.c_str(), nullptr, 10) != 0) ||
+           item("reason_template").find("<timestamp>") != std::string::npos;
+}
+
+static std::string makeReading(uint32_t asset, bool lost) {
+    return "{\"CONNECTION-" + std::to_string(asset + 1) + "\": {\"south_event\": " +
+           (lost ? "{\"connx_status\": \"not connected\"}" : "{\"connx_status\": \"started\", \"gi_status\": \"finished\"}") +
+           "}}";
+}
+
+/*
+ * Synthetic capture: each flap is a loss followed by a recovery of the next asset, each outage is the loss
+ * of all the assets followed by their recovery
+ */
+static int generate(const Options& options) {
+    const std::string& path = options.arguments[0];
+    gzFile file = gzopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "Cannot create %s\n", path.c_str());
+        return 1;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t timestampNs = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+    uint64_t intervalNs = static_cast<uint64_t>(options.intervalMs) * 1000000ULL;
+    uint64_t records = 0;
+    std::string lines;
+    auto add = [&](uint32_t asset, bool lost) {
+        CaptureWriter::formatLine(lines, timestampNs, makeReading(asset, lost));
+        timestampNs += intervalNs;
+        records++;
+    };
+    for (uint32_t event = 0; event < options.events; event++) {
+        if (options.generate == "flap") {
+            add(event % options.assets, true);
+            add(event % options.assets, false);
+        }
+        else {
+            for (uint32_t asset = 0; asset < options.assets; asset++) {
+                add(asset, true);
+            }
+            for (uint32_t asset = 0; asset < options.assets; asset++) {
+                add(asset, false);
+            }
+        }
+        if (lines.size() >= 1024 * 1024 || event + 1 == options.events) {
+            gzwrite(file, lines.data(), static_cast<unsigned>(lines.size()));
+            lines.clear();
+        }
+    }
+    if (gzclose(file) != Z_OK) {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return 1;
+    }
+    printf("%" PRIu64 " readings of %u assets written to %s\n", records, options.assets, path.c_str());
+    return 0;
+}
+
+static void evaluate(Side& side, const std::string& reading, const PerfCounters& counters) {
+    auto start = std::chrono::steady_clock::now();
+    measure(counters, side.evalStats, [&]() { side.lastFired = side.plugin.eval(side.handle, reading); });
+    if (side.lastFired) {
+        side.fired++;
+        measure(counters, side.reasonStats, [&]() { side.lastReason = side.plugin.reason(side.handle); });
+    }
+    else {
+        side.lastReason.clear();
+    }
+    side.latenciesNs.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count()));
+}
+
+static void printTimings(Side& side) {
+    std::vector<uint64_t>& latencies = side.latenciesNs;
+    std::sort(latencies.begin(), latencies.end());
+    uint64_t totalNs = 0;
+    for (uint64_t latency : latencies) {
+        totalNs += latency;
+    }
+    auto at = [&latencies](double fraction) {
+        return latencies.empty() ? 0 : latencies[static_cast<size_t>(fraction * static_cast<double>(latencies.size() - 1))];
+    };
+    printf("%-8s fired %" PRIu64 ", total %.3f ms, p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+           side.label.c_str(), side.fired, static_cast<double>(totalNs) / 1e6, at(0.5), at(0.99), at(1.0));
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!options.generate.empty()) {
+        return generate(options);
+    }
+
+    std::string config;
+    std::string againstConfig;
+    if ((!options.configFile.empty() && !readFile(options.configFile, config)) ||
+        (!options.againstConfigFile.empty() && !readFile(options.againstConfigFile, againstConfig))) {
+        return 1;
+    }
+    bool compare = !options.againstLibrary.empty() || !options.againstConfigFile.empty();
+
+    PerfCounters counters;
+    if (options.perf) {
+        counters.open();
+    }
+    std::vector<Side> sides(compare ? 2 : 1);
+    std::vector<const std::string *> sideConfigs{&config, againstConfig.empty() ? &config : &againstConfig};
+    sides[0].label = "replayed";
+    if (!sides[0].plugin.load(options.arguments[0])) {
+        return 1;
+    }
+    measure(counters, sides[0].configStats, [&]() { sides[0].handle = sides[0].plugin.createInstance(config); });
+    if (compare) {
+        sides[0].label = "base";
+        sides[1].label = "against";
+        if (!sides[1].plugin.load(options.againstLibrary.empty() ? options.arguments[0] : options.againstLibrary)) {
+            return 1;
+        }
+        const std::string& sideConfig = options.againstConfigFile.empty() ? config : againstConfig;
+        measure(counters, sides[1].configStats, [&]() { sides[1].handle = sides[1].plugin.createInstance(sideConfig); });
+    }
+    for (size_t i = 0; i < sides.size(); i++) {
+        if (sides[i].plugin.setClock != nullptr || !usesTime(*sideConfigs[i])) {
+            continue;
+        }
+        if (!options.paced || options.speed != 1.0) {
+            fprintf(stderr, "The %s library does not take the time of the capture, replay it with --paced and without"
+                            " --speed or without the aggregation window and the <timestamp> of the reason\n",
+                    sides[i].label.c_str());
+            return 1;
+        }
+        fprintf(stderr, "The %s library does not take the time of the capture, its evaluations get the time of the"
+                        " replay\n", sides[i].label.c_str());
+    }
+
+    CaptureReader reader;
+    if (!reader.open(options.arguments[1])) {
+        fprintf(stderr, "Cannot open %s\n", options.arguments[1].c_str());
+        return 1;
+    }
+    CaptureReader::Record record;
+    uint64_t readings = 0;
+    uint64_t diffs = 0;
+    uint64_t firstTimestampNs = 0;
+    uint64_t clockNs = 0;
+    std::unique_ptr<VirtualClock> clock;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.next(record)) {
+        if (readings == 0) {
+            firstTimestampNs = record.timestampNs;
+            clockNs = record.timestampNs;
+            clock.reset(new VirtualClock(record.timestampNs));
+            for (Side& side : sides) {
+                if (side.plugin.setClock != nullptr) {
+                    side.plugin.setClock(side.handle, clock.get());
+                }
+            }
+        }
+        // Readings captured out of order keep the time of the previous one
+        if (record.timestampNs > clockNs) {
+            clock->advance(record.timestampNs - clockNs);
+            clockNs = record.timestampNs;
+        }
+        if (options.paced && record.timestampNs > firstTimestampNs) {
+            double offsetNs = static_cast<double>(record.timestampNs - firstTimestampNs) / options.speed;
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<int64_t>(offsetNs)));
+        }
+        for (Side& side : sides) {
+            evaluate(side, record.reading, counters);
+        }
+        if (compare && (sides[0].lastFired != sides[1].lastFired || sides[0].lastReason != sides[1].lastReason)) {
+            if (diffs < options.maxDiffs) {
+                printf("Difference at line %" PRIu64 ", ts %" PRIu64 ": %s\n", reader.getLineNumber(),
+                       record.timestampNs, record.reading.c_str());
+                for (const Side& side : sides) {
+                    printf("  %-8s %s %s\n", side.label.c_str(), side.lastFired ? "fired" : "not fired",
+                           side.lastReason.c_str());
+                }
+            }
+            diffs++;
+        }
+        readings++;
+    }
+    double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Replayed %" PRIu64 " readings in %.3f s\n", readings, elapsedS);
+    for (Side& side : sides) {
+        printTimings(side);
+    }
+    if (compare) {
+        printf("Differences %" PRIu64 "\n", diffs);
+    }
+    if (options.perf) {
+        printPerfHeader(counters);
+        for (const Side& side : sides) {
+            printPerfStats((side.label + " config").c_str(), counters, side.configStats);
+            printPerfStats((side.label + " eval").c_str(), counters, side.evalStats);
+            printPerfStats((side.label + " reason").c_str(), counters, side.reasonStats);
+        }
+    }
+    for (Side& side : sides) {
+        if (side.plugin.setClock != nullptr) {
+            side.plugin.setClock(side.handle, nullptr);
+        }
+        side.plugin.shutdown(side.handle);
+        side.plugin.unload();
+    }
+    return compare && diffs > 0 ? 2 : 0;
+}
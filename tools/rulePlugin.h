@@ -0,0 +1,85 @@
+#ifndef TOOLS_RULE_PLUGIN_H_
+#define TOOLS_RULE_PLUGIN_H_
+
+/*
+ * Loading of a notification rule plugin library by the tools
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <dlfcn.h>
+
+#include <cstdio>
+#include <string>
+
+#include <config_category.h>
+#include <plugin_api.h>
+
+#include "ruleClock.h"
+
+/*
+ * Entry points of a notification rule plugin, as resolved by the notification service: reconfigure and
+ * shutdown are given the handle itself, whatever their declaration in the plugin. setClock is only
+ * exported by the builds of the plugin configured with EXPORT_SET_CLOCK, it is null otherwise
+ */
+struct RulePlugin {
+    PLUGIN_INFORMATION *(*info)();
+    PLUGIN_HANDLE (*init)(ConfigCategory *config);
+    void (*reconfigure)(PLUGIN_HANDLE handle, const std::string& newConfig);
+    bool (*eval)(PLUGIN_HANDLE handle, const std::string& assetValues);
+    std::string (*reason)(PLUGIN_HANDLE handle);
+    void (*shutdown)(PLUGIN_HANDLE handle);
+    void (*setClock)(PLUGIN_HANDLE handle, const systemspr::RuleClock *clock){nullptr};
+    void *library{nullptr};
+
+    template <typename Fn>
+    bool resolve(const char *symbol, Fn& fn) {
+        fn = reinterpret_cast<Fn>(dlsym(library, symbol));
+        if (fn == nullptr) {
+            fprintf(stderr, "Symbol %s not found: %s\n", symbol, dlerror());
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& path) {
+        library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) {
+            fprintf(stderr, "Cannot load %s: %s\n", path.c_str(), dlerror());
+            return false;
+        }
+        if (!resolve("plugin_info", info) || !resolve("plugin_init", init) ||
+            !resolve("plugin_reconfigure", reconfigure) || !resolve("plugin_eval", eval) ||
+            !resolve("plugin_reason", reason) || !resolve("plugin_shutdown", shutdown)) {
+            unload();
+            return false;
+        }
+        setClock = reinterpret_cast<void (*)(PLUGIN_HANDLE, const systemspr::RuleClock *)>(
+            dlsym(library, "plugin_set_clock"));
+        return true;
+    }
+
+    void unload() {
+        if (library != nullptr) {
+            dlclose(library);
+            library = nullptr;
+        }
+    }
+
+    /*
+     * Rule instance with the default configuration, then the items of newConfig if not empty
+     */
+    PLUGIN_HANDLE createInstance(const std::string& newConfig) {
+        ConfigCategory config("systemspr", info()->config);
+        config.setItemsValueFromDefault();
+        PLUGIN_HANDLE handle = init(&config);
+        if (!newConfig.empty()) {
+            reconfigure(handle, newConfig);
+        }
+        return handle;
+    }
+};
+
+#endif  // TOOLS_RULE_PLUGIN_H_
@@ -0,0 +1,104 @@
+/*
+ * Print the connection states published in shared memory by the systemspr rule
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Usage: systemspr_state_watch [--follow] [--asset NAME] <shared memory name>
+ */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sharedStateTable.h"
+#include "toolsFormat.h"
+
+using namespace systemspr;
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--follow] [--asset NAME] <shared memory name>\n", name);
+    fprintf(stderr, "  --follow      wait for changes and print the updated states\n");
+    fprintf(stderr, "  --asset NAME  only print the state of this asset\n");
+}
+
+static const char *toString(LinkState state) {
+    switch (state) {
+        case LinkState::Connected:    return "connected";
+        case LinkState::NotConnected: return "not connected";
+        default:                      return "unknown";
+    }
+}
+
+static const char *orDash(const char *value) {
+    return *value ? value : "-";
+}
+
+static void printState(const SharedStateTable::State& state) {
+    printf("%s\t%s\t%s\t%s\t%u\t%s\n", state.asset.c_str(), toString(state.linkState),
+           orDash(SouthEvent::toString(state.connxStatus)), orDash(SouthEvent::toString(state.giStatus)),
+           state.lossCount, state.updatedNs != 0 ? formatTimestamp(state.updatedNs).c_str() : "-");
+    fflush(stdout);
+}
+
+/*
+ * Copy of the published states, the sequence of each entry tells which ones changed
+ */
+static void printStates(const SharedStateTable& table, const std::string& asset, std::vector<uint32_t>& sequences,
+                        bool changedOnly) {
+    const SharedStateTable::Entry *entries = table.getEntries();
+    for (uint32_t i = 0; i < SharedStateTable::Capacity; i++) {
+        uint32_t sequence = entries[i].sequence.load(std::memory_order_acquire);
+        if (changedOnly && sequence == sequences[i]) {
+            continue;
+        }
+        SharedStateTable::State state;
+        if (!SharedStateTable::read(entries[i], state) || (!asset.empty() && state.asset != asset)) {
+            continue;
+        }
+        sequences[i] = sequence;
+        printState(state);
+    }
+}
+
+int main(int argc, char **argv) {
+    bool follow = false;
+    std::string asset;
+    std::string name;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--follow") == 0) {
+            follow = true;
+        }
+        else if (strcmp(argv[i], "--asset") == 0 && i + 1 < argc) {
+            asset = argv[++i];
+        }
+        else if (argv[i][0] == '-' || !name.empty()) {
+            usage(argv[0]);
+            return 1;
+        }
+        else {
+            name = argv[i][0] == '/' ? argv[i] : std::string("/") + argv[i];
+        }
+    }
+    if (name.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    SharedStateTable table;
+    if (!table.open(name, true)) {
+        fprintf(stderr, "Unable to read shared state %s\n", name.c_str());
+        return 1;
+    }
+    printf("# asset\tlink_state\tconnx_status\tgi_status\tloss_count\tupdated\n");
+    std::vector<uint32_t> sequences(SharedStateTable::Capacity, 0);
+    uint32_t changes = table.getChanges();
+    printStates(table, asset, sequences, false);
+    while (follow) {
+        table.waitForChange(changes, -1);
+        changes = table.getChanges();
+        printStates(table, asset, sequences, true);
+    }
+    return 0;
+}
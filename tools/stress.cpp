@@ -0,0 +1,530 @@
+/*
+ * Stress of a single systemspr rule instance by concurrent evaluations, reasons, triggers and reconfigurations
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Usage: systemspr_stress [--threads N] [--reconfigure-threads N] [--reader-threads N] [--duration S]
+ *                         [--configs N] [--reconfigure-interval MS] [--seed N] [--paired]
+ */
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <config_category.h>
+#include <plugin_api.h>
+#include <rapidjson/document.h>
+
+#include "ruleSystemSp.h"
+
+using namespace systemspr;
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+};
+
+struct Options {
+    uint32_t threads{4};
+    uint32_t reconfigureThreads{2};
+    uint32_t readerThreads{1};
+    uint32_t durationS{10};
+    uint32_t configs{8};
+    uint32_t reconfigureIntervalMs{5};
+    uint64_t seed{1};
+    bool paired{false};
+};
+
+/*
+ * Configuration applied by the reconfigure threads. Every configuration sets all the items which
+ * differ between them, so the state of the rule does not depend on the configurations before.
+ */
+struct StressConfig {
+    std::string items;                      // JSON given to reconfigure
+    std::string triggers;                   // getTriggers of a rule with this configuration alone
+    std::vector<std::string> trackedAssets;
+    bool simple{true};                      // Without aggregation nor topology, a reading has a single verdict
+};
+
+/*
+ * Reading with the notification it fires when its asset is tracked by a simple configuration
+ */
+struct StressReading {
+    std::string json;
+    std::string asset;
+    const char *statusKey{nullptr};         // nullptr if the reading never fires
+    const char *statusValue{nullptr};
+};
+
+/*
+ * State shared by the threads
+ */
+struct Shared {
+    RuleSystemSp rule;
+    std::vector<StressConfig> configs;
+    std::vector<StressReading> readings;
+    std::set<std::string> allTriggers;
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> reconfiguring{0};             // Reconfigurations in progress
+    std::atomic<uint64_t> reconfigured{0};              // Reconfigurations done
+    std::vector<std::atomic<uint32_t>> lastApplied;     // Last configuration applied by each reconfigure thread
+    std::mutex deliveryMutex;                           // Evaluation and reason of one notification, with --paired
+    std::mutex violationMutex;
+    std::vector<std::string> violations;
+    std::atomic<uint64_t> violationCount{0};
+
+    explicit Shared(uint32_t reconfigureThreads) : lastApplied(reconfigureThreads) {}
+
+    void violation(const std::string& message) {
+        if (violationCount.fetch_add(1) < 10) {
+            std::lock_guard<std::mutex> guard(violationMutex);
+            violations.push_back(message);
+        }
+    }
+};
+
+/*
+ * Counters of a thread, on their own cache line
+ */
+struct alignas(64) ThreadCounters {
+    std::atomic<uint64_t> evaluations{0};
+    std::atomic<uint64_t> fired{0};
+    std::atomic<uint64_t> strictChecks{0};
+    std::vector<uint64_t> reconfigureNs;
+};
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--threads N] [--reconfigure-threads N] [--reader-threads N] [--duration S]\n"
+                    "       [--configs N] [--reconfigure-interval MS] [--seed N] [--paired]\n", name);
+    fprintf(stderr, "  --threads N                 threads evaluating readings (default 4)\n");
+    fprintf(stderr, "  --reconfigure-threads N     threads applying random configurations (default 2)\n");
+    fprintf(stderr, "  --reader-threads N          threads reading the triggers and link states (default 1)\n");
+    fprintf(stderr, "  --duration S                duration of the run in seconds (default 10)\n");
+    fprintf(stderr, "  --configs N                 random configurations generated (default 8)\n");
+    fprintf(stderr, "  --reconfigure-interval MS   pause of each reconfigure thread between two\n"
+                    "                              reconfigurations (default 5)\n");
+    fprintf(stderr, "  --seed N                    seed of the configurations and readings (default 1)\n");
+    fprintf(stderr, "  --paired                    evaluate and get the reason of a notification under one lock,\n"
+                    "                              as the notification service does, and check the reason exactly\n");
+}
+
+static bool parseArguments(int argc, char **argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--reconfigure-threads") == 0 && hasValue) {
+            options.reconfigureThreads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--reader-threads") == 0 && hasValue) {
+            options.readerThreads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+            options.durationS = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--configs") == 0 && hasValue) {
+            options.configs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--reconfigure-interval") == 0 && hasValue) {
+            options.reconfigureIntervalMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--paired") == 0) {
+            options.paired = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return options.threads > 0 && options.durationS > 0 && options.configs > 0;
+}
+
+static const char *const Links[] = {"LINK-1", "LINK-2", "LINK-3", "LINK-4", "LINK-5", "LINK-6"};
+
+/*
+ * Random configurations: tracked asset, connections, topology, aggregation, JSON backend, evaluation
+ * cache, payload limits, exchanged_data and capture of the readings
+ */
+static std::vector<StressConfig> makeConfigs(uint32_t count, std::mt19937_64& random, const std::string& captureDir) {
+    static const char *const exchangedData[] = {
+        R"({"exchanged_data": {"datapoints": [
+            {"label": "TS-1", "pivot_id": "ID-1", "pivot_type": "SpsTyp", "pivot_subtypes": ["prt.inf"],
+             "protocols": [{"name": "IEC104", "typeid": "M_SP_NA_1", "address": "1001"}]},
+            {"label": "TS-2", "pivot_id": "ID-2", "pivot_type": "DpsTyp", "pivot_subtypes": ["prt.inf"],
+             "protocols": [{"name": "IEC104", "typeid": "M_DP_NA_1", "address": "2001"}]}]}})",
+        R"({"exchanged_data": {"datapoints": [
+            {"label": "TS-1", "pivot_id": "ID-1", "pivot_type": "SpsTyp", "pivot_subtypes": ["prt.inf"],
+             "protocols": [{"name": "IEC104", "typeid": "M_SP_NA_1", "address": "1001"}]},
+            {"label": "TS-3", "pivot_id": "ID-3", "pivot_type": "SpsTyp", "pivot_subtypes": ["prt.inf", "acces"],
+             "protocols": [{"name": "IEC104", "typeid": "M_SP_NA_1", "address": "3001"}]},
+            {"label": "TS-4", "pivot_id": "ID-4", "pivot_type": "SpsTyp", "pivot_subtypes": ["acces"],
+             "protocols": [{"name": "IEC104", "typeid": "M_SP_NA_1", "address": "4001"}]}]}})",
+    };
+    std::vector<StressConfig> configs(count);
+    for (uint32_t i = 0; i < count; i++) {
+        StressConfig& config = configs[i];
+        std::string connections;
+        std::string children;
+        for (const char *link : Links) {
+            if (random() % 2 == 0) {
+                continue;
+            }
+            connections += std::string(connections.empty() ? "" : ", ") + "{\"asset\": \"" + link +
+                           "\", \"protocol\": \"IEC104\"}";
+            children += std::string(children.empty() ? "" : ", ") + "\"" + link + "\"";
+        }
+        bool topology = random() % 4 == 0;
+        bool aggregation = random() % 4 == 0;
+        config.simple = !topology && !aggregation;
+        if (topology) {
+            connections += std::string(connections.empty() ? "" : ", ") +
+                           "{\"asset\": \"GATEWAY\", \"protocol\": \"IEC104\"}";
+        }
+        std::string capture = random() % 4 == 0 ? captureDir + "/capture-" + std::to_string(i) + ".jsonl.gz" : "";
+        config.items = std::string("{") +
+            "\"asset\": {\"value\": \"" + (random() % 2 ? "CONNECTION-1" : "") + "\"}, " +
+            "\"connections\": {\"value\": {\"connections\": [" + connections + "]}}, " +
+            "\"topology\": {\"value\": {\"topology\": [" +
+                (topology ? "{\"parent\": \"GATEWAY\", \"children\": [" + children + "]}" : "") + "]}}, " +
+            "\"aggregation_window\": {\"value\": \"" + (aggregation ? "20" : "0") + "\"}, " +
+            "\"json_backend\": {\"value\": \"" + (random() % 2 ? "rapidjson" : "ondemand") + "\"}, " +
+            "\"eval_cache\": {\"value\": \"" + (random() % 2 ? "true" : "false") + "\"}, " +
+            "\"max_depth\": {\"value\": \"" + (random() % 2 ? "64" : "8") + "\"}, " +
+            "\"exchanged_data\": {\"value\": " + exchangedData[random() % 2] + "}, " +
+            "\"capture_file\": {\"value\": \"" + capture + "\"}}";
+    }
+    return configs;
+}
+
+/*
+ * South events of each asset, tracked or not, readings which never fire and invalid readings
+ */
+static std::vector<StressReading> makeReadings() {
+    std::vector<std::string> assets = {"CONNECTION-1", "GATEWAY", "OTHER"};
+    assets.insert(assets.end(), std::begin(Links), std::end(Links));
+    static const struct {
+        const char *southEvent;
+        const char *statusKey;
+        const char *statusValue;
+    } southEvents[] = {
+        {"{\"connx_status\": \"not connected\"}", "connx_status", "not connected"},
+        {"{\"connx_status\": \"started\", \"gi_status\": \"started\"}", nullptr, nullptr},
+        {"{\"connx_status\": \"started\", \"gi_status\": \"finished\"}", "gi_status", "finished"},
+        {"{}", nullptr, nullptr},
+    };
+    std::vector<StressReading> readings;
+    for (const std::string& asset : assets) {
+        for (const auto& southEvent : southEvents) {
+            StressReading reading;
+            reading.json = "{\"" + asset + "\": {\"south_event\": " + southEvent.southEvent + "}}";
+            reading.asset = asset;
+            reading.statusKey = southEvent.statusKey;
+            reading.statusValue = southEvent.statusValue;
+            readings.push_back(reading);
+        }
+        StressReading pivot;
+        pivot.json = "{\"" + asset + "\": {\"PIVOT\": {\"GTIS\": {\"SpsTyp\": {\"stVal\": true, "
+                     "\"q\": {\"Validity\": \"good\"}}, \"Cause\": {\"stVal\": 3}}}}}";
+        pivot.asset = asset;
+        readings.push_back(pivot);
+    }
+    for (const char *invalid : {"{42}", "[\"CONNECTION-1\"]", "{\"CONNECTION-1\": {\"south_event\": {"}) {
+        StressReading reading;
+        reading.json = invalid;
+        readings.push_back(reading);
+    }
+    return readings;
+}
+
+/*
+ * Check a reason against the notification fired by a reading. Without an expected reading, the reason
+ * must only be one of the notifications of the rule.
+ */
+static bool checkReason(const std::string& reason, const StressReading *expected, std::string& error) {
+    rapidjson::Document document;
+    if (document.Parse(reason.c_str()).HasParseError() || !document.IsObject() ||
+        !document.HasMember("asset") || !document["asset"].IsString() ||
+        !document.HasMember("reason") || !document["reason"].IsString()) {
+        error = "malformed reason " + reason;
+        return false;
+    }
+    std::string asset = document["asset"].GetString();
+    std::string value = document["reason"].GetString();
+    if (expected != nullptr) {
+        if (asset != expected->statusKey || value != expected->statusValue) {
+            error = "reason " + reason + " for " + expected->json;
+            return false;
+        }
+        return true;
+    }
+    if (!(asset == "connx_status" && value == "not connected") && !(asset == "gi_status" && value == "finished")) {
+        error = "torn reason " + reason;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Verdict of a reading if the rule has one of the configurations last applied by the reconfigure threads
+ *
+ * @return false if a configuration does not give a single verdict, or if they disagree
+ */
+static bool expectedVerdict(const Shared& shared, const std::vector<uint32_t>& candidates,
+                            const StressReading& reading, bool& fired) {
+    bool first = true;
+    for (uint32_t index : candidates) {
+        const StressConfig& config = shared.configs[index];
+        if (!config.simple) {
+            return false;
+        }
+        bool tracked = std::find(config.trackedAssets.begin(), config.trackedAssets.end(), reading.asset) !=
+                       config.trackedAssets.end();
+        bool verdict = tracked && reading.statusKey != nullptr;
+        if (!first && verdict != fired) {
+            return false;
+        }
+        fired = verdict;
+        first = false;
+    }
+    return !first;
+}
+
+/*
+ * Evaluations of random readings. The verdict is checked when no reconfiguration overlapped the
+ * evaluation, against the configurations last applied by each reconfigure thread, one of which is
+ * the configuration of the rule.
+ */
+static void runEvaluations(Shared& shared, bool paired, uint64_t seed, ThreadCounters& counters) {
+    std::mt19937_64 random(seed);
+    std::vector<uint32_t> candidates(shared.lastApplied.size());
+    std::string error;
+    while (!shared.stop.load(std::memory_order_relaxed)) {
+        const StressReading& reading = shared.readings[random() % shared.readings.size()];
+        std::unique_lock<std::mutex> delivery(shared.deliveryMutex, std::defer_lock);
+        if (paired) {
+            delivery.lock();
+        }
+        uint32_t reconfiguring = shared.reconfiguring.load();
+        uint64_t reconfigured = shared.reconfigured.load();
+        for (size_t i = 0; i < candidates.size(); i++) {
+            candidates[i] = shared.lastApplied[i].load();
+        }
+
+        bool fired = shared.rule.evalRule(reading.json);
+        std::string reason = fired ? shared.rule.getReason() : std::string();
+        bool stable = reconfiguring == 0 && shared.reconfiguring.load() == 0 &&
+                      shared.reconfigured.load() == reconfigured;
+        if (paired) {
+            delivery.unlock();
+        }
+
+        counters.evaluations.fetch_add(1, std::memory_order_relaxed);
+        bool expected = false;
+        if (stable && expectedVerdict(shared, candidates, reading, expected)) {
+            counters.strictChecks.fetch_add(1, std::memory_order_relaxed);
+            if (fired != expected) {
+                shared.violation(std::string(fired ? "fired" : "not fired") + " by " + reading.json);
+            }
+            else if (fired && paired && !checkReason(reason, &reading, error)) {
+                shared.violation(error);
+            }
+        }
+        if (fired) {
+            counters.fired.fetch_add(1, std::memory_order_relaxed);
+            // Without --paired another evaluation may reset the reason before it is read
+            if ((paired || !reason.empty()) && !checkReason(reason, nullptr, error)) {
+                shared.violation(error);
+            }
+        }
+    }
+}
+
+/*
+ * Random configurations applied in turn
+ */
+static void runReconfigurations(Shared& shared, uint32_t thread, uint32_t intervalMs, uint64_t seed,
+                                ThreadCounters& counters) {
+    std::mt19937_64 random(seed);
+    std::vector<ConfigCategory> categories;
+    for (const StressConfig& config : shared.configs) {
+        categories.emplace_back("stress", config.items);
+    }
+    while (!shared.stop.load(std::memory_order_relaxed)) {
+        uint32_t index = static_cast<uint32_t>(random() % shared.configs.size());
+        shared.reconfiguring.fetch_add(1);
+        auto start = std::chrono::steady_clock::now();
+        shared.rule.reconfigure(categories[index]);
+        counters.reconfigureNs.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+        shared.lastApplied[thread].store(index);
+        shared.reconfigured.fetch_add(1);
+        shared.reconfiguring.fetch_sub(1);
+        if (intervalMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        }
+    }
+}
+
+/*
+ * Triggers, which must be those of one of the configurations and never a mix of two, and link states
+ */
+static void runReaders(Shared& shared, uint64_t seed, ThreadCounters& counters) {
+    std::mt19937_64 random(seed);
+    while (!shared.stop.load(std::memory_order_relaxed)) {
+        std::string triggers = shared.rule.getTriggers();
+        if (shared.allTriggers.count(triggers) == 0) {
+            shared.violation("torn triggers " + triggers);
+        }
+        const StressReading& reading = shared.readings[random() % shared.readings.size()];
+        shared.rule.getLinkState(reading.asset);
+        shared.rule.getLinkState();
+        counters.evaluations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    char captureDir[] = "/tmp/systemspr_stressXXXXXX";
+    if (mkdtemp(captureDir) == nullptr) {
+        fprintf(stderr, "Cannot create a directory for the captures: %s\n", strerror(errno));
+        return 1;
+    }
+
+    Shared shared(std::max<uint32_t>(options.reconfigureThreads, 1));
+    std::mt19937_64 random(options.seed);
+    shared.configs = makeConfigs(options.configs, random, captureDir);
+    shared.readings = makeReadings();
+    uint32_t simple = 0;
+    for (StressConfig& config : shared.configs) {
+        RuleSystemSp rule;
+        ConfigCategory defaults("systemspr", plugin_info()->config);
+        defaults.setItemsValueFromDefault();
+        rule.reconfigure(defaults);
+        rule.reconfigure(ConfigCategory("stress", config.items));
+        config.triggers = rule.getTriggers();
+        config.trackedAssets = rule.getConfigPlugin().getTrackedAssets();
+        shared.allTriggers.insert(config.triggers);
+        simple += config.simple ? 1 : 0;
+    }
+
+    ConfigCategory defaults("systemspr", plugin_info()->config);
+    defaults.setItemsValueFromDefault();
+    shared.rule.reconfigure(defaults);
+    shared.rule.reconfigure(ConfigCategory("stress", shared.configs[0].items));
+    for (std::atomic<uint32_t>& applied : shared.lastApplied) {
+        applied.store(0);
+    }
+    printf("%u configurations (%u simple), %zu readings, %u evaluation, %u reconfigure and %u reader threads%s\n",
+           options.configs, simple, shared.readings.size(), options.threads, options.reconfigureThreads,
+           options.readerThreads, options.paired ? ", paired reasons" : "");
+
+    std::vector<ThreadCounters> evalCounters(options.threads);
+    std::vector<ThreadCounters> reconfigureCounters(options.reconfigureThreads);
+    std::vector<ThreadCounters> readerCounters(options.readerThreads);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < options.threads; i++) {
+        threads.emplace_back(runEvaluations, std::ref(shared), options.paired, options.seed * 1000 + i,
+                             std::ref(evalCounters[i]));
+    }
+    for (uint32_t i = 0; i < options.reconfigureThreads; i++) {
+        threads.emplace_back(runReconfigurations, std::ref(shared), i, options.reconfigureIntervalMs,
+                             options.seed * 2000 + i, std::ref(reconfigureCounters[i]));
+    }
+    for (uint32_t i = 0; i < options.readerThreads; i++) {
+        threads.emplace_back(runReaders, std::ref(shared), options.seed * 3000 + i, std::ref(readerCounters[i]));
+    }
+
+    // Throughput of each second, to see how it holds under the reconfigurations
+    auto evaluations = [&evalCounters]() {
+        uint64_t total = 0;
+        for (const ThreadCounters& counters : evalCounters) {
+            total += counters.evaluations.load(std::memory_order_relaxed);
+        }
+        return total;
+    };
+    std::vector<uint64_t> perSecond;
+    uint64_t previous = evaluations();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t second = 1; second <= options.durationS; second++) {
+        std::this_thread::sleep_until(start + std::chrono::seconds(second));
+        uint64_t current = evaluations();
+        perSecond.push_back(current - previous);
+        previous = current;
+    }
+    shared.stop.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t fired = 0;
+    uint64_t strictChecks = 0;
+    for (const ThreadCounters& counters : evalCounters) {
+        fired += counters.fired.load();
+        strictChecks += counters.strictChecks.load();
+    }
+    std::vector<uint64_t> reconfigureNs;
+    for (const ThreadCounters& counters : reconfigureCounters) {
+        reconfigureNs.insert(reconfigureNs.end(), counters.reconfigureNs.begin(), counters.reconfigureNs.end());
+    }
+    uint64_t reads = 0;
+    for (const ThreadCounters& counters : readerCounters) {
+        reads += counters.evaluations.load();
+    }
+    std::sort(perSecond.begin(), perSecond.end());
+    std::sort(reconfigureNs.begin(), reconfigureNs.end());
+    printf("Evaluations      %" PRIu64 " in %.2f s, %.0f/s, %" PRIu64 " fired, %" PRIu64 " verdicts checked\n",
+           previous, elapsedS, static_cast<double>(previous) / elapsedS, fired, strictChecks);
+    printf("Per second       min %" PRIu64 "  median %" PRIu64 "  max %" PRIu64 "\n", perSecond.front(),
+           percentile(perSecond, 0.5), perSecond.back());
+    printf("Reconfigurations %zu, latency (us) p50 %" PRIu64 "  p99 %" PRIu64 "  max %" PRIu64 "\n",
+           reconfigureNs.size(), percentile(reconfigureNs, 0.5) / 1000, percentile(reconfigureNs, 0.99) / 1000,
+           reconfigureNs.empty() ? 0 : reconfigureNs.back() / 1000);
+    printf("Triggers read    %" PRIu64 "\n", reads);
+
+    // The captures are closed with the rule
+    shared.rule.reconfigure(ConfigCategory("stress", R"({"capture_file": {"value": ""}})"));
+    for (uint32_t i = 0; i < options.configs; i++) {
+        unlink((std::string(captureDir) + "/capture-" + std::to_string(i) + ".jsonl.gz").c_str());
+    }
+    rmdir(captureDir);
+
+    uint64_t violations = shared.violationCount.load();
+    if (violations > 0) {
+        printf("%" PRIu64 " violations, the first ones:\n", violations);
+        for (const std::string& violation : shared.violations) {
+            printf("  %s\n", violation.c_str());
+        }
+        return 1;
+    }
+    printf("No violation\n");
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef TOOLS_TOOLS_FORMAT_H_
+#define TOOLS_TOOLS_FORMAT_H_
+
+/*
+ * Formatting of the values printed by the tools
+ *
+ * Copyright (c) 2020, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+/*
+ * ISO 8601 UTC time, to the microsecond, of a realtime in nanoseconds
+ */
+inline std::string formatTimestamp(uint64_t timestampNs) {
+    time_t seconds = static_cast<time_t>(timestampNs / 1000000000ULL);
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+    char buffer[64];
+    size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(buffer + length, sizeof(buffer) - length, ".%06" PRIu64 "Z",
+             static_cast<uint64_t>((timestampNs % 1000000000ULL) / 1000));
+    return buffer;
+}
+
+#endif  // TOOLS_TOOLS_FORMAT_H_